@@ -49,10 +49,87 @@ extern "C"
 struct _ffts_plan_t;
 typedef struct _ffts_plan_t ffts_plan_t;
 
+// Sizes of the form 2^k * 3^a * 5^b * 7^c use mixed-radix plans; any other
+// size that isn't a power of two falls back to Bluestein's algorithm.
 ffts_plan_t *ffts_init_1d(size_t N, int sign);
 ffts_plan_t *ffts_init_2d(size_t N1, size_t N2, int sign);
 ffts_plan_t *ffts_init_nd(int rank, size_t *Ns, int sign);
 
+// Threaded multi-dimensional transforms: the row transforms and transposes are
+// split across nthreads threads (including the caller), which are kept for the
+// lifetime of the plan. nthreads <= 0 uses one thread per online CPU. Without
+// pthreads these are the same as the serial plans.
+ffts_plan_t *ffts_init_2d_threaded(size_t N1, size_t N2, int sign, int nthreads);
+ffts_plan_t *ffts_init_nd_threaded(int rank, size_t *Ns, int sign, int nthreads);
+
+// Batched 1D transforms: a single execute call performs howmany transforms of
+// size N. Element i of transform k is read from input[k*idist + i*istride] and
+// written to output[k*odist + i*ostride]; strides and distances are counted in
+// complex elements.
+ffts_plan_t *ffts_init_1d_batch(size_t N, int sign, size_t howmany,
+                                size_t istride, size_t idist,
+                                size_t ostride, size_t odist);
+
+// A single 1D transform that reads input[i*istride] and writes
+// output[i*ostride] (in complex elements), e.g. one column of a matrix or one
+// channel of interleaved data.
+ffts_plan_t *ffts_init_1d_strided(size_t N, int sign, size_t istride, size_t ostride);
+
+// In-place transforms, for when a second full-size buffer doesn't fit: only
+// scratch space proportional to the side of the transform is used, and input
+// and output may be the same buffer. 1D sizes must be powers of two.
+ffts_plan_t *ffts_init_1d_inplace(size_t N, int sign);
+ffts_plan_t *ffts_init_2d_inplace(size_t N1, size_t N2, int sign);
+ffts_plan_t *ffts_init_nd_inplace(int rank, size_t *Ns, int sign);
+
+// Six-step 1D transforms of a power of two N (at least 64), done as two passes
+// of sqrt(N)-sized transforms. Planning takes well under a millisecond and
+// generates no code, where ffts_init_1d takes hundreds of milliseconds and
+// tens of megabytes of code from 2^22 up, but executing is slower (about 1.5
+// to 2 times on x86), so these are for sizes planned once and run a few times.
+ffts_plan_t *ffts_init_1d_sixstep(size_t N, int sign);
+
+// Split format transforms, with the real and imaginary parts in separate
+// arrays. Plans from ffts_init_1d_split take any size ffts_init_1d does and
+// are executed with ffts_execute_split; the arrays need no particular
+// alignment and the output may overwrite the input. ffts_execute and
+// ffts_execute_scratch reject them. The conversions use working memory kept
+// in the plan and there is no scratch variant, so a split plan can only be
+// used by one thread at a time.
+ffts_plan_t *ffts_init_1d_split(size_t N, int sign);
+void ffts_execute_split(ffts_plan_t *, const float *in_re, const float *in_im,
+                        float *out_re, float *out_im);
+
+// Pruned transforms, for zero-padded input or when only part of the spectrum
+// is wanted. Only the first nin (complex, or real) input elements are read, the
+// rest being taken as zero, and only the first nout outputs are written; 0
+// means all N. Sizes must be powers of two, at least 8 for ffts_init_1d_pruned
+// and at least 16 for ffts_init_1d_real_pruned; smaller sizes return NULL.
+// ffts_init_1d_real_pruned is a forwards transform with the usual N/2+1 outputs.
+ffts_plan_t *ffts_init_1d_pruned(size_t N, int sign, size_t nin, size_t nout);
+ffts_plan_t *ffts_init_1d_real_pruned(size_t N, size_t nin);
+
+// Streaming FIR filters. ffts_init_conv precomputes the spectra of ntaps
+// filter taps; ffts_execute_conv then filters n samples of a continuous
+// stream at a time, for any n, and ffts_execute filters exactly block samples.
+// The output lags the input by block samples (a power of two, at least 8)
+// regardless of the filter length, and in and out may be the same buffer.
+ffts_plan_t *ffts_init_conv(const float *taps, size_t ntaps, size_t block);
+void ffts_execute_conv(ffts_plan_t *, const float *in, float *out, size_t n);
+
+// Short-time Fourier transforms of a real stream, with frames of N samples
+// (a power of two) every hop samples, multiplied by window (N floats, or NULL
+// for none). With sign == -1, ffts_execute_stft takes n more samples and
+// writes every frame they complete, N/2+1 complex values each, returning the
+// number of frames (at most n/hop + 1). With sign == 1, ffts_execute_istft
+// takes nframes spectra and overlap-adds them, writing nframes*hop samples.
+// In both, frame f starts at frames + f*(N+4): the last two floats of each
+// frame are padding, so that every frame of an aligned buffer is aligned.
+// ffts_execute on these plans does a single windowed frame without state.
+ffts_plan_t *ffts_init_stft(size_t N, size_t hop, const float *window, int sign);
+size_t ffts_execute_stft(ffts_plan_t *, const float *in, size_t n, float *frames);
+size_t ffts_execute_istft(ffts_plan_t *, const float *frames, size_t nframes, float *out);
+
 // For real transforms, sign == -1 implies a real-to-complex forwards tranform,
 // and sign == 1 implies a complex-to-real backwards transform
 // The output of a real-to-complex transform is N/2+1 complex numbers, where the
@@ -61,9 +138,109 @@ ffts_plan_t *ffts_init_1d_real(size_t N, int sign);
 ffts_plan_t *ffts_init_2d_real(size_t N1, size_t N2, int sign);
 ffts_plan_t *ffts_init_nd_real(int rank, size_t *Ns, int sign);
 
+// Discrete cosine and sine transforms of N reals (N even, at least 4), done
+// with a real transform of size N. sign == -1 is the DCT-II (DST-II),
+// X[k] = 2 sum x[n] cos(pi (2n+1) k / 2N), and sign == 1 the DCT-III
+// (DST-III), its inverse scaled by 2N; neither is normalized. The 2D DCT is
+// over an N1 x N2 row-major array. ffts_init_2d_dct_blocks does nblocks
+// B x B blocks (B = 8 or 16) of B*B floats each, one after another.
+ffts_plan_t *ffts_init_1d_dct(size_t N, int sign);
+ffts_plan_t *ffts_init_1d_dst(size_t N, int sign);
+ffts_plan_t *ffts_init_2d_dct(size_t N1, size_t N2, int sign);
+ffts_plan_t *ffts_init_2d_dct_blocks(size_t B, int sign, size_t nblocks);
+
+// Double precision transforms. These take and produce interleaved complex
+// doubles (real transforms: N doubles in, N/2+1 complex out) and are executed
+// and freed like any other plan. Sizes must be powers of two.
+ffts_plan_t *ffts_init_1d_d(size_t N, int sign);
+ffts_plan_t *ffts_init_2d_d(size_t N1, size_t N2, int sign);
+ffts_plan_t *ffts_init_nd_d(int rank, size_t *Ns, int sign);
+ffts_plan_t *ffts_init_1d_real_d(size_t N, int sign);
+
 void ffts_execute(ffts_plan_t * , const void *input, void *output);
 void ffts_free(ffts_plan_t *);
 
+// Reentrant execution. ffts_execute writes to working memory kept in the
+// plan, so a plan can only be used by one thread at a time; ffts_execute_scratch
+// uses the ffts_scratch_size(p) bytes at scratch instead (64-byte aligned is
+// best) and leaves the plan untouched, so any number of threads may share one
+// plan, each with its own scratch. Threaded plans run on the calling thread
+// here, and the streaming conv and STFT plans, whose state is part of the plan,
+// have a scratch size of 0 and run as ffts_execute.
+size_t ffts_scratch_size(ffts_plan_t *);
+void ffts_execute_scratch(ffts_plan_t *, const void *input, void *output, void *scratch);
+
+// Kernel sets. Plans use the best one the host supports, chosen when the plan
+// is created; ffts_plan_isa() returns the one a plan ended up with.
+#define FFTS_ISA_SCALAR 0
+#define FFTS_ISA_SSE    1
+#define FFTS_ISA_AVX2   2
+#define FFTS_ISA_NEON   3
+#define FFTS_ISA_VFP    4
+
+int ffts_plan_isa(ffts_plan_t *);
+const char *ffts_isa_name(int isa);
+
+// Opt-in, process-wide plan cache. While it is enabled, 1D power-of-two plans
+// with the same size and sign share their twiddle factors, index tables and
+// generated code. Every ffts_init_* call still returns a separate plan that is
+// released with ffts_free. Cached entries that are no longer used by a plan
+// stay around until ffts_plan_cache_clear() or ffts_plan_cache_enable(0).
+void ffts_plan_cache_enable(int enable);
+void ffts_plan_cache_clear(void);
+
+// Wisdom: saved plans that are mapped back in rather than recomputed, for
+// fast startup. ffts_export_wisdom writes every plan in the plan cache to
+// path, and ffts_import_wisdom enables the cache and adds the plans saved in
+// path to it, so the ffts_init_* calls that need them (including those made
+// by real and multi-dimensional plans) find them ready. Both return the
+// number of plans, or -1 on error. ffts_export_plan and ffts_import_plan do
+// the same for a single 1D power-of-two plan. Files are tagged with the
+// kernel set, pointer size and plan layout of the library that wrote them,
+// and with a hash of its version and of the code templates the saved code
+// was generated from; a file that differs in any of these is rejected.
+int ffts_export_wisdom(const char *path);
+int ffts_import_wisdom(const char *path);
+int ffts_export_plan(ffts_plan_t *, const char *path);
+ffts_plan_t *ffts_import_plan(const char *path);
+
+// Plan memory. While arenas are enabled, each 1D power-of-two plan (which
+// every other kind of plan is built from) is laid out in a single 64-byte
+// aligned block: the plan followed by its tables in the order a transform reads
+// them. With FFTS_ARENA_HUGEPAGES, blocks of a megabyte or more are backed by
+// huge pages where the system has them. ffts_set_allocator makes plans created
+// afterwards take their blocks from alloc, and implies arenas, e.g. to place
+// plans on the NUMA node of the thread using them; free is passed the size that
+// was allocated, and NULL restores the default. The working memory of the other
+// plans can be supplied per call with ffts_execute_scratch.
+#define FFTS_ARENA_ON         1
+#define FFTS_ARENA_HUGEPAGES  2
+
+typedef void *(*ffts_alloc_func)(size_t size, size_t align, void *ctx);
+typedef void (*ffts_free_func)(void *ptr, size_t size, void *ctx);
+
+void ffts_plan_arena_enable(int flags);
+void ffts_set_allocator(ffts_alloc_func alloc, ffts_free_func free, void *ctx);
+
+// Profiling. With FFTS_PERF_MAP=1 in the environment, or after
+// ffts_perf_map_enable(1), the generated code of each plan is named in
+// /tmp/perf-<pid>.map for perf and similar profilers, region by region: the
+// leaf passes, the x4 and x8 butterflies and the pass sequence, e.g.
+// ffts_1024_fwd_avx2_leaf_ee. Builds configured with --enable-instrumentation
+// also count, for each plan, the calls made to it through the ffts_execute*
+// functions, the time spent in them in timestamp counter ticks (reference
+// cycles on x86, the system counter on AArch64, nanoseconds elsewhere) and
+// the bytes of input read and output written. Calls from any number of threads
+// are counted, but not those a plan makes to the plans it is built from.
+// ffts_plan_stats returns -1, with zeroed counters, in other builds.
+typedef struct {
+	uint64_t calls, cycles, bytes;
+} ffts_plan_stats_t;
+
+void ffts_perf_map_enable(int enable);
+int ffts_plan_stats(ffts_plan_t *, ffts_plan_stats_t *stats);
+void ffts_plan_stats_reset(ffts_plan_t *);
+
 #ifdef __cplusplus
 }  /* extern "C" */
 #endif /* __cplusplus */
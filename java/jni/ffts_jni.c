@@ -33,6 +33,8 @@
 
 #include <ffts.h>
 #include <alloca.h>
+#include <stdint.h>
+#include <string.h>
 
 // Bit of a hack for android, as we can't build the *.h without
 // the classes ... but we can't build the project without the jni.
@@ -49,7 +51,6 @@
 #define NEEDS_ALIGNED
 #endif
 
-#ifdef NEEDS_ALIGNED
 #define ALIGN_MASK 15
 
 static void *
@@ -66,7 +67,18 @@ xmemalign(size_t align, size_t size) {
 #error "Require an aligning malloc"
 #endif
 }
-#endif
+
+/*
+ * The java side holds one of these rather than the bare plan.  When
+ * the arrays passed to execute() aren't aligned the data goes through
+ * the staging buffers, which are allocated once on first use and
+ * reused for the lifetime of the plan.
+ */
+struct jni_plan {
+	ffts_plan_t *plan;
+	float *src, *dst;
+	jlong ssize, dsize;
+};
 
 static void
 throwOutOfMemoryError(JNIEnv *env, const char *msg) {
@@ -76,31 +88,50 @@ throwOutOfMemoryError(JNIEnv *env, const char *msg) {
 		(*env)->ThrowNew(env, jc, msg);
 }
 
-JNIEXPORT jlong JNICALL Java_nz_ac_waikato_ffts_FFTS_complex_11d
-(JNIEnv *env, jclass jc, jint N, jint sign) {
-	ffts_plan_t *plan;
+static jlong
+wrapPlan(JNIEnv *env, ffts_plan_t *plan) {
+	struct jni_plan *jp;
+
+	if (!plan) {
+		throwOutOfMemoryError(env, NULL);
+		return 0;
+	}
 
-	plan = ffts_init_1d(N, sign);
-	if (!plan)
+	jp = calloc(1, sizeof(*jp));
+	if (!jp) {
+		ffts_free(plan);
 		throwOutOfMemoryError(env, NULL);
+		return 0;
+	}
+	jp->plan = plan;
 
-	return (jlong)plan;
+	return (jlong)(intptr_t)jp;
 }
 
-JNIEXPORT jlong JNICALL Java_nz_ac_waikato_ffts_FFTS_complex_12d
-(JNIEnv *env, jclass jc, jint N1, jint N2, jint sign) {
-	ffts_plan_t *plan;
+static float *
+staging(float **buf, jlong *have, jlong size) {
+	if (*have < size) {
+		free(*buf);
+		*have = 0;
+		*buf = xmemalign(64, size * sizeof(float));
+		if (*buf)
+			*have = size;
+	}
+	return *buf;
+}
 
-	plan = ffts_init_2d(N1, N2, sign);
-	if (!plan)
-		throwOutOfMemoryError(env, NULL);
+JNIEXPORT jlong JNICALL Java_nz_ac_waikato_ffts_FFTS_complex_11d
+(JNIEnv *env, jclass jc, jint N, jint sign) {
+	return wrapPlan(env, ffts_init_1d(N, sign));
+}
 
-	return (jlong)plan;
+JNIEXPORT jlong JNICALL Java_nz_ac_waikato_ffts_FFTS_complex_12d
+(JNIEnv *env, jclass jc, jint N1, jint N2, jint sign) {
+	return wrapPlan(env, ffts_init_2d(N1, N2, sign));
 }
 
 JNIEXPORT jlong JNICALL Java_nz_ac_waikato_ffts_FFTS_complex_1nd
 (JNIEnv *env, jclass jc, jintArray jNs, jint sign) {
-	ffts_plan_t *plan;
 	int n = (*env)->GetArrayLength(env, jNs);
 	int *cNs;
 	size_t *Ns;
@@ -114,38 +145,21 @@ JNIEXPORT jlong JNICALL Java_nz_ac_waikato_ffts_FFTS_complex_1nd
 	for (i=0;i<n;i++)
 		Ns[i] = cNs[i];
 
-	plan = ffts_init_nd(n, Ns, sign);
-	if (!plan)
-		throwOutOfMemoryError(env, NULL);
-
-	return (jlong)plan;
+	return wrapPlan(env, ffts_init_nd(n, Ns, sign));
 }
 
 JNIEXPORT jlong JNICALL Java_nz_ac_waikato_ffts_FFTS_real_11d
 (JNIEnv *env, jclass jc, jint N, jint sign) {
-	ffts_plan_t *plan;
-
-	plan = ffts_init_1d_real(N, sign);
-	if (!plan)
-		throwOutOfMemoryError(env, NULL);
-
-	return (jlong)plan;
+	return wrapPlan(env, ffts_init_1d_real(N, sign));
 }
 
 JNIEXPORT jlong JNICALL Java_nz_ac_waikato_ffts_FFTS_real_12d
 (JNIEnv *env, jclass jc, jint N1, jint N2, jint sign) {
-	ffts_plan_t *plan;
-
-	plan = ffts_init_2d_real(N1, N2, sign);
-	if (!plan)
-		throwOutOfMemoryError(env, NULL);
-
-	return (jlong)plan;
+	return wrapPlan(env, ffts_init_2d_real(N1, N2, sign));
 }
 
 JNIEXPORT jlong JNICALL Java_nz_ac_waikato_ffts_FFTS_real_1nd
 (JNIEnv *env, jclass jc, jintArray jNs, jint sign) {
-	ffts_plan_t *plan;
 	int n = (*env)->GetArrayLength(env, jNs);
 	int *cNs;
 	size_t *Ns;
@@ -159,79 +173,90 @@ JNIEXPORT jlong JNICALL Java_nz_ac_waikato_ffts_FFTS_real_1nd
 	for (i=0;i<n;i++)
 		Ns[i] = cNs[i];
 
-	plan = ffts_init_nd_real(n, Ns, sign);
-	if (!plan)
-		throwOutOfMemoryError(env, NULL);
-
-	return (jlong)plan;
+	return wrapPlan(env, ffts_init_nd_real(n, Ns, sign));
 }
 
-JNIEXPORT void JNICALL Java_nz_ac_waikato_ffts_FFTS_execute__JJ_3FI_3FI
-(JNIEnv *env, jclass jc, jlong p, jlong size, jfloatArray jsrc, jint soff, jfloatArray jdst, jint doff) {
-	ffts_plan_t *plan = (ffts_plan_t *)p;
+JNIEXPORT void JNICALL Java_nz_ac_waikato_ffts_FFTS_execute__JJ_3FIJ_3FI
+(JNIEnv *env, jclass jc, jlong p, jlong ssize, jfloatArray jsrc, jint soff, jlong dsize, jfloatArray jdst, jint doff) {
+	struct jni_plan *jp = (struct jni_plan *)(intptr_t)p;
+	float *in, *out, *src, *dst;
 
-	// TODO: check performance on android/arm
+	// The critical section is the fastest way into the arrays with the
+	// oracle jvm.  Nothing in it calls back into the jvm or blocks, so
+	// it's safe to transform in there; the arrays are only copied when
+	// the plan needs aligned data and they don't start on a 16 byte
+	// boundary.
 #ifdef NEEDS_ALIGNED
-	// On oracle jvm this is faster than GetFloatArrayElements()
-	void *src, *dst;
-
-	src = xmemalign(64, size * 4);
-	if (!src) {
-		throwOutOfMemoryError(env, NULL);
-		return;
-	}
-	dst = xmemalign(64, size * 4);
-	if (!dst) {
-		free(src);
+	// the staging buffers are set up before entering the critical
+	// section, as that can't call back into the jvm to throw
+	if (!staging(&jp->src, &jp->ssize, ssize) || !staging(&jp->dst, &jp->dsize, dsize)) {
 		throwOutOfMemoryError(env, NULL);
 		return;
 	}
-
-	(*env)->GetFloatArrayRegion(env, jsrc, 0, size, src + soff);
-	ffts_execute(plan, src, dst);
-	(*env)->SetFloatArrayRegion(env, jdst, 0, size, dst + doff);
-
-	free(dst);
-	free(src);
-#else
-	// This is the fastest with oracle jvm, but doesn't work with sse ...
-	void *src = (*env)->GetPrimitiveArrayCritical(env, jsrc, NULL);
-	void *dst = (*env)->GetPrimitiveArrayCritical(env, jdst, NULL);
-
-	ffts_execute(plan, src + soff, dst + doff);
-
-	(*env)->ReleasePrimitiveArrayCritical(env, jdst, dst, 0);
-	(*env)->ReleasePrimitiveArrayCritical(env, jsrc, src, 0);
 #endif
 
-#if 0
-	// This is the slowest
-	void *src = (*env)->GetFloatArrayElements(env, jsrc, NULL);
-	void *dst = (*env)->GetFloatArrayElements(env, jdst, NULL);
+	src = (*env)->GetPrimitiveArrayCritical(env, jsrc, NULL);
+	dst = (*env)->GetPrimitiveArrayCritical(env, jdst, NULL);
+	in = src + soff;
+	out = dst + doff;
 
-	ffts_execute(plan, src + soff, dst + doff);
-
-	(*env)->ReleaseFloatArrayElements(env, jdst, dst, 0);
-	(*env)->ReleaseFloatArrayElements(env, jsrc, src, 0);
+#ifdef NEEDS_ALIGNED
+	if ((intptr_t)in & ALIGN_MASK) {
+		memcpy(jp->src, in, ssize * sizeof(float));
+		in = jp->src;
+	}
+	if ((intptr_t)out & ALIGN_MASK) {
+		ffts_execute(jp->plan, in, jp->dst);
+		memcpy(out, jp->dst, dsize * sizeof(float));
+	} else
 #endif
+	ffts_execute(jp->plan, in, out);
+
+	(*env)->ReleasePrimitiveArrayCritical(env, jdst, dst, 0);
+	(*env)->ReleasePrimitiveArrayCritical(env, jsrc, src, JNI_ABORT);
 }
 
 JNIEXPORT void JNICALL Java_nz_ac_waikato_ffts_FFTS_execute__JJLjava_nio_FloatBuffer_2Ljava_nio_FloatBuffer_2
 (JNIEnv *env, jclass jc, jlong p, jlong size, jobject jsrc, jobject jdst) {
-	ffts_plan_t *plan = (ffts_plan_t *)p;
+	struct jni_plan *jp = (struct jni_plan *)(intptr_t)p;
 	void *src = (*env)->GetDirectBufferAddress(env, jsrc);
 	void *dst = (*env)->GetDirectBufferAddress(env, jdst);
 
 	// Bounds checking etc is in java side.
 
-	ffts_execute(plan, src, dst);
+	ffts_execute(jp->plan, src, dst);
 }
 
 JNIEXPORT void JNICALL Java_nz_ac_waikato_ffts_FFTS_free
 (JNIEnv *env, jclass jc, jlong p) {
-	ffts_plan_t *plan = (ffts_plan_t *)p;
+	struct jni_plan *jp = (struct jni_plan *)(intptr_t)p;
+
+	ffts_free(jp->plan);
+	free(jp->src);
+	free(jp->dst);
+	free(jp);
+}
+
+JNIEXPORT jobject JNICALL Java_nz_ac_waikato_ffts_FFTS_allocate
+(JNIEnv *env, jclass jc, jlong bytes) {
+	void *mem = xmemalign(64, bytes);
+	jobject jb;
+
+	if (!mem) {
+		throwOutOfMemoryError(env, NULL);
+		return NULL;
+	}
+
+	jb = (*env)->NewDirectByteBuffer(env, mem, bytes);
+	if (!jb)
+		free(mem);
+
+	return jb;
+}
 
-	ffts_free(plan);
+JNIEXPORT void JNICALL Java_nz_ac_waikato_ffts_FFTS_release
+(JNIEnv *env, jclass jc, jobject jb) {
+	free((*env)->GetDirectBufferAddress(env, jb));
 }
 
 // vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -30,6 +30,8 @@
  */
 package nz.ac.waikato.ffts;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.nio.FloatBuffer;
 
 /**
@@ -61,7 +63,7 @@ public class FFTS {
 	private FFTS(long p, long inSize, long outSize) {
 		this.p = p;
 		this.inSize = inSize;
-		this.outSize = inSize;
+		this.outSize = outSize;
 	}
 	/**
 	 * The sign to use for a forward transform.
@@ -124,6 +126,11 @@ public class FFTS {
 
 	/**
 	 * Execute this plan with the given array data.
+	 *
+	 * The arrays are used in place where possible; otherwise the data is
+	 * copied through buffers kept with the plan, so a plan should not be
+	 * executed from several threads at once.
+	 *
 	 * @param src
 	 * @param soff Start offset into src array.
 	 * @param dst
@@ -135,7 +142,7 @@ public class FFTS {
 		if (p == 0)
 			throw new NullPointerException();
 
-		execute(p, inSize, src, soff, dst, doff);
+		execute(p, inSize, src, soff, outSize, dst, doff);
 	}
 
 	/**
@@ -156,6 +163,29 @@ public class FFTS {
 		execute(p, inSize, src, dst);
 	}
 
+	/**
+	 * Allocate a direct buffer of floats that is suitably aligned for
+	 * execute(FloatBuffer, FloatBuffer) on every build.
+	 *
+	 * The memory is not managed by the garbage collector and must be
+	 * released with freeBuffer().
+	 *
+	 * @param size Number of floats.
+	 * @return
+	 */
+	public static FloatBuffer allocateBuffer(int size) {
+		return allocate((long) size * 4).order(ByteOrder.nativeOrder()).asFloatBuffer();
+	}
+
+	/**
+	 * Release a buffer from allocateBuffer().
+	 *
+	 * @param buffer
+	 */
+	public static void freeBuffer(FloatBuffer buffer) {
+		release(buffer);
+	}
+
 	/**
 	 * Free the plan.
 	 */
@@ -163,6 +193,7 @@ public class FFTS {
 		if (p == 0)
 			throw new NullPointerException();
 		free(p);
+		p = 0;
 	}
 
 	/*
@@ -195,9 +226,13 @@ public class FFTS {
 
 	protected static native long real_nd(int[] Ns, int sign);
 
-	protected static native void execute(long p, long size, float[] src, int soff, float[] dst, int doff);
+	protected static native void execute(long p, long ssize, float[] src, int soff, long dsize, float[] dst, int doff);
 
 	protected static native void execute(long p, long size, FloatBuffer src, FloatBuffer dst);
 
 	protected static native void free(long p);
+
+	protected static native ByteBuffer allocate(long bytes);
+
+	protected static native void release(FloatBuffer buffer);
 }
@@ -0,0 +1,150 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+# 256-bit AVX2/FMA version of x8_soft, for CPUs that support it. It is called
+# with the same registers as x8_soft (rdx: data, rcx: stride, r8: LUT, xmm3:
+# sign mask), processes four complex values per stream and iteration, and
+# expects the twiddles of each group of four to be laid out as
+# [w0 re][w0 im][w1 re][w1 im][w2 re][w2 im] with 256-bit entries.
+
+	.text
+#ifdef __APPLE__
+	.globl	_x8_avx
+_x8_avx:
+#else
+	.globl	x8_avx
+x8_avx:
+#endif
+	xorl %eax, %eax
+				movq      %rdx, %rbx
+        movq      %r8, %rsi
+				leaq       (%rdx,%rcx,4), %r9
+        leaq       (%r9,%rcx,4), %r10
+        leaq       (%r10,%rcx,4), %r11
+        leaq       (%r11,%rcx,4), %r12
+        leaq       (%r12,%rcx,4), %r13
+        leaq       (%r13,%rcx,4), %r14
+        leaq       (%r14,%rcx,4), %r15
+        vinsertf128 $1, %xmm3, %ymm3, %ymm15
+#ifdef __APPLE__
+	.globl	_x8_avx_loop
+_x8_avx_loop:
+#else
+	.globl	x8_avx_loop
+x8_avx_loop:
+#endif
+X8_avx_loop:
+        vmovups    (%rsi), %ymm0
+        vmovups    32(%rsi), %ymm1
+        vmovups    (%r10,%rax,4), %ymm2
+        vmovups    (%r11,%rax,4), %ymm4
+        vpermilps  $177, %ymm2, %ymm5
+        vpermilps  $177, %ymm4, %ymm6
+        vmulps     %ymm1, %ymm5, %ymm5
+        vmulps     %ymm1, %ymm6, %ymm6
+        vfmsub231ps %ymm0, %ymm2, %ymm5
+        vfmadd231ps %ymm0, %ymm4, %ymm6
+        vaddps     %ymm6, %ymm5, %ymm7
+        vsubps     %ymm6, %ymm5, %ymm5
+        vxorps     %ymm15, %ymm5, %ymm5   #const
+        vpermilps  $177, %ymm5, %ymm5
+        vmovups    (%rbx,%rax,4), %ymm8
+        vmovups    (%r9,%rax,4), %ymm9
+        vaddps     %ymm7, %ymm8, %ymm10
+        vsubps     %ymm7, %ymm8, %ymm8
+        vsubps     %ymm5, %ymm9, %ymm11
+        vaddps     %ymm5, %ymm9, %ymm9
+
+        vmovups    64(%rsi), %ymm0
+        vmovups    96(%rsi), %ymm1
+        vmovups    (%r12,%rax,4), %ymm2
+        vmovups    (%r14,%rax,4), %ymm4
+        vpermilps  $177, %ymm2, %ymm5
+        vpermilps  $177, %ymm4, %ymm6
+        vmulps     %ymm1, %ymm5, %ymm5
+        vmulps     %ymm1, %ymm6, %ymm6
+        vfmsub231ps %ymm0, %ymm2, %ymm5
+        vfmadd231ps %ymm0, %ymm4, %ymm6
+        vaddps     %ymm6, %ymm5, %ymm7
+        vsubps     %ymm6, %ymm5, %ymm5
+        vxorps     %ymm15, %ymm5, %ymm5   #const
+        vpermilps  $177, %ymm5, %ymm5
+        vaddps     %ymm7, %ymm10, %ymm12
+        vsubps     %ymm7, %ymm10, %ymm10
+        vsubps     %ymm5, %ymm8, %ymm13
+        vaddps     %ymm5, %ymm8, %ymm8
+        vmovups    %ymm12, (%rbx,%rax,4)
+        vmovups    %ymm13, (%r10,%rax,4)
+        vmovups    %ymm10, (%r12,%rax,4)
+        vmovups    %ymm8, (%r14,%rax,4)
+
+        vmovups    128(%rsi), %ymm0
+        vmovups    160(%rsi), %ymm1
+        vmovups    (%r13,%rax,4), %ymm2
+        vmovups    (%r15,%rax,4), %ymm4
+        vpermilps  $177, %ymm2, %ymm5
+        vpermilps  $177, %ymm4, %ymm6
+        vmulps     %ymm1, %ymm5, %ymm5
+        vmulps     %ymm1, %ymm6, %ymm6
+        vfmsub231ps %ymm0, %ymm2, %ymm5
+        vfmadd231ps %ymm0, %ymm4, %ymm6
+        vaddps     %ymm6, %ymm5, %ymm7
+        vsubps     %ymm6, %ymm5, %ymm5
+        vxorps     %ymm15, %ymm5, %ymm5   #const
+        vpermilps  $177, %ymm5, %ymm5
+        vaddps     %ymm7, %ymm11, %ymm12
+        vsubps     %ymm7, %ymm11, %ymm11
+        vsubps     %ymm5, %ymm9, %ymm13
+        vaddps     %ymm5, %ymm9, %ymm9
+        vmovups    %ymm12, (%r9,%rax,4)
+        vmovups    %ymm13, (%r11,%rax,4)
+        vmovups    %ymm11, (%r13,%rax,4)
+        vmovups    %ymm9, (%r15,%rax,4)
+
+        addq       $192, %rsi
+        addq       $8, %rax
+				cmpq	%rcx, %rax
+        jne        X8_avx_loop
+        vzeroupper
+				ret
+
+#ifdef __APPLE__
+	.globl	_x8_avx_end
+_x8_avx_end:
+#else
+	.globl	x8_avx_end
+x8_avx_end:
+#endif
+
+# the code needs no executable stack
+	.section .note.GNU-stack,"",@progbits
@@ -34,6 +34,8 @@
 #include "codegen.h"
 #include "macros.h"
 #include "ffts.h"
+#include "ffts_cpu.h"
+#include "ffts_code.h"
 
 #ifdef __APPLE__
 	#include <libkern/OSCacheControl.h>
@@ -155,6 +157,42 @@ void align_mem16(uint8_t **p, uint32_t offset) {
 #endif
 }
 
+// FNV-1a of n bytes at d, continuing from h
+static uint64_t ffts_codegen_hash(uint64_t h, const void *d, size_t n) {
+	const uint8_t *b = (const uint8_t *)d;
+	size_t i;
+	for(i=0;i<n;i++) h = (h ^ b[i]) * 0x100000001b3ULL;
+	return h;
+}
+
+#define HASH_RANGE(h, a, b) ffts_codegen_hash(h, (const void *)(a), (const uint8_t *)(b) - (const uint8_t *)(a))
+
+uint64_t ffts_codegen_build_id(void) {
+	static uint64_t id = 0;
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	if(id) return id;
+	h = ffts_codegen_hash(h, PACKAGE_VERSION, sizeof(PACKAGE_VERSION));
+#ifdef HAVE_NEON
+	h = HASH_RANGE(h, neon_x4, neon_end);
+#elif HAVE_VFP
+	h = HASH_RANGE(h, vfp_e, vfp_end);
+#else
+	h = HASH_RANGE(h, leaf_ee_init, leaf_end);
+	h = HASH_RANGE(h, x_init, x8_hard);
+	h = HASH_RANGE(h, x8_avx, x8_avx_end);
+	h = ffts_codegen_hash(h, sse_leaf_ee_offsets, sizeof(sse_leaf_ee_offsets));
+	h = ffts_codegen_hash(h, sse_leaf_oo_offsets, sizeof(sse_leaf_oo_offsets));
+	h = ffts_codegen_hash(h, sse_leaf_eo_offsets, sizeof(sse_leaf_eo_offsets));
+	h = ffts_codegen_hash(h, sse_leaf_oe_offsets, sizeof(sse_leaf_oe_offsets));
+#endif
+	id = h ? h : 1;
+	return id;
+}
+
+// most regions ffts_generate_func_code marks in a plan's code
+#define CODE_REGIONS 12
+
 void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 	int count = tree_count(N, leafN, 0) + 1;
 	size_t *ps = malloc(count * 2 * sizeof(size_t));
@@ -179,19 +217,11 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 	else p->transform_size = 16384 + 2*N/8 * __builtin_ctzl(N);
 #endif
 
-#ifdef __APPLE__
-	p->transform_base = mmap(NULL, p->transform_size, PROT_WRITE | PROT_READ, MAP_ANON | MAP_SHARED, -1, 0);
-#else
-#define MAP_ANONYMOUS 0x20	
-	p->transform_base = mmap(NULL, p->transform_size, PROT_WRITE | PROT_READ, MAP_ANONYMOUS | MAP_SHARED, -1, 0);
-#endif
+	// the code is written at func and runs from transform_base
+	void *rw = NULL;
+	p->transform_base = ffts_code_alloc(p->transform_size, &rw);
 
-/*
-	if(p->transform_base == MAP_FAILED) {
-		fprintf(stderr, "MAP FAILED\n");
-		exit(1);
-	}*/
-	insns_t *func = p->transform_base;//valloc(8192);
+	insns_t *func = p->transform_base ? rw : NULL;
 	insns_t *fp = func;
 
 //fprintf(stderr, "Allocating %d bytes \n", p->transform_size);
@@ -202,6 +232,14 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 		exit(1);
 	}
 
+	// regions named for profilers, see ffts_code_label
+	ffts_code_region_t regions[CODE_REGIONS];
+	int nregions = 0;
+#define CODE_MARK(addr, label) do { \
+		regions[nregions].off = (uint8_t *)(addr) - (uint8_t *)func; \
+		regions[nregions++].name = (label); \
+	} while(0)
+
 	insns_t *x_8_addr = fp;
 #ifdef __arm__
 #ifdef HAVE_NEON
@@ -237,11 +275,19 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 #else
 	align_mem16(&fp, 0);
 	x_8_addr = fp;
-	align_mem16(&fp, 5);
-	memcpy(fp, x8_soft, x8_hard - x8_soft);
-	fp += (x8_hard - x8_soft);
+	if(p->isa == FFTS_ISA_AVX2) {
+		align_mem16(&fp, (insns_t *)x8_avx_loop - (insns_t *)x8_avx);
+		x_8_addr = fp;
+		memcpy(fp, x8_avx, x8_avx_end - x8_avx);
+		fp += (x8_avx_end - x8_avx);
+	}else{
+		align_mem16(&fp, 5);
+		memcpy(fp, x8_soft, x8_hard - x8_soft);
+		fp += (x8_hard - x8_soft);
+	}
 //fprintf(stderr, "X8 start address = %016p\n", x_8_addr);
 #endif
+	CODE_MARK(x_8_addr, "x8");
 //uint32_t *x_8_t_addr = fp;
 //memcpy(fp, neon_x8_t, neon_end - neon_x8_t);
 //fp += (neon_end - neon_x8_t) / 4;
@@ -270,9 +316,11 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 	fp += (x8_soft - x4);
 
 #endif
+	CODE_MARK(x_4_addr, "x4");
 	insns_t *start = fp;
 
 #ifdef __arm__ 
+	CODE_MARK(start, "leaf_ee");
 	*fp = PUSH_LR(); fp++;
 	*fp = 0xed2d8b10; fp++;
 
@@ -304,6 +352,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 #else
 	align_mem16(&fp, 0);
 	start = fp;
+	CODE_MARK(start, "leaf_ee");
 	
 	*fp++ = 0x4c;
 	*fp++ = 0x8b;
@@ -376,6 +425,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 	if(__builtin_ctzl(N) & 1){
 
 		if(p->i1) {
+			CODE_MARK(fp, "leaf_oo");
 			lp_cnt += p->i1 * 4;
 			MOVI(&fp, RCX, lp_cnt);
 			align_mem16(&fp, 4);
@@ -385,6 +435,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 		}
 		
 
+		CODE_MARK(fp, "leaf_oe");
 		memcpy(fp, leaf_oe, leaf_end - leaf_oe);
 		lp_cnt += 4;
 		for(i=0;i<8;i++) IMM32_NI(fp + sse_leaf_oe_offsets[i], offsets_o[i]*4); 
@@ -393,12 +444,14 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 	}else{
 
 
+		CODE_MARK(fp, "leaf_eo");
 		memcpy(fp, leaf_eo, leaf_oe - leaf_eo);
 		lp_cnt += 4;
 		for(i=0;i<8;i++) IMM32_NI(fp + sse_leaf_eo_offsets[i], offsets[i]*4); 
 		fp += (leaf_oe - leaf_eo);
 
 		if(p->i1) {
+			CODE_MARK(fp, "leaf_oo");
 			lp_cnt += p->i1 * 4;
 			MOVI(&fp, RCX, lp_cnt);
 			align_mem16(&fp, 4);
@@ -409,6 +462,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 
 	}
 	if(p->i1) {
+		CODE_MARK(fp, "leaf_ee");
 		lp_cnt += p->i1 * 4;
 		MOVI(&fp, RCX, lp_cnt);
 		align_mem16(&fp, 9);
@@ -420,6 +474,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 	
 //fprintf(stderr, "Body start address = %016p\n", fp);
   //LEA(&fp, R8, RDI, ((uint32_t)&p->ws) - ((uint32_t)p)); 
+	CODE_MARK(fp, "passes");
 	memcpy(fp, x_init, x4 - x_init);
 //IMM32_NI(fp + 3, ((int64_t)READ_IMM32(fp + 3)) + ((void *)x_init - (void *)fp )); 
 	fp += (x4 - x_init);
@@ -485,6 +540,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 		ADDI(&fp, 10, 2, 0);
 	
 		if(p->i1) {
+			CODE_MARK(fp, "leaf_oo");
 			MOVI(&fp, 11, p->i1);
 			memcpy(fp, neon_oo, neon_eo - neon_oo);
 			if(sign < 0) {
@@ -495,6 +551,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 			fp += (neon_eo - neon_oo) / 4;
 		}
 		
+		CODE_MARK(fp, "leaf_oe");
 		*fp = LDRI(11, 1, ((uint32_t)&p->oe_ws) - ((uint32_t)p)); fp++; 
 
 		memcpy(fp, neon_oe, neon_end - neon_oe);
@@ -507,6 +564,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 
 	}else{
 		
+		CODE_MARK(fp, "leaf_eo");
 		*fp = LDRI(11, 1, ((uint32_t)&p->eo_ws) - ((uint32_t)p)); fp++; 
 
 		memcpy(fp, neon_eo, neon_oe - neon_eo);
@@ -526,6 +584,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 		ADDI(&fp, 10, 2, 0);
 	
 		if(p->i1) {
+			CODE_MARK(fp, "leaf_oo");
 			MOVI(&fp, 11, p->i1);
 			memcpy(fp, neon_oo, neon_eo - neon_oo);
 			if(sign < 0) {
@@ -560,6 +619,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 		ADDI(&fp, 9, 10, 0);
 		ADDI(&fp, 10, 2, 0);
 
+		CODE_MARK(fp, "leaf_ee");
 		*fp = LDRI(2, 1, ((uint32_t)&p->ee_ws) - ((uint32_t)p)); fp++; 
 	  MOVI(&fp, 11, p->i1);
   	memcpy(fp, neon_ee, neon_oo - neon_ee);
@@ -580,6 +640,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 		ADDI(&fp, 8, 10, 0);
 		ADDI(&fp, 10, 2, 0);
 	
+			CODE_MARK(fp, "leaf_oo");
 			MOVI(&fp, 11, (p->i1>0) ? p->i1 : 1);
   		memcpy(fp, vfp_o, vfp_x4 - vfp_o);
 		if(sign > 0) {
@@ -608,6 +669,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 		ADDI(&fp, 9, 10, 0);
 		ADDI(&fp, 10, 2, 0);
 
+		CODE_MARK(fp, "leaf_ee");
 		*fp = LDRI(2, 1, ((uint32_t)&p->ee_ws) - ((uint32_t)p)); fp++; 
 	  MOVI(&fp, 11, (p->i2>0) ? p->i2 : 1);
   	memcpy(fp, vfp_e, vfp_o - vfp_e);
@@ -619,6 +681,7 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
   	fp += (vfp_o - vfp_e) / 4;
 
 #endif
+	CODE_MARK(fp, "passes");
   *fp = LDRI(2, 1, ((uint32_t)&p->ws) - ((uint32_t)p)); fp++; // load offsets into r12
 	//ADDI(&fp, 2, 1, 0);
 	MOVI(&fp, 1, 0);
@@ -675,9 +738,11 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 		pps += 2;
 	}
 	
+	CODE_MARK(fp, "epilogue");
 	*fp++ = 0xecbd8b10;
 	*fp++ = POP_LR(); count++;
 #else
+	CODE_MARK(fp, "epilogue");
 	POP(&fp, R15);
 	POP(&fp, R14);
 	POP(&fp, R13);
@@ -710,23 +775,19 @@ void ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leafN, int sign) {
 //for(int i=0;i<count;i++) 
 
 	free(ps);
+	CODE_MARK(fp, NULL);
+#undef CODE_MARK
 	
-  if (mprotect(func, p->transform_size, PROT_READ | PROT_EXEC)) {
-  	perror("Couldn't mprotect");
-  	exit(1);
-  }
-#ifdef __APPLE__
-	sys_icache_invalidate(func, p->transform_size);
-#elif __ANDROID__
-	cacheflush((long)(func), (long)(func) + p->transform_size, 0);
-#elif __linux__
-#ifdef __GNUC__
-	__clear_cache((long)(func), (long)(func) + p->transform_size);
-#endif
-#endif
+	p->transform_size = ffts_code_commit(p->transform_base, func, p->transform_size,
+	                                     (uint8_t *)fp - (uint8_t *)func);
+	if(!p->transform_size) {
+		perror("Couldn't make the generated code executable");
+		exit(1);
+	}
 
 //fprintf(stderr, "size of transform %zu = %d\n", N, (fp-func)*4);
 
-	p->transform = (void *) (start);
+	p->transform = (void *)((uint8_t *)p->transform_base + ((uint8_t *)start - (uint8_t *)func));
+	ffts_code_label(p, regions, nregions);
 }
 // vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -46,5 +46,9 @@
 
 void ffts_generate_func_code(ffts_plan_t *, size_t N, size_t leafN, int sign); 
 
+/* a hash of the library version and the code templates the generated code
+ * is copied from, which code saved by another build won't match */
+uint64_t ffts_codegen_build_id(void);
+
 #endif
 // vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -48,6 +48,9 @@ void x_init();
 void x4();
 void x8_soft();
 void x8_hard();
+void x8_avx();
+void x8_avx_loop();
+void x8_avx_end();
 
 void sse_constants();
 void sse_constants_inv();
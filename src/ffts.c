@@ -35,6 +35,15 @@
 //#include "mini_macros.h"
 #include "patterns.h"
 #include "ffts_small.h"
+#include "ffts_mixed.h"
+#include "ffts_chirp_z.h"
+#include "ffts_split.h"
+#include "ffts_cpu.h"
+#include "ffts_cache.h"
+#include "ffts_arena.h"
+#include "ffts_code.h"
+#include "ffts_stats.h"
+#include "ffts_twiddle.h"
 
 #ifdef DYNAMIC_DISABLED
 	#include "ffts_static.h"
@@ -54,18 +63,95 @@
 
 void ffts_execute(ffts_plan_t *p, const void *  in, void *  out) {
 
+	// The x86 kernels use unaligned loads and stores on in and out, which
+	// cost the same as aligned ones when the buffers are aligned anyway
 //TODO: Define NEEDS_ALIGNED properly instead 
-#if defined(HAVE_SSE) || defined(HAVE_NEON)
-	if(((int)in % 16) != 0) {
+#if defined(HAVE_NEON)
+	if(((uintptr_t)in % 16) != 0) {
 		LOG("ffts_execute: input buffer needs to be aligned to a 128bit boundary\n");
 	}
 
-	if(((int)out % 16) != 0) {
+	if(((uintptr_t)out % 16) != 0) {
 		LOG("ffts_execute: output buffer needs to be aligned to a 128bit boundary\n");
 	}
 #endif
 
+	// split plans take pointer pairs, which only ffts_execute_split builds
+	if(p->transform == &ffts_execute_1d_split) {
+		LOG("ffts_execute: split plans are executed with ffts_execute_split\n");
+		return;
+	}
+
+	FFTS_STATS_BEGIN(t);
 	p->transform(p, (const float *)in, (float *)out);
+	FFTS_STATS_END(p, t, p->io_bytes);
+}
+
+/*
+ * Executing on caller scratch: the plan struct is copied with buf and
+ * transpose_buf pointed into the scratch, as are the sub-plans that need
+ * scratch of their own, and the copy is run. Nothing else is written during
+ * execution, and the generated code finds everything through the plan it
+ * is given, so the copy behaves like the plan.
+ */
+#define SCRATCH_ALIGN(x) (((x) + 63) & ~(size_t)63)
+
+size_t ffts_scratch_size(ffts_plan_t *p) {
+	size_t size, sub = 0;
+	int i;
+
+	if(p->nplans < 0) return 0;
+	size = SCRATCH_ALIGN(p->buf_size) + SCRATCH_ALIGN(p->transpose_buf_size);
+	for(i=0;i<p->nplans;i++) {
+		size_t s = ffts_scratch_size(p->plans[i]);
+		if(s) sub += SCRATCH_ALIGN(sizeof(ffts_plan_t)) + s;
+	}
+	if(sub) size += SCRATCH_ALIGN(sizeof(ffts_plan_t *) * p->nplans) + sub;
+	return size;
+}
+
+static void ffts_scratch_bind(ffts_plan_t *q, uint8_t *scratch) {
+	size_t size = ffts_scratch_size(q);
+	uint8_t *end = scratch + size;
+	int i;
+
+	if(q->buf_size) q->buf = scratch;
+	scratch += SCRATCH_ALIGN(q->buf_size);
+	if(q->transpose_buf_size) q->transpose_buf = scratch;
+	scratch += SCRATCH_ALIGN(q->transpose_buf_size);
+	if(scratch == end) return;
+
+	ffts_plan_t **plans = (ffts_plan_t **)scratch;
+	scratch += SCRATCH_ALIGN(sizeof(ffts_plan_t *) * q->nplans);
+	for(i=0;i<q->nplans;i++) {
+		plans[i] = q->plans[i];
+		if(!ffts_scratch_size(plans[i])) continue;
+		ffts_plan_t *c = (ffts_plan_t *)scratch;
+		*c = *q->plans[i];
+		scratch += SCRATCH_ALIGN(sizeof(ffts_plan_t));
+		ffts_scratch_bind(c, scratch);
+		scratch += ffts_scratch_size(c);
+		plans[i] = c;
+	}
+	q->plans = plans;
+}
+
+void ffts_execute_scratch(ffts_plan_t *p, const void *in, void *out, void *scratch) {
+	ffts_plan_t q;
+
+	if(p->transform == &ffts_execute_1d_split) {
+		LOG("ffts_execute_scratch: split plans have no scratch variant\n");
+		return;
+	}
+	if(!ffts_scratch_size(p)) {
+		ffts_execute(p, in, out);
+		return;
+	}
+	FFTS_STATS_BEGIN(t);
+	q = *p;
+	ffts_scratch_bind(&q, (uint8_t *)scratch);
+	q.transform(&q, (const float *)in, (float *)out);
+	FFTS_STATS_END(p, t, p->io_bytes);
 }
 
 void ffts_free(ffts_plan_t *p) {
@@ -76,33 +162,81 @@ void ffts_free_1d(ffts_plan_t *p) {
 	
 	size_t i;
 
-	if(p->ws) {
-		FFTS_FREE(p->ws);
-	}
-	if(p->is) free(p->is);
-	if(p->ws_is) free(p->ws_is);
-	if(p->offsets)		free(p->offsets);
-	//free(p->transforms);
-	if(p->transforms) free(p->transforms);
-
-	if(p->transform_base) {
-		if (mprotect(p->transform_base, p->transform_size, PROT_READ | PROT_WRITE)) {
-			perror("Couldn't mprotect");
-			exit(errno);
+	if(!p->arena) {
+		if(p->ws) {
+			FFTS_FREE(p->ws);
 		}
-		munmap(p->transform_base, p->transform_size);
-		//free(p->transform_base);
+		if(p->is) free(p->is);
+		if(p->ws_is) free(p->ws_is);
+		if(p->offsets)		free(p->offsets);
+		//free(p->transforms);
+		if(p->transforms) free(p->transforms);
 	}
-	free(p);
+
+	if(p->transform_base) ffts_code_free(p->transform_base, p->transform_size);
+	if(p->arena) ffts_arena_free(p->arena);
+	else free(p);
 }
 
 ffts_plan_t *ffts_init_1d(size_t N, int sign) {
-	if(N == 0 || (N & (N - 1)) != 0){
-		LOG("FFT size must be a power of two\n");
+	if(N == 0) {
+		LOG("FFT size must be greater than zero\n");
 		return NULL;
 	}
 
-	ffts_plan_t *p = malloc(sizeof(ffts_plan_t));
+	if((N & (N - 1)) != 0) {
+		if(ffts_mixed_supported(N)) return ffts_init_1d_mixed(N, sign);
+		return ffts_init_1d_chirp_z(N, sign);
+	}
+
+	if(ffts_plan_cache_enabled()) return ffts_cache_init_1d(N, sign);
+	return ffts_init_1d_pow2(N, sign);
+}
+
+/*
+ * Moves a plan and its tables into one arena, in the order a transform
+ * reads them: the plan, the leaf offsets and input indexes, then the
+ * twiddle factors. Only pointers into the tables change; the generated
+ * code reaches them through the plan, so this is done before generating it.
+ * On failure the plan is returned as it was.
+ */
+static ffts_plan_t *ffts_arena_pack_1d(ffts_plan_t *p, size_t leafN, size_t lut_size) {
+	size_t N = p->N;
+	size_t offsets_size = p->offsets ? sizeof(ptrdiff_t) * (N/leafN) : 0;
+	size_t is_size = p->is ? sizeof(ptrdiff_t) * N : 0;
+	size_t ws_is_size = p->ws_is ? sizeof(size_t) * p->n_luts : 0;
+	size_t transforms_size = p->transforms ? sizeof(transform_index_t) * 2 : 0;
+	size_t size = FFTS_ARENA_SIZE(sizeof(ffts_plan_t)) + FFTS_ARENA_SIZE(offsets_size) +
+	              FFTS_ARENA_SIZE(is_size) + FFTS_ARENA_SIZE(lut_size) +
+	              FFTS_ARENA_SIZE(ws_is_size) + FFTS_ARENA_SIZE(transforms_size);
+	uint8_t *a = ffts_arena_alloc(size);
+	ffts_plan_t *q = (ffts_plan_t *)a;
+
+	if(!a) return p;
+	*q = *p;
+	q->arena = a;
+	a += FFTS_ARENA_SIZE(sizeof(ffts_plan_t));
+
+#define ARENA_MOVE(f, size) \
+	if(p->f) { \
+		memcpy(a, p->f, size); \
+		q->f = (void *)a; \
+		a += FFTS_ARENA_SIZE(size); \
+	}
+	ARENA_MOVE(offsets, offsets_size);
+	ARENA_MOVE(is, is_size);
+	ARENA_MOVE(ws, lut_size);
+	ARENA_MOVE(ws_is, ws_is_size);
+	ARENA_MOVE(transforms, transforms_size);
+#undef ARENA_MOVE
+	q->lastlut = (uint8_t *)q->ws + lut_size;
+
+	ffts_free_1d(p);
+	return q;
+}
+
+ffts_plan_t *ffts_init_1d_pow2(size_t N, int sign) {
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
 	size_t leafN = 8;	
 	size_t i;	
 
@@ -127,7 +261,13 @@ ffts_plan_t *ffts_init_1d(size_t N, int sign) {
 	p->ws_is = NULL;
 	p->ws = NULL;
 	p->offsets = NULL;
+	p->cache_entry = NULL;
+	p->arena = NULL;
 	p->destroy = ffts_free_1d;
+	p->buf_size = p->transpose_buf_size = 0;
+	p->nplans = 0;
+	p->isa = ffts_cpu_isa();
+	if(N < 32 && p->isa == FFTS_ISA_AVX2) p->isa = FFTS_ISA_SSE;
 
 	if(N >= 32) {
 		ffts_init_offsets(p, N, leafN);
@@ -160,7 +300,8 @@ ffts_plan_t *ffts_init_1d(size_t N, int sign) {
 		p->transforms = malloc(2 * sizeof(transform_index_t));
 		p->transforms[0] = 0;
 		p->transforms[1] = 1;
-		if(N == 2) p->transform = &firstpass_2;
+		if(N == 1) p->transform = &firstpass_1;
+		else if(N == 2) p->transform = &firstpass_2;
 		else if(N == 4 && sign == -1) p->transform = &firstpass_4_f;
 		else if(N == 4 && sign == 1) p->transform = &firstpass_4_b;
 		else if(N == 8 && sign == -1) p->transform = &firstpass_8_f;
@@ -176,7 +317,7 @@ ffts_plan_t *ffts_init_1d(size_t N, int sign) {
 
 		/*      LUTS           */
 		size_t n_luts = __builtin_ctzl(N/leafN);
-		if(N < 32) { n_luts = __builtin_ctzl(N/4); hardcoded = 1; }
+		if(N < 32) { n_luts = (N >= 4) ? __builtin_ctzl(N/4) : 0; hardcoded = 1; }
 
 		if(n_luts >= 32) n_luts = 0;
 
@@ -191,7 +332,7 @@ ffts_plan_t *ffts_init_1d(size_t N, int sign) {
 
 		for(i=0;i<n_luts;i++) {
 			if(!i || hardcoded) {
-			#ifdef __arm__ 
+			#if defined(__arm__) || defined(__aarch64__)
 				if(N <= 32) lut_size += n/4 * 2 * sizeof(cdata_t);
 				else lut_size += n/4 * sizeof(cdata_t);
 			#else
@@ -199,7 +340,7 @@ ffts_plan_t *ffts_init_1d(size_t N, int sign) {
 			#endif
 				n *= 2;
 			} else {
-			#ifdef __arm__
+			#if defined(__arm__) || defined(__aarch64__)
 				lut_size += n/8 * 3 * sizeof(cdata_t);
 			#else
 				lut_size += n/8 * 3 * 2 * sizeof(cdata_t);
@@ -226,23 +367,24 @@ ffts_plan_t *ffts_init_1d(size_t N, int sign) {
 		#ifdef HAVE_NEON
 			V neg = (sign < 0) ? VLIT4(0.0f, 0.0f, 0.0f, 0.0f) : VLIT4(-0.0f, -0.0f, -0.0f, -0.0f);
 		#endif
+
+		// the twiddles of each level are read from the master table into
+		// w0 (w1, w2), and laid out for the transforms from there; no level
+		// needs more of it than the LUT takes
+		const ffts_twiddle_t *tw = ffts_twiddle_table(N);
+		cdata_t *w0 = n_luts ? FFTS_MALLOC(lut_size, 32) : NULL;
 		
 		for(i=0;i<n_luts;i++) {
 			p->ws_is[i] = w - (cdata_t *)p->ws;	
 			//fprintf(stderr, "LUT[%zu] = %d @ %08x - %zu\n", i, n, w, p->ws_is[i]);	
 			
 			if(!i || hardcoded) {
-				cdata_t *w0 = FFTS_MALLOC(n/4 * sizeof(cdata_t), 32);
-
 				size_t j;
-				for(j=0;j<n/4;j++) {
-					w0[j][0]	= W_re(n,j);
-					w0[j][1]	= W_im(n,j);
-				}
+				for(j=0;j<n/4;j++) ffts_lut_twiddle(tw, n, j, w0[j]);
 
 
 				float *fw0 = (float *)w0;
-				#ifdef __arm__
+				#if defined(__arm__) || defined(__aarch64__)
 					if(N < 32) {
 						//w = FFTS_MALLOC(n/4 * 2 * sizeof(cdata_t), 32);
 						float *fw = (float *)w;
@@ -297,29 +439,22 @@ ffts_plan_t *ffts_init_1d(size_t N, int sign) {
 					}
 					w += n/4 * 2;
 				#endif
-
-				FFTS_FREE(w0);
 			}else{
 
-				cdata_t *w0 = FFTS_MALLOC(n/8 * sizeof(cdata_t), 32);
-				cdata_t *w1 = FFTS_MALLOC(n/8 * sizeof(cdata_t), 32);
-				cdata_t *w2 = FFTS_MALLOC(n/8 * sizeof(cdata_t), 32);
+				cdata_t *w1 = w0 + n/8;
+				cdata_t *w2 = w1 + n/8;
 
 				size_t j;
 				for(j=0;j<n/8;j++) {
-					w0[j][0]	= W_re(n,j*2);
-					w0[j][1]	= W_im(n,j*2);
-					w1[j][0]	= W_re(n,j);
-					w1[j][1]	= W_im(n,j);
-					w2[j][0]	= W_re(n,j + (n/8));
-					w2[j][1]	= W_im(n,j + (n/8));
-
+					ffts_lut_twiddle(tw, n, j*2, w0[j]);
+					ffts_lut_twiddle(tw, n, j, w1[j]);
+					ffts_lut_twiddle(tw, n, j + (n/8), w2[j]);
 				}
 
 				float *fw0 = (float *)w0;
 				float *fw1 = (float *)w1;
 				float *fw2 = (float *)w2;
-				#ifdef __arm__
+				#if defined(__arm__) || defined(__aarch64__)
 					//w = FFTS_MALLOC(n/8 * 3 * sizeof(cdata_t), 32);
 					float *fw = (float *)w;
 					#ifdef HAVE_NEON	
@@ -351,38 +486,44 @@ ffts_plan_t *ffts_init_1d(size_t N, int sign) {
 					float *fw = (float *)w;
 					V temp0, temp1, temp2, re, im;
 					for(j=0;j<n/8;j+=2) {
+						// the AVX butterflies read four twiddles at a time, so
+						// pairs of 128-bit entries are interleaved
+						float *fwj = fw + j*2*6;
+						size_t st = 4;
+						if(p->isa == FFTS_ISA_AVX2) {
+							fwj = fw + (j/4)*48 + ((j/2)&1)*4;
+							st = 8;
+						}
+
 						temp0 = VLD(fw0 + j*2);
 						re = VDUPRE(temp0);
 						im = VDUPIM(temp0);
 						im = VXOR(im, MULI_SIGN);
-						VST(fw + j*2*6  , re);
-						VST(fw + j*2*6+4, im);
+						VST(fwj       , re);
+						VST(fwj + 1*st, im);
 
 						temp1 = VLD(fw1 + j*2);
 						re = VDUPRE(temp1);
 						im = VDUPIM(temp1);
 						im = VXOR(im, MULI_SIGN);
-						VST(fw + j*2*6+8 , re);
-						VST(fw + j*2*6+12, im);
+						VST(fwj + 2*st, re);
+						VST(fwj + 3*st, im);
 
 						temp2 = VLD(fw2 + j*2);
 						re = VDUPRE(temp2);
 						im = VDUPIM(temp2);
 						im = VXOR(im, MULI_SIGN);
-						VST(fw + j*2*6+16, re);
-						VST(fw + j*2*6+20, im);
+						VST(fwj + 4*st, re);
+						VST(fwj + 5*st, im);
 					}
 					w += n/8 * 3 * 2;
 				#endif
-
-				FFTS_FREE(w0);
-				FFTS_FREE(w1);
-				FFTS_FREE(w2);
 			}
 			///p->ws[i] = w;
 
 			n *= 2;
 		}
+		if(w0) FFTS_FREE(w0);
 
 	float *tmp = (float *)p->ws;
 
@@ -397,15 +538,13 @@ ffts_plan_t *ffts_init_1d(size_t N, int sign) {
 	}
 
 	p->N = N;
+	p->io_bytes = sizeof(float) * 4*N;
+	p->sign = sign;
 	p->lastlut = w;
 	p->n_luts = n_luts;
+	if(ffts_plan_arena_enabled()) p = ffts_arena_pack_1d(p, leafN, lut_size);
 #ifdef DYNAMIC_DISABLED
-	if(sign < 0) { 
-		if(N >= 32) p->transform = ffts_static_transform_f; 
-	}else{
-		if(N >= 32) p->transform = ffts_static_transform_i; 
-	}
-
+	if(N >= 32) p->transform = ffts_static_select(N, sign);
 #else
 	if(N>=32)  ffts_generate_func_code(p, N, leafN, sign);
 #endif
@@ -66,9 +66,6 @@ static const __attribute__ ((aligned(64))) float w_data[16] = {
 	0.0f,									0.70710678118654746171500846685376
 };
 
-__INLINE float W_re(float N, float k) { return cos(-2.0f * PI * k / N); }
-__INLINE float W_im(float N, float k) { return sin(-2.0f * PI * k / N); }
-
 typedef size_t transform_index_t;
 
 //typedef void (*transform_func_t)(float *data, size_t N, float *LUT);
@@ -176,11 +173,77 @@ struct _ffts_plan_t {
 	float *A, *B;
 			
 	size_t i2;
+
+	/**
+	 * Batched transforms: number of transforms, and the
+	 * element stride / distance between consecutive transforms
+	 * for the input and output (in complex elements)
+	 */
+	size_t howmany, istride, idist, ostride, odist;
+
+	/**
+	 * Worker threads for threaded multi-dimensional plans
+	 */
+	void *pool;
+
+	/**
+	 * Direction of the transform, and the odd radices
+	 * (zero terminated) for mixed-radix transforms
+	 */
+	int sign;
+	size_t *factors;
+
+	/**
+	 * Kernel set used by the plan (FFTS_ISA_*). For AVX2 the
+	 * twiddle factors are laid out for the 256-bit butterflies
+	 */
+	int isa;
+
+	/**
+	 * Plan cache entry this plan shares its tables
+	 * and code with, or NULL
+	 */
+	void *cache_entry;
+
+	/**
+	 * Working memory written during execution: the bytes used
+	 * of buf and transpose_buf, and the number of plans in plans
+	 * (-1 for plans that keep state between calls). With these
+	 * ffts_execute_scratch runs the plan on caller memory
+	 */
+	size_t buf_size, transpose_buf_size;
+	int nplans;
+
+	/**
+	 * Block from ffts_arena_alloc holding this plan and its
+	 * tables, or NULL if they were allocated separately
+	 */
+	void *arena;
+
+	/**
+	 * Bytes of input read and output written by one execute
+	 * call, and the counters kept with FFTS_INSTRUMENT
+	 * (see ffts_stats.h)
+	 */
+	size_t io_bytes;
+	uint64_t calls, cycles, bytes;
+
+	/**
+	 * Pruned transforms: the mode (FFTS_PRUNED_*), and the plan's
+	 * own buf, whose zero tails are cleared once; scratch from
+	 * ffts_execute_scratch is cleared on each call instead
+	 */
+	int pruned;
+	void *pruned_buf;
 };
 
 
 void ffts_free(ffts_plan_t *);
 ffts_plan_t *ffts_init_1d(size_t N, int sign); 
+ffts_plan_t *ffts_init_1d_pow2(size_t N, int sign);
+void ffts_free_1d(ffts_plan_t *);
 void ffts_execute(ffts_plan_t *, const void *, void *);
+size_t ffts_scratch_size(ffts_plan_t *);
+void ffts_execute_scratch(ffts_plan_t *, const void *, void *, void *);
 #endif
 // vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
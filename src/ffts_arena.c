@@ -0,0 +1,141 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_arena.h"
+#include "macros.h"
+
+#include <sys/mman.h>
+
+/*
+ * An arena is a single block holding a plan and all of its tables, so that
+ * a transform reads a few contiguous pages instead of half a dozen separate
+ * allocations. Each block starts with a header recording where it came
+ * from, so that it is returned to the same allocator even if another one
+ * has been set since.
+ */
+typedef struct {
+	ffts_free_func free;
+	void *ctx;
+	size_t size;
+	int kind;
+} ffts_arena_header_t;
+
+#define ARENA_MALLOC 0
+#define ARENA_MMAP   1
+#define ARENA_USER   2
+
+#define ARENA_HEADER FFTS_ARENA_SIZE(sizeof(ffts_arena_header_t))
+#define HUGE_PAGE    ((size_t)2 << 20)
+
+static ffts_alloc_func ffts_arena_alloc_fn = NULL;
+static ffts_free_func ffts_arena_free_fn = NULL;
+static void *ffts_arena_ctx = NULL;
+static volatile int ffts_arena_flags = 0;
+
+void ffts_set_allocator(ffts_alloc_func alloc, ffts_free_func free, void *ctx) {
+	if(!alloc || !free) alloc = NULL, free = NULL, ctx = NULL;
+	ffts_arena_alloc_fn = alloc;
+	ffts_arena_free_fn = free;
+	ffts_arena_ctx = ctx;
+}
+
+void ffts_plan_arena_enable(int flags) {
+	ffts_arena_flags = flags;
+}
+
+int ffts_plan_arena_enabled(void) {
+	return ffts_arena_flags || ffts_arena_alloc_fn;
+}
+
+// Huge pages are only worth it for blocks of a good part of one; smaller
+// blocks stay on normal pages.
+static void *ffts_arena_map(size_t *size) {
+	void *m = MAP_FAILED;
+	size_t s;
+
+	if(*size < HUGE_PAGE / 2) return NULL;
+	s = (*size + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+#ifdef MAP_HUGETLB
+	m = mmap(NULL, s, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+	if(m == MAP_FAILED) {
+		m = mmap(NULL, s, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(m == MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+		madvise(m, s, MADV_HUGEPAGE);
+#endif
+	}
+	*size = s;
+	return m;
+}
+
+void *ffts_arena_alloc(size_t size) {
+	ffts_arena_header_t *h = NULL;
+	int kind;
+
+	size += ARENA_HEADER;
+	if(ffts_arena_alloc_fn) {
+		kind = ARENA_USER;
+		h = ffts_arena_alloc_fn(size, FFTS_ARENA_ALIGN, ffts_arena_ctx);
+		if(h) {
+			h->free = ffts_arena_free_fn;
+			h->ctx = ffts_arena_ctx;
+		}
+	}else{
+		kind = ARENA_MMAP;
+		if(ffts_arena_flags & FFTS_ARENA_HUGEPAGES) h = ffts_arena_map(&size);
+		if(!h) {
+			kind = ARENA_MALLOC;
+			h = FFTS_MALLOC(size, FFTS_ARENA_ALIGN);
+		}
+	}
+	if(!h) return NULL;
+
+	h->size = size;
+	h->kind = kind;
+	return (uint8_t *)h + ARENA_HEADER;
+}
+
+void ffts_arena_free(void *block) {
+	ffts_arena_header_t *h;
+
+	if(!block) return;
+	h = (ffts_arena_header_t *)((uint8_t *)block - ARENA_HEADER);
+	switch(h->kind) {
+		case ARENA_USER: h->free(h, h->size, h->ctx); break;
+		case ARENA_MMAP: munmap(h, h->size); break;
+		default:         FFTS_FREE(h); break;
+	}
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
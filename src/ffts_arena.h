@@ -0,0 +1,66 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef __FFTS_ARENA_H__
+#define __FFTS_ARENA_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ffts.h"
+
+#define FFTS_ARENA_ALIGN 64
+#define FFTS_ARENA_ON         1
+#define FFTS_ARENA_HUGEPAGES  2
+
+/* bytes taken by a table of the given size in an arena */
+#define FFTS_ARENA_SIZE(x) (((x) + FFTS_ARENA_ALIGN - 1) & ~(size_t)(FFTS_ARENA_ALIGN - 1))
+
+typedef void *(*ffts_alloc_func)(size_t size, size_t align, void *ctx);
+typedef void (*ffts_free_func)(void *ptr, size_t size, void *ctx);
+
+void ffts_set_allocator(ffts_alloc_func alloc, ffts_free_func free, void *ctx);
+void ffts_plan_arena_enable(int flags);
+
+/* nonzero if plans are to be laid out in arenas */
+int ffts_plan_arena_enabled(void);
+
+/* a FFTS_ARENA_ALIGN aligned, uninitialised block of size bytes, taken
+ * from the allocator set at the time; released with ffts_arena_free */
+void *ffts_arena_alloc(size_t size);
+void ffts_arena_free(void *block);
+
+#endif
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
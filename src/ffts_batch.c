@@ -0,0 +1,146 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_batch.h"
+#include "ffts_lanes.h"
+
+void ffts_free_1d_batch(ffts_plan_t *p) {
+	ffts_free(p->plans[0]);
+	free(p->plans);
+	free(p->buf);
+	free(p->ws);
+	free(p);
+}
+
+// transforms first to howmany-1, one at a time
+static void ffts_batch_run(ffts_plan_t *p, const void *vin, void *vout, size_t first) {
+	const uint64_t *in = (const uint64_t *)vin;
+	uint64_t *out = (uint64_t *)vout;
+	ffts_plan_t *t = p->plans[0];
+	size_t N = p->N;
+	size_t Ns = N + (N & 1);
+	uint64_t *ibuf = (uint64_t *)p->buf;
+	uint64_t *obuf = ibuf + FFTS_BATCH_GROUP * Ns;
+
+	// The transforms need 16 byte aligned, unit stride data; anything else
+	// is staged through the plan's buffer. Up to FFTS_BATCH_GROUP transforms
+	// are gathered (and scattered) together, so that when the transforms are
+	// interleaved (e.g. the columns of a matrix) every row of the source is
+	// read once per group rather than once per transform.
+	int gather  = p->istride != 1 || (p->idist & 1);
+	int scatter = p->ostride != 1 || (p->odist & 1);
+
+	size_t i, j, b;
+	for(i=first;i<p->howmany;i+=FFTS_BATCH_GROUP) {
+		size_t nb = (i + FFTS_BATCH_GROUP < p->howmany) ? FFTS_BATCH_GROUP : p->howmany - i;
+		const uint64_t *src = in + i * p->idist;
+		uint64_t *dst = out + i * p->odist;
+
+		if(gather) {
+			for(j=0;j<N;j++) {
+				const uint64_t *s = src + j * p->istride;
+				for(b=0;b<nb;b++) ibuf[b*Ns + j] = s[b * p->idist];
+			}
+		}
+
+		for(b=0;b<nb;b++) {
+			t->transform(t, gather ? ibuf + b*Ns : src + b * p->idist,
+			                scatter ? obuf + b*Ns : dst + b * p->odist);
+		}
+
+		if(scatter) {
+			for(j=0;j<N;j++) {
+				uint64_t *d = dst + j * p->ostride;
+				for(b=0;b<nb;b++) d[b * p->odist] = obuf[b*Ns + j];
+			}
+		}
+	}
+}
+
+void ffts_execute_1d_batch(ffts_plan_t *p, const void *in, void *out) {
+	ffts_batch_run(p, in, out, 0);
+}
+
+// small transforms in vector lanes (see ffts_lanes.c), and the rest as usual
+void ffts_execute_1d_lanes(ffts_plan_t *p, const void *in, void *out) {
+	size_t done = ffts_lanes_execute(p, (const float *)in, (float *)out);
+	if(done < p->howmany) ffts_batch_run(p, in, out, done);
+}
+
+ffts_plan_t *ffts_init_1d_batch(size_t N, int sign, size_t howmany,
+                                size_t istride, size_t idist,
+                                size_t ostride, size_t odist) {
+	if(!howmany || !istride || !ostride) {
+		LOG("Batch count and strides must be non-zero\n");
+		return NULL;
+	}
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->transform = &ffts_execute_1d_batch;
+	p->destroy = &ffts_free_1d_batch;
+	p->N = N;
+	p->io_bytes = sizeof(float) * 4*N * howmany;
+	p->rank = 1;
+	p->sign = sign;
+	p->howmany = howmany;
+	p->istride = istride;
+	p->idist = idist;
+	p->ostride = ostride;
+	p->odist = odist;
+
+	p->plans = malloc(sizeof(ffts_plan_t **) * 1);
+	p->plans[0] = ffts_init_1d(N, sign);
+	if(!p->plans[0]) {
+		free(p->plans);
+		free(p);
+		return NULL;
+	}
+
+	p->isa = p->plans[0]->isa;
+	p->buf_size = sizeof(uint64_t) * 2 * FFTS_BATCH_GROUP * (N + (N & 1));
+	p->transpose_buf_size = 0;
+	p->nplans = 1;
+	p->buf = valloc(p->buf_size);
+
+	if(!ffts_lanes_init(p)) p->transform = &ffts_execute_1d_lanes;
+
+	return p;
+}
+
+ffts_plan_t *ffts_init_1d_strided(size_t N, int sign, size_t istride, size_t ostride) {
+	return ffts_init_1d_batch(N, sign, 1, istride, 0, ostride, 0);
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
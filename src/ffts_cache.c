@@ -0,0 +1,201 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_cache.h"
+
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+
+static pthread_mutex_t ffts_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#define CACHE_LOCK()   pthread_mutex_lock(&ffts_cache_lock)
+#define CACHE_UNLOCK() pthread_mutex_unlock(&ffts_cache_lock)
+#else
+#define CACHE_LOCK()
+#define CACHE_UNLOCK()
+#endif
+
+/*
+ * Each entry owns a complete plan (the master). The plans handed out are
+ * copies of the master's struct, so they point at the same twiddle factors,
+ * offset/index tables and generated code, which are only ever read during
+ * execution. The generated code reaches the plan through its first argument
+ * only, so it runs unchanged on a copy.
+ */
+typedef struct _ffts_cache_entry_t {
+	size_t N;
+	int sign, type, rank;
+	ffts_plan_t *plan;
+	size_t refs;
+	struct _ffts_cache_entry_t *next;
+} ffts_cache_entry_t;
+
+static ffts_cache_entry_t *ffts_cache_head = NULL;
+static volatile int ffts_cache_on = 0;
+
+int ffts_plan_cache_enabled(void) {
+	return ffts_cache_on;
+}
+
+void ffts_plan_cache_enable(int enable) {
+	ffts_cache_on = enable;
+	if(!enable) ffts_plan_cache_clear();
+}
+
+void ffts_plan_cache_clear(void) {
+	CACHE_LOCK();
+	ffts_cache_entry_t **e = &ffts_cache_head;
+	while(*e) {
+		ffts_cache_entry_t *x = *e;
+		if(!x->refs) {
+			*e = x->next;
+			ffts_free(x->plan);
+			free(x);
+		}else{
+			e = &x->next;
+		}
+	}
+	CACHE_UNLOCK();
+}
+
+void ffts_cache_release(ffts_plan_t *p) {
+	ffts_cache_entry_t *e = (ffts_cache_entry_t *)p->cache_entry;
+
+	CACHE_LOCK();
+	e->refs--;
+	CACHE_UNLOCK();
+
+	// entries outlive their last plan so the next request for the same
+	// size is a hit; they are freed by ffts_plan_cache_clear
+	if(!ffts_cache_on) ffts_plan_cache_clear();
+	free(p);
+}
+
+ffts_plan_t *ffts_cache_init_1d(size_t N, int sign) {
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	CACHE_LOCK();
+	ffts_cache_entry_t *e;
+	for(e=ffts_cache_head;e;e=e->next) {
+		if(e->N == N && e->sign == sign && e->type == FFTS_CACHE_COMPLEX && e->rank == 1) break;
+	}
+
+	if(!e) {
+		e = malloc(sizeof(ffts_cache_entry_t));
+		if(e) e->plan = ffts_init_1d_pow2(N, sign);
+		if(!e || !e->plan) {
+			CACHE_UNLOCK();
+			free(e);
+			free(p);
+			return NULL;
+		}
+		e->N = N;
+		e->sign = sign;
+		e->type = FFTS_CACHE_COMPLEX;
+		e->rank = 1;
+		e->refs = 0;
+		e->next = ffts_cache_head;
+		ffts_cache_head = e;
+	}
+	e->refs++;
+	*p = *e->plan;
+	CACHE_UNLOCK();
+
+	p->cache_entry = e;
+	p->destroy = &ffts_cache_release;
+	return p;
+}
+
+int ffts_cache_add_1d(ffts_plan_t *plan) {
+	CACHE_LOCK();
+	ffts_cache_entry_t *e;
+	for(e=ffts_cache_head;e;e=e->next) {
+		if(e->N == plan->N && e->sign == plan->sign && e->type == FFTS_CACHE_COMPLEX && e->rank == 1) break;
+	}
+
+	// a plan already there wins, it may have users
+	if(!e) {
+		e = malloc(sizeof(ffts_cache_entry_t));
+		if(e) {
+			e->N = plan->N;
+			e->sign = plan->sign;
+			e->type = FFTS_CACHE_COMPLEX;
+			e->rank = 1;
+			e->plan = plan;
+			e->refs = 0;
+			e->next = ffts_cache_head;
+			ffts_cache_head = e;
+		}
+		CACHE_UNLOCK();
+		return e ? 1 : -1;
+	}
+	CACHE_UNLOCK();
+	return 0;
+}
+
+ffts_plan_t **ffts_cache_hold(size_t *n) {
+	ffts_plan_t **plans;
+	ffts_cache_entry_t *e;
+	size_t i = 0;
+
+	CACHE_LOCK();
+	for(e=ffts_cache_head;e;e=e->next) i++;
+	plans = malloc(sizeof(ffts_plan_t *) * (i + 1));
+	if(plans) {
+		i = 0;
+		for(e=ffts_cache_head;e;e=e->next) {
+			e->refs++;
+			plans[i++] = e->plan;
+		}
+	}
+	CACHE_UNLOCK();
+
+	*n = plans ? i : 0;
+	return plans;
+}
+
+void ffts_cache_drop(ffts_plan_t **plans, size_t n) {
+	ffts_cache_entry_t *e;
+	size_t i;
+
+	CACHE_LOCK();
+	for(e=ffts_cache_head;e;e=e->next) {
+		for(i=0;i<n;i++) if(plans[i] == e->plan) e->refs--;
+	}
+	CACHE_UNLOCK();
+
+	if(!ffts_cache_on) ffts_plan_cache_clear();
+	free(plans);
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -0,0 +1,156 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_chirp_z.h"
+#include "macros.h"
+
+#include <string.h>
+
+/*
+ * Bluestein's algorithm for sizes that aren't handled by the power-of-two or
+ * mixed-radix plans. With w_n = exp(sign * i*pi * n^2 / N), the DFT becomes
+ *
+ *   X_k = w_k * sum_n (x_n * w_n) * conj(w_(k-n))
+ *
+ * a convolution that is evaluated with power-of-two transforms of size
+ * M >= 2N-1. The transform of the (conjugated) chirp is precomputed and
+ * scaled by 1/M.
+ */
+
+static void ffts_chirp_z_mul(float *out, const float *a, const float *b, size_t n) {
+	size_t i;
+	for(i=0;i+1<n;i+=2) {
+		V t = VLD(b + 2*i);
+		V re = VDUPRE(t);
+		V im = VXOR(VDUPIM(t), VLIT4(-0.0f, 0.0f, -0.0f, 0.0f));
+		VSTU(out + 2*i, IMUL(VLDU(a + 2*i), re, im));
+	}
+	if(i < n) {
+		float re = a[2*i] * b[2*i]   - a[2*i+1] * b[2*i+1];
+		float im = a[2*i] * b[2*i+1] + a[2*i+1] * b[2*i];
+		out[2*i]   = re;
+		out[2*i+1] = im;
+	}
+}
+
+void ffts_free_1d_chirp_z(ffts_plan_t *p) {
+	if(p->plans) {
+		if(p->plans[0]) ffts_free(p->plans[0]);
+		if(p->plans[1]) ffts_free(p->plans[1]);
+		free(p->plans);
+	}
+	FFTS_FREE(p->A);
+	FFTS_FREE(p->B);
+	FFTS_FREE(p->buf);
+	free(p);
+}
+
+void ffts_execute_1d_chirp_z(ffts_plan_t *p, const void *vin, void *vout) {
+	const float *in = (const float *)vin;
+	float *out = (float *)vout;
+	size_t N = p->N;
+	size_t M = p->plans[0]->N;
+	float *buf0 = (float *)p->buf;
+	float *buf1 = buf0 + 2*M;
+
+	ffts_chirp_z_mul(buf0, in, p->A, N);
+	memset(buf0 + 2*N, 0, sizeof(float) * 2 * (M - N));
+
+	p->plans[0]->transform(p->plans[0], buf0, buf1);
+	ffts_chirp_z_mul(buf1, buf1, p->B, M);
+	p->plans[1]->transform(p->plans[1], buf1, buf0);
+
+	ffts_chirp_z_mul(out, buf0, p->A, N);
+}
+
+ffts_plan_t *ffts_init_1d_chirp_z(size_t N, int sign) {
+	size_t M = 1, i;
+	while(M < 2*N - 1) M <<= 1;
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->transform = &ffts_execute_1d_chirp_z;
+	p->destroy = &ffts_free_1d_chirp_z;
+	p->N = N;
+	p->io_bytes = sizeof(float) * 4*N;
+	p->rank = 1;
+	p->sign = sign;
+
+	p->plans = calloc(2, sizeof(ffts_plan_t *));
+	if(!p->plans) {
+		free(p);
+		return NULL;
+	}
+	p->plans[0] = ffts_init_1d(M, -1);
+	p->plans[1] = ffts_init_1d(M, 1);
+
+	p->A = FFTS_MALLOC(sizeof(float) * 2 * (N + 1), 32);
+	p->B = FFTS_MALLOC(sizeof(float) * 2 * M, 32);
+	p->buf_size = sizeof(float) * 2 * 2 * M;
+	p->transpose_buf_size = 0;
+	p->nplans = 2;
+	p->buf = FFTS_MALLOC(p->buf_size, 32);
+
+	if(!p->plans[0] || !p->plans[1] || !p->A || !p->B || !p->buf) {
+		ffts_free_1d_chirp_z(p);
+		return NULL;
+	}
+
+	p->isa = p->plans[0]->isa;
+
+	// n^2 is reduced mod 2N to keep the angles accurate for large N
+	for(i=0;i<N;i++) {
+		double a = sign * PI * (double)((i * i) % (2 * N)) / (double)N;
+		p->A[2*i]   = cos(a);
+		p->A[2*i+1] = sin(a);
+	}
+
+	float *b = (float *)p->buf;
+	memset(b, 0, sizeof(float) * 2 * M);
+	for(i=0;i<N;i++) {
+		b[2*i]   =  p->A[2*i];
+		b[2*i+1] = -p->A[2*i+1];
+		if(i) {
+			b[2*(M-i)]   = b[2*i];
+			b[2*(M-i)+1] = b[2*i+1];
+		}
+	}
+
+	p->plans[0]->transform(p->plans[0], b, p->B);
+	for(i=0;i<2*M;i++) p->B[i] /= (float)M;
+
+	return p;
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
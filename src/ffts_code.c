@@ -0,0 +1,368 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_code.h"
+#include "ffts_cpu.h"
+
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#ifdef __APPLE__
+#include <libkern/OSCacheControl.h>
+#endif
+
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+
+static pthread_mutex_t ffts_code_lock = PTHREAD_MUTEX_INITIALIZER;
+#define CODE_LOCK()   pthread_mutex_lock(&ffts_code_lock)
+#define CODE_UNLOCK() pthread_mutex_unlock(&ffts_code_lock)
+#else
+#define CODE_LOCK()
+#define CODE_UNLOCK()
+#endif
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/*
+ * Generated code is packed into shared chunks instead of a mapping per
+ * plan. Each chunk is a memory file mapped twice: read/write, where the
+ * code is written, and read/execute, where it runs, so no page is ever
+ * both writable and executable and nothing is mprotect'ed. The code is
+ * position independent within itself (calls are relative, everything
+ * else is reached through the plan) and both views are page aligned, so
+ * it runs unchanged at the other address. Chunks are handed out first
+ * fit in lines of CODE_LINE bytes, and plans give back what they don't
+ * use once they're generated. Code larger than a chunk gets a chunk of
+ * its own. Where memory files aren't available each plan gets its own
+ * mapping, flipped to read/execute once it's written, as before.
+ *
+ * The chunks stay shared with a forked child, but the free lists don't,
+ * so a child that kept allocating from them would write over the code of
+ * plans the parent builds later, and the other way round. The child moves
+ * the chunks it inherits to a list of their own: they stay mapped for the
+ * plans it inherited, which it can still run and free, but it never
+ * allocates from them or unmaps them.
+ */
+#define CODE_LINE  64
+#define CODE_CHUNK ((size_t)256 << 10)
+
+typedef struct _ffts_code_extent_t {
+	size_t off, size;
+	struct _ffts_code_extent_t *next;
+} ffts_code_extent_t;
+
+typedef struct _ffts_code_chunk_t {
+	uint8_t *rx, *rw;
+	size_t size, used;
+	ffts_code_extent_t *free;
+	struct _ffts_code_chunk_t *next;
+} ffts_code_chunk_t;
+
+static ffts_code_chunk_t *ffts_code_chunks = NULL;
+static ffts_code_chunk_t *ffts_code_inherited = NULL;
+static int ffts_code_pooled = -1;
+static pid_t ffts_code_pid;
+
+// in a forked child: stop allocating from the parent's chunks
+static void ffts_code_forked(void) {
+	ffts_code_chunk_t **l = &ffts_code_inherited;
+
+	while(*l) l = &(*l)->next;
+	*l = ffts_code_chunks;
+	ffts_code_chunks = NULL;
+	ffts_code_pid = getpid();
+}
+
+#ifdef HAVE_LIBPTHREAD
+static void ffts_code_fork_prepare(void) { CODE_LOCK(); }
+static void ffts_code_fork_parent(void) { CODE_UNLOCK(); }
+static void ffts_code_fork_child(void) {
+	ffts_code_forked();
+	CODE_UNLOCK();
+}
+#endif
+
+static int ffts_code_memfd(void) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+	return syscall(SYS_memfd_create, "ffts-code", 1 /* MFD_CLOEXEC */);
+#else
+	return -1;
+#endif
+}
+
+static ffts_code_chunk_t *ffts_code_chunk(size_t size) {
+	ffts_code_chunk_t *c;
+	void *rw = MAP_FAILED, *rx = MAP_FAILED;
+	int fd;
+
+	size_t page = sysconf(_SC_PAGESIZE);
+	size = (size + page - 1) & ~(page - 1);
+
+	fd = ffts_code_memfd();
+	if(fd < 0) return NULL;
+	if(!ftruncate(fd, size)) {
+		rw = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		rx = mmap(NULL, size, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+
+	c = malloc(sizeof(ffts_code_chunk_t));
+	if(!c || !(c->free = malloc(sizeof(ffts_code_extent_t))) ||
+	   rw == MAP_FAILED || rx == MAP_FAILED) {
+		if(rw != MAP_FAILED) munmap(rw, size);
+		if(rx != MAP_FAILED) munmap(rx, size);
+		if(c) free(c->free);
+		free(c);
+		return NULL;
+	}
+	c->rw = rw;
+	c->rx = rx;
+	c->size = size;
+	c->used = 0;
+	c->free->off = 0;
+	c->free->size = size;
+	c->free->next = NULL;
+	c->next = ffts_code_chunks;
+	ffts_code_chunks = c;
+	return c;
+}
+
+static ffts_code_chunk_t *ffts_code_find(ffts_code_chunk_t *c, const uint8_t *code) {
+	for(;c;c=c->next) {
+		if(code >= c->rx && code < c->rx + c->size) return c;
+	}
+	return NULL;
+}
+
+static int ffts_code_take(ffts_code_chunk_t *c, size_t size, size_t *off) {
+	ffts_code_extent_t **e, *x;
+
+	for(e=&c->free;*e;e=&(*e)->next) {
+		if((*e)->size < size) continue;
+		x = *e;
+		*off = x->off;
+		x->off += size;
+		x->size -= size;
+		if(!x->size) {
+			*e = x->next;
+			free(x);
+		}
+		c->used += size;
+		return 1;
+	}
+	return 0;
+}
+
+// Returns size bytes at off to the chunk, merging with the free extents
+// either side. Chunks that become empty are unmapped, except for one of
+// the usual size, kept for the next plan.
+static void ffts_code_give(ffts_code_chunk_t *c, size_t off, size_t size) {
+	ffts_code_extent_t **e = &c->free, *prev = NULL, *x;
+
+	while(*e && (*e)->off < off) {
+		prev = *e;
+		e = &(*e)->next;
+	}
+	if(prev && prev->off + prev->size == off) {
+		prev->size += size;
+		x = prev;
+	}else{
+		x = malloc(sizeof(ffts_code_extent_t));
+		if(!x) return; // the space is lost, not the chunk
+		x->off = off;
+		x->size = size;
+		x->next = *e;
+		*e = x;
+	}
+	if(x->next && x->off + x->size == x->next->off) {
+		ffts_code_extent_t *n = x->next;
+		x->size += n->size;
+		x->next = n->next;
+		free(n);
+	}
+	c->used -= size;
+
+	if(!c->used && (c != ffts_code_chunks || c->next || c->size > CODE_CHUNK)) {
+		ffts_code_chunk_t **l;
+		for(l=&ffts_code_chunks;*l!=c;l=&(*l)->next);
+		*l = c->next;
+		free(c->free);
+		munmap(c->rw, c->size);
+		munmap(c->rx, c->size);
+		free(c);
+	}
+}
+
+void *ffts_code_alloc(size_t size, void **rw) {
+	ffts_code_chunk_t *c = NULL;
+	size_t off;
+	void *code;
+
+	size = (size + CODE_LINE - 1) & ~(size_t)(CODE_LINE - 1);
+
+	CODE_LOCK();
+	if(ffts_code_pooled < 0) {
+		int fd = ffts_code_memfd();
+		ffts_code_pooled = (fd >= 0);
+		if(fd >= 0) close(fd);
+		ffts_code_pid = getpid();
+#ifdef HAVE_LIBPTHREAD
+		if(ffts_code_pooled) {
+			pthread_atfork(&ffts_code_fork_prepare, &ffts_code_fork_parent, &ffts_code_fork_child);
+		}
+#endif
+	}
+#ifndef HAVE_LIBPTHREAD
+	if(ffts_code_pooled && ffts_code_pid != getpid()) ffts_code_forked();
+#endif
+	if(ffts_code_pooled) {
+		for(c=ffts_code_chunks;c;c=c->next) {
+			if(ffts_code_take(c, size, &off)) break;
+		}
+		if(!c && (c = ffts_code_chunk(size > CODE_CHUNK ? size : CODE_CHUNK))) {
+			ffts_code_take(c, size, &off);
+		}
+	}
+	CODE_UNLOCK();
+
+	if(c) {
+		*rw = c->rw + off;
+		return c->rx + off;
+	}
+	if(ffts_code_pooled) return NULL;
+
+	code = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(code == MAP_FAILED) return NULL;
+	*rw = code;
+	return code;
+}
+
+size_t ffts_code_commit(void *code, void *rw, size_t size, size_t used) {
+	ffts_code_chunk_t *c;
+
+	size = (size + CODE_LINE - 1) & ~(size_t)(CODE_LINE - 1);
+	used = (used + CODE_LINE - 1) & ~(size_t)(CODE_LINE - 1);
+
+	if(code == rw) {
+		if(mprotect(code, size, PROT_READ | PROT_EXEC)) return 0;
+	}else if(used < size) {
+		CODE_LOCK();
+		c = ffts_code_find(ffts_code_chunks, code);
+		if(c) ffts_code_give(c, (uint8_t *)code - c->rx + used, size - used);
+		CODE_UNLOCK();
+		size = used;
+	}
+
+#ifdef __APPLE__
+	sys_icache_invalidate(code, size);
+#elif __ANDROID__
+	cacheflush((long)(code), (long)(code) + size, 0);
+#elif __linux__
+#ifdef __GNUC__
+	__builtin___clear_cache((char *)code, (char *)code + size);
+#endif
+#endif
+	return size;
+}
+
+void ffts_code_free(void *code, size_t size) {
+	ffts_code_chunk_t *c;
+	int inherited = 0;
+
+	CODE_LOCK();
+	c = ffts_code_find(ffts_code_chunks, code);
+	if(c) ffts_code_give(c, (uint8_t *)code - c->rx, size);
+	else inherited = (ffts_code_find(ffts_code_inherited, code) != NULL);
+	CODE_UNLOCK();
+
+	// code inherited from the parent stays where it is
+	if(!c && !inherited) munmap(code, size);
+}
+
+/*
+ * Perf map: with FFTS_PERF_MAP set in the environment (to anything but
+ * 0), or after ffts_perf_map_enable(1), every region of generated code
+ * is appended to /tmp/perf-<pid>.map as "start size name", which perf
+ * report and most other sampling profilers read to name addresses in
+ * JIT code. Names are ffts_<N>_<fwd|inv>_<kernel set>_<region>. Code
+ * is often reused by later plans at the same address; profilers take
+ * the newest line that covers an address.
+ */
+static int ffts_perf_map = -1;
+static FILE *ffts_perf_map_file = NULL;
+static pid_t ffts_perf_map_pid;
+
+void ffts_perf_map_enable(int enable) {
+	CODE_LOCK();
+	ffts_perf_map = (enable != 0);
+	CODE_UNLOCK();
+}
+
+void ffts_code_label(ffts_plan_t *p, const ffts_code_region_t *r, int n) {
+	const uint8_t *code = (const uint8_t *)p->transform_base;
+	char path[64];
+	int i;
+
+	CODE_LOCK();
+	if(ffts_perf_map < 0) {
+		const char *e = getenv("FFTS_PERF_MAP");
+		ffts_perf_map = (e && *e && strcmp(e, "0"));
+	}
+	// a forked child writes its own map
+	if(ffts_perf_map && (!ffts_perf_map_file || ffts_perf_map_pid != getpid())) {
+		if(ffts_perf_map_file) fclose(ffts_perf_map_file);
+		ffts_perf_map_pid = getpid();
+		snprintf(path, sizeof(path), "/tmp/perf-%ld.map", (long)ffts_perf_map_pid);
+		ffts_perf_map_file = fopen(path, "a");
+	}
+	if(ffts_perf_map && ffts_perf_map_file && code) {
+		for(i=0;i<n;i++) {
+			size_t end = (i + 1 < n) ? r[i+1].off : p->transform_size;
+			if(!r[i].name || end <= r[i].off) continue;
+			fprintf(ffts_perf_map_file, "%" PRIxPTR " %zx ffts_%zu_%s_%s_%s\n",
+			        (uintptr_t)(code + r[i].off), end - r[i].off, p->N,
+			        (p->sign < 0) ? "fwd" : "inv", ffts_isa_name(p->isa), r[i].name);
+		}
+		fflush(ffts_perf_map_file);
+	}
+	CODE_UNLOCK();
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -0,0 +1,69 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef __FFTS_CODE_H__
+#define __FFTS_CODE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ffts.h"
+
+/* reserves size bytes for generated code, to be written at *rw; returns
+ * the address the code will run from, or NULL */
+void *ffts_code_alloc(size_t size, void **rw);
+
+/* makes the first used bytes of a reservation ready to run and gives back
+ * the rest; returns the size to pass to ffts_code_free, or 0 on error */
+size_t ffts_code_commit(void *code, void *rw, size_t size, size_t used);
+
+void ffts_code_free(void *code, size_t size);
+
+/* a region of a plan's generated code, from off (in bytes) up to the
+ * next region, or the end of the code for the last one; a NULL name
+ * marks the end of the region before it */
+typedef struct {
+	size_t off;
+	const char *name;
+} ffts_code_region_t;
+
+/* names the regions of p's generated code for profilers, in ascending
+ * order of off; empty regions are skipped */
+void ffts_code_label(ffts_plan_t *p, const ffts_code_region_t *r, int n);
+
+void ffts_perf_map_enable(int enable);
+
+#endif
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -0,0 +1,291 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_conv.h"
+#include "ffts_real.h"
+#include "ffts_stats.h"
+#include "macros.h"
+
+#include <string.h>
+
+/*
+ * Streaming FIR filtering with partitioned overlap-save convolution.
+ *
+ * The filter is split into levels. Level k uses blocks of Bk = block * 2^k
+ * samples (up to FFTS_CONV_MAX_BLOCK) and holds P partitions of Bk taps,
+ * starting at tap Ok: FFTS_CONV_PARTITIONS partitions per level, and the last
+ * level takes whatever is left. Every Bk input samples, level k transforms
+ * the last 2*Bk inputs with a real plan of size 2*Bk, keeps the spectrum in
+ * its frequency-domain delay line, multiply-accumulates the delay line with
+ * the partition spectra, and adds the second half of the inverse transform
+ * into the output ring, Ok samples later. As Ok >= Bk - block, a level's
+ * output is always in the ring before it is due, so the latency is a single
+ * block whatever the filter length.
+ *
+ * All the buffers are allocated by ffts_init_conv; the spectra hold two
+ * complex values per 8 floats in the layout IMUL takes.
+ */
+
+typedef struct {
+	size_t B, O, P, cur;
+	ffts_plan_t *fwd, *inv;
+	float *H;   // P partition spectra, (B + 2) complex each in IMUL layout
+	float *X;   // delay line, P spectra of B + 2 complex
+	float *Y;   // accumulated spectrum
+	float *t;   // 2B time domain samples
+} ffts_conv_level_t;
+
+typedef struct {
+	size_t block, pos, time;
+	size_t Rin, Rout;
+	int nlevels;
+	ffts_conv_level_t *levels;
+	float *in_ring, *out_ring;
+	float *inblk, *outblk;
+} ffts_conv_t;
+
+static void ffts_conv_mac(float *y, const float *x, const float *h, size_t n) {
+	size_t i;
+	for(i=0;i<n;i+=2) {
+		V a = VLD(y + 2*i);
+		V r = IMUL(VLD(x + 2*i), VLD(h + 4*i), VLD(h + 4*i + 4));
+		VST(y + 2*i, VADD(a, r));
+	}
+}
+
+static void ffts_conv_level(ffts_conv_t *c, ffts_conv_level_t *l) {
+	size_t B = l->B, S = B + 2, N = 2 * B;
+	size_t i, j, start = c->time - N;
+
+	// the last 2B inputs; before the start of the stream the ring is zero
+	for(i=0;i<N;i++) l->t[i] = c->in_ring[(start + i) & (c->Rin - 1)];
+
+	l->cur = (l->cur + 1) % l->P;
+	l->fwd->transform(l->fwd, l->t, l->X + 2*S*l->cur);
+
+	memset(l->Y, 0, sizeof(float) * 2 * S);
+	for(j=0;j<l->P;j++) {
+		size_t slot = (l->cur + l->P - j) % l->P;
+		ffts_conv_mac(l->Y, l->X + 2*S*slot, l->H + 4*S*j, S);
+	}
+	l->inv->transform(l->inv, l->Y, l->t);
+
+	// outputs for times [time - B, time), delayed by the level's offset
+	start = c->time - B + l->O;
+	for(i=0;i<B;i++) c->out_ring[(start + i) & (c->Rout - 1)] += l->t[B + i];
+}
+
+static void ffts_conv_block(ffts_conv_t *c) {
+	size_t i, B = c->block;
+	int k;
+
+	for(i=0;i<B;i++) c->in_ring[(c->time + i) & (c->Rin - 1)] = c->inblk[i];
+	c->time += B;
+
+	for(k=0;k<c->nlevels;k++) {
+		if(!(c->time % c->levels[k].B)) ffts_conv_level(c, c->levels + k);
+	}
+
+	for(i=0;i<B;i++) {
+		float *o = c->out_ring + ((c->time - B + i) & (c->Rout - 1));
+		c->outblk[i] = *o;
+		*o = 0.0f;
+	}
+}
+
+static void ffts_conv_run(ffts_plan_t *p, const float *in, float *out, size_t n) {
+	ffts_conv_t *c = (ffts_conv_t *)p->buf;
+	size_t i;
+
+	// out lags in by one block; in and out may be the same buffer
+	for(i=0;i<n;i++) {
+		float x = in[i];
+		out[i] = c->outblk[c->pos];
+		c->inblk[c->pos] = x;
+		if(++c->pos == c->block) {
+			ffts_conv_block(c);
+			c->pos = 0;
+		}
+	}
+}
+
+void ffts_execute_conv(ffts_plan_t *p, const float *in, float *out, size_t n) {
+	FFTS_STATS_BEGIN(t);
+	ffts_conv_run(p, in, out, n);
+	FFTS_STATS_END(p, t, sizeof(float) * 2*n);
+}
+
+void ffts_execute_1d_conv(ffts_plan_t *p, const void *in, void *out) {
+	ffts_conv_run(p, (const float *)in, (float *)out, p->N);
+}
+
+void ffts_free_conv(ffts_plan_t *p) {
+	ffts_conv_t *c = (ffts_conv_t *)p->buf;
+	int k;
+
+	if(c) {
+		for(k=0;k<c->nlevels;k++) {
+			ffts_conv_level_t *l = c->levels + k;
+			if(l->fwd) ffts_free(l->fwd);
+			if(l->inv) ffts_free(l->inv);
+			free(l->H);
+			free(l->X);
+			free(l->Y);
+			free(l->t);
+		}
+		free(c->levels);
+		free(c->in_ring);
+		free(c->out_ring);
+		free(c->inblk);
+		free(c->outblk);
+		free(c);
+	}
+	free(p);
+}
+
+static int ffts_conv_init_level(ffts_conv_level_t *l, const float *taps, size_t ntaps) {
+	size_t B = l->B, S = B + 2, N = 2 * B;
+	size_t i, j;
+
+	l->fwd = ffts_init_1d_real(N, -1);
+	l->inv = ffts_init_1d_real(N, 1);
+	l->H = valloc(sizeof(float) * 4 * S * l->P);
+	l->X = valloc(sizeof(float) * 2 * S * l->P);
+	l->Y = valloc(sizeof(float) * 2 * S);
+	l->t = valloc(sizeof(float) * N);
+	if(!l->fwd || !l->inv || !l->H || !l->X || !l->Y || !l->t) return -1;
+
+	memset(l->X, 0, sizeof(float) * 2 * S * l->P);
+	l->cur = 0;
+
+	// partition j holds taps O + j*B .. O + (j+1)*B, zero padded to 2B and
+	// scaled by 1/2B for the unnormalized inverse
+	for(j=0;j<l->P;j++) {
+		float *h = l->H + 4*S*j;
+		for(i=0;i<N;i++) {
+			size_t k = l->O + j*B + i;
+			l->t[i] = (i < B && k < ntaps) ? taps[k] / (float)N : 0.0f;
+		}
+		l->fwd->transform(l->fwd, l->t, l->Y);
+		l->Y[2*(B+1)] = l->Y[2*(B+1)+1] = 0.0f;
+		for(i=0;i<S;i+=2) {
+			float *w = h + 4*i;
+			w[0] = w[1] = l->Y[2*i];
+			w[2] = w[3] = l->Y[2*i+2];
+			w[4] = l->Y[2*i+1];   w[5] = -l->Y[2*i+1];
+			w[6] = l->Y[2*i+3];   w[7] = -l->Y[2*i+3];
+		}
+	}
+	return 0;
+}
+
+ffts_plan_t *ffts_init_conv(const float *taps, size_t ntaps, size_t block) {
+	if(block < 8 || (block & (block - 1)) != 0) {
+		LOG("Convolution block size must be a power of two of at least 8\n");
+		return NULL;
+	}
+	if(!ntaps) return NULL;
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->transform = &ffts_execute_1d_conv;
+	p->destroy = &ffts_free_conv;
+	p->N = block;
+	p->io_bytes = sizeof(float) * 2*block;
+	p->rank = 1;
+	p->sign = -1;
+	p->plans = NULL;
+
+	ffts_conv_t *c = calloc(1, sizeof(ffts_conv_t));
+	p->buf = c;
+	p->nplans = -1;
+	if(!c) {
+		ffts_free_conv(p);
+		return NULL;
+	}
+	c->block = block;
+
+	// lay out the levels
+	size_t B = block, O = 0, maxB = block, n = 0;
+	int k;
+	while(O < ntaps) {
+		size_t left = (ntaps - O + B - 1) / B;
+		int last = B >= FFTS_CONV_MAX_BLOCK || left <= FFTS_CONV_PARTITIONS;
+		O += (last ? left : FFTS_CONV_PARTITIONS) * B;
+		if(!last) B *= 2;
+		n++;
+	}
+	c->levels = calloc(n, sizeof(ffts_conv_level_t));
+	if(!c->levels) {
+		ffts_free_conv(p);
+		return NULL;
+	}
+	c->nlevels = n;
+
+	B = block;
+	O = 0;
+	for(k=0;k<c->nlevels;k++) {
+		ffts_conv_level_t *l = c->levels + k;
+		size_t left = (ntaps - O + B - 1) / B;
+		int last = (k == c->nlevels - 1);
+		l->B = B;
+		l->O = O;
+		l->P = last ? left : FFTS_CONV_PARTITIONS;
+		if(ffts_conv_init_level(l, taps, ntaps)) {
+			ffts_free_conv(p);
+			return NULL;
+		}
+		O += l->P * B;
+		maxB = B;
+		if(!last) B *= 2;
+	}
+	p->isa = c->levels[0].fwd->isa;
+
+	// rings for the last 2*maxB inputs, and for the outputs up to the last
+	// level's offset ahead
+	for(c->Rin=1;c->Rin<2*maxB;c->Rin<<=1);
+	for(c->Rout=1;c->Rout<c->levels[n-1].O + maxB + block;c->Rout<<=1);
+	c->in_ring = calloc(c->Rin, sizeof(float));
+	c->out_ring = calloc(c->Rout, sizeof(float));
+	c->inblk = calloc(block, sizeof(float));
+	c->outblk = calloc(block, sizeof(float));
+	if(!c->in_ring || !c->out_ring || !c->inblk || !c->outblk) {
+		ffts_free_conv(p);
+		return NULL;
+	}
+
+	return p;
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
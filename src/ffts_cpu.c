@@ -0,0 +1,113 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_cpu.h"
+#include "ffts.h"
+
+#if defined(__x86_64__) && !defined(DYNAMIC_DISABLED)
+	#include <cpuid.h>
+#endif
+
+/*
+ * The kernel set the library was built around: the C kernels (small sizes,
+ * mixed radix, real recombination) are compiled for this one.
+ */
+int ffts_cpu_base_isa(void) {
+#if defined(HAVE_NEON)
+	return FFTS_ISA_NEON;
+#elif defined(HAVE_VFP)
+	return FFTS_ISA_VFP;
+#elif defined(HAVE_SSE)
+	return FFTS_ISA_SSE;
+#else
+	return FFTS_ISA_SCALAR;
+#endif
+}
+
+#if defined(__x86_64__) && defined(HAVE_SSE) && !defined(DYNAMIC_DISABLED)
+/*
+ * AVX2 and FMA have to be supported by the CPU, and the OS has to save the
+ * ymm state (XCR0 bits 1 and 2).
+ */
+static int ffts_cpu_has_avx2_fma(void) {
+	unsigned int eax, ebx, ecx, edx, xcr0;
+
+	if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return 0;
+	if(!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX) || !(ecx & bit_FMA)) return 0;
+
+	__asm__ ("xgetbv" : "=a" (xcr0) : "c" (0) : "%edx");
+	if((xcr0 & 6) != 6) return 0;
+
+	if(__get_cpuid_max(0, NULL) < 7) return 0;
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	return (ebx & bit_AVX2) != 0;
+}
+#endif
+
+static int ffts_cpu_detect(void) {
+	int isa = ffts_cpu_base_isa();
+
+#if defined(__x86_64__) && defined(HAVE_SSE) && !defined(DYNAMIC_DISABLED)
+	// the AVX2 kernels only exist as templates for the code generator
+	if(ffts_cpu_has_avx2_fma()) isa = FFTS_ISA_AVX2;
+#endif
+
+	return isa;
+}
+
+/*
+ * The best kernel set this host supports. Detection runs once; racing
+ * first calls all compute the same value.
+ */
+int ffts_cpu_isa(void) {
+	static int isa = -1;
+	if(isa < 0) isa = ffts_cpu_detect();
+	return isa;
+}
+
+const char *ffts_isa_name(int isa) {
+	switch(isa) {
+		case FFTS_ISA_SCALAR: return "scalar";
+		case FFTS_ISA_SSE:    return "sse";
+		case FFTS_ISA_AVX2:   return "avx2";
+		case FFTS_ISA_NEON:   return "neon";
+		case FFTS_ISA_VFP:    return "vfp";
+	}
+	return "unknown";
+}
+
+int ffts_plan_isa(ffts_plan_t *p) {
+	return p->isa;
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -0,0 +1,574 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_dct.h"
+#include "macros.h"
+#include "ffts_real.h"
+#include "ffts_cpu.h"
+#include "ffts_twiddle.h"
+
+#include <string.h>
+
+/*
+ * Unnormalized discrete cosine and sine transforms of N reals:
+ *
+ *   DCT-II  (sign -1): X[k] = 2 sum_n x[n] cos(pi (2n+1) k / 2N)
+ *   DCT-III (sign  1): x[n] = X[0] + 2 sum_{k>0} X[k] cos(pi (2n+1) k / 2N)
+ *
+ * and the DST-II/III with sin(pi (2n+1) (k+1) / 2N), so the backwards
+ * transform of the forwards one is 2N times the input.
+ *
+ * A plan keeps a real plan of size N and runs its N/2 complex transform
+ * directly. The DCT-II transforms v = (x[0], x[2], ..., x[N-2], ..., x[3],
+ * x[1]), and with V the half spectrum the real plan would make of that,
+ *
+ *   X[k] = Re(c[k]), X[N-k] = -Im(c[k]), where c[k] = 2 exp(-i pi k / 2N) V[k]
+ *
+ * The rotation is folded into copies of the real plan's A/B tables, so a
+ * single pass over the complex output does the recombination and the
+ * rotation. The DCT-III runs the same steps backwards with the inverse
+ * tables. The DSTs are the DCTs of (-1)^n x[n] with the output reversed,
+ * which the passes do as they read and write. The vector operations are
+ * those of macros.h plus the shuffles below; elsewhere the passes run on
+ * single floats.
+ */
+#if defined(HAVE_SSE)
+#define VSPLAT _mm_set1_ps
+#define VREV(x) (_mm_shuffle_ps(x,x,_MM_SHUFFLE(0,1,2,3)))
+#define VEVEN(x,y) (_mm_shuffle_ps(x,y,_MM_SHUFFLE(2,0,2,0)))
+#define VODD(x,y) (_mm_shuffle_ps(x,y,_MM_SHUFFLE(3,1,3,1)))
+#define VEVENREV(x,y) (_mm_shuffle_ps(y,x,_MM_SHUFFLE(0,2,0,2)))
+#define VODDREV(x,y) (_mm_shuffle_ps(y,x,_MM_SHUFFLE(1,3,1,3)))
+#define VZIPLO _mm_unpacklo_ps
+#define VZIPHI _mm_unpackhi_ps
+#define VLO2(x,y) (_mm_movelh_ps(x,y))
+#define VHI2(x,y) (_mm_movehl_ps(y,x))
+#elif defined(__aarch64__)
+#define VSPLAT vdupq_n_f32
+#define VREV(x) (vrev64q_f32(vextq_f32(x,x,2)))
+#define VEVEN vuzp1q_f32
+#define VODD vuzp2q_f32
+#define VEVENREV(x,y) (VREV(vuzp1q_f32(x,y)))
+#define VODDREV(x,y) (VREV(vuzp2q_f32(x,y)))
+#define VZIPLO vzip1q_f32
+#define VZIPHI vzip2q_f32
+#define VLO2(x,y) (vcombine_f32(vget_low_f32(x), vget_low_f32(y)))
+#define VHI2(x,y) (vcombine_f32(vget_high_f32(x), vget_high_f32(y)))
+#else
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VLD
+#undef VST
+#undef VLDU
+#undef VSTU
+#define V float
+#define VADD(x,y) ((x) + (y))
+#define VSUB(x,y) ((x) - (y))
+#define VMUL(x,y) ((x) * (y))
+#define VLD(p) (*(p))
+#define VST(p,x) (*(p) = (x))
+#define VLDU VLD
+#define VSTU VST
+#endif
+
+#if defined(HAVE_SSE) || defined(__aarch64__)
+#define FFTS_DCT_SIMD
+#define FFTS_DCT_VL 4
+
+/* Xs[j], Xs[j+d], Xs[j+2d], Xs[j+3d] for d = 1 or -1, where Xs is X, or X
+ * reversed for the DSTs */
+__INLINE V ffts_dct_ld4(const float *X, size_t N, int dst, size_t j, int d) {
+	if(dst) { j = N - 1 - j; d = -d; }
+	return (d > 0) ? VLDU(X + j) : VREV(VLDU(X + j - 3));
+}
+
+__INLINE void ffts_dct_st4(float *X, size_t N, int dst, size_t j, int d, V x) {
+	if(dst) { j = N - 1 - j; d = -d; }
+	if(d > 0) VSTU(X + j, x);
+	else      VSTU(X + j - 3, VREV(x));
+}
+#endif
+
+#ifndef FFTS_DCT_SIMD
+#define FFTS_DCT_VL 1
+#endif
+
+#define FFTS_DCT_IDX(dst, N, j) ((dst) ? (N) - 1 - (j) : (j))
+
+/* The rotated tables are kept split for the passes, which work on four k at
+ * a time with the real and imaginary parts in separate vectors: for each
+ * four k, the real parts of A, its imaginary parts, and the same for B. */
+#define FFTS_DCT_T(k, j) (16*((k)/4) + 4*(j) + (k)%4)
+#define FFTS_DCT_TSIZE(N) (16*(((N)/2 + 3)/4))
+
+// the complex spectrum follows v in p->buf, on a 64 byte boundary
+#define FFTS_DCT_SPEC(N) (((N) + 15) & ~(size_t)15)
+
+/* out[k] = Re(c[k]) and out[N-k] = -Im(c[k]) for one k, where
+ * c[k] = x*A[k] + conj(y)*B[k] with x = c[k] and y = c[N/2-k] on the right */
+__INLINE void ffts_dct_fwd1(const float *c, const float *T, float *out, size_t N, int dst, size_t k) {
+	float xr = c[2*k], xi = c[2*k+1], yr = c[N-2*k], yi = c[N-2*k+1];
+	float ar = T[FFTS_DCT_T(k, 0)], ai = T[FFTS_DCT_T(k, 1)];
+	float br = T[FFTS_DCT_T(k, 2)], bi = T[FFTS_DCT_T(k, 3)];
+
+	out[FFTS_DCT_IDX(dst, N, k)] = xr*ar - xi*ai + yr*br + yi*bi;
+	if(k) out[FFTS_DCT_IDX(dst, N, N-k)] = yi*br - xr*ai - xi*ar - yr*bi;
+}
+
+/* c[k] = x*A[k] + conj(y*B[k]) for one k, where x = X[k] - i X[N-k], y is
+ * the same for N/2-k, and X[N] = 0 */
+__INLINE void ffts_dct_inv1(const float *in, const float *T, float *c, size_t N, int dst, size_t k) {
+	float xr = in[FFTS_DCT_IDX(dst, N, k)], xi = k ? in[FFTS_DCT_IDX(dst, N, N-k)] : 0.0f;
+	float yr = in[FFTS_DCT_IDX(dst, N, N/2-k)], yi = in[FFTS_DCT_IDX(dst, N, N/2+k)];
+	float ar = T[FFTS_DCT_T(k, 0)], ai = T[FFTS_DCT_T(k, 1)];
+	float br = T[FFTS_DCT_T(k, 2)], bi = T[FFTS_DCT_T(k, 3)];
+
+	c[2*k]   = xr*ar + xi*ai + yr*br + yi*bi;
+	c[2*k+1] = xr*ai - xi*ar - yr*bi + yi*br;
+}
+
+__INLINE void ffts_dct_fwd(ffts_plan_t *p, const float *in, float *out, int dst) {
+	ffts_plan_t *half = p->plans[0]->plans[0];
+	size_t N = p->N, n = 0, k;
+	float *v = (float *)p->buf;
+	float *c = v + FFTS_DCT_SPEC(N);
+	const float *T = p->A;
+	float odd = dst ? -1.0f : 1.0f;
+
+#ifdef FFTS_DCT_SIMD
+	V sgn = VSPLAT(dst ? -0.0f : 0.0f);
+	for(;n+4<=N/2;n+=4) {
+		V a = VLDU(in + 2*n), b = VLDU(in + 2*n + 4);
+		VST(v + n, VEVEN(a, b));
+		VSTU(v + N - 4 - n, VXOR(VODDREV(a, b), sgn));
+	}
+#endif
+	for(;n<N/2;n++) {
+		v[n] = in[2*n];
+		v[N-1-n] = odd * in[2*n+1];
+	}
+
+	half->transform(half, v, c);
+	c[N] = c[0];
+	c[N+1] = c[1];
+
+	k = 0;
+#ifdef FFTS_DCT_SIMD
+	for(;k<4 && k<N/2;k++) ffts_dct_fwd1(c, T, out, N, dst, k);
+	for(;k+4<=N/2;k+=4) {
+		const float *t = T + 4*k;
+		V x0 = VLD(c + 2*k), x1 = VLD(c + 2*k + 4);
+		V y0 = VLDU(c + N - 2*k - 6), y1 = VLDU(c + N - 2*k - 2);
+		V xr = VEVEN(x0, x1), xi = VODD(x0, x1);
+		V yr = VEVENREV(y0, y1), yi = VODDREV(y0, y1);
+		V ar = VLD(t), ai = VLD(t + 4), br = VLD(t + 8), bi = VLD(t + 12);
+
+		ffts_dct_st4(out, N, dst, k, 1,
+		             VADD(VSUB(VMUL(xr, ar), VMUL(xi, ai)), VADD(VMUL(yr, br), VMUL(yi, bi))));
+		ffts_dct_st4(out, N, dst, N - k, -1,
+		             VSUB(VMUL(yi, br), VADD(VADD(VMUL(xr, ai), VMUL(xi, ar)), VMUL(yr, bi))));
+	}
+#endif
+	for(;k<N/2;k++) ffts_dct_fwd1(c, T, out, N, dst, k);
+
+	// the Nyquist term is real
+	out[FFTS_DCT_IDX(dst, N, N/2)] = 1.41421356237309504880f * (c[0] - c[1]);
+}
+
+__INLINE void ffts_dct_inv(ffts_plan_t *p, const float *in, float *out, int dst) {
+	ffts_plan_t *half = p->plans[0]->plans[0];
+	size_t N = p->N, n = 0, k;
+	float *v = (float *)p->buf;
+	float *c = v + FFTS_DCT_SPEC(N);
+	const float *T = p->A;
+	float odd = dst ? -1.0f : 1.0f;
+
+	k = 0;
+#ifdef FFTS_DCT_SIMD
+	for(;k<4 && k<N/2;k++) ffts_dct_inv1(in, T, c, N, dst, k);
+	for(;k+4<=N/2;k+=4) {
+		const float *t = T + 4*k;
+		V xr = ffts_dct_ld4(in, N, dst, k, 1), xi = ffts_dct_ld4(in, N, dst, N - k, -1);
+		V yr = ffts_dct_ld4(in, N, dst, N/2 - k, -1), yi = ffts_dct_ld4(in, N, dst, N/2 + k, 1);
+		V ar = VLD(t), ai = VLD(t + 4), br = VLD(t + 8), bi = VLD(t + 12);
+		V re = VADD(VADD(VMUL(xr, ar), VMUL(xi, ai)), VADD(VMUL(yr, br), VMUL(yi, bi)));
+		V im = VADD(VSUB(VMUL(xr, ai), VMUL(xi, ar)), VSUB(VMUL(yi, br), VMUL(yr, bi)));
+
+		VST(c + 2*k, VZIPLO(re, im));
+		VST(c + 2*k + 4, VZIPHI(re, im));
+	}
+#endif
+	for(;k<N/2;k++) ffts_dct_inv1(in, T, c, N, dst, k);
+
+	half->transform(half, c, v);
+
+#ifdef FFTS_DCT_SIMD
+	V sgn = VSPLAT(dst ? -0.0f : 0.0f);
+	for(;n+4<=N/2;n+=4) {
+		V e = VLD(v + n), o = VXOR(VREV(VLDU(v + N - 4 - n)), sgn);
+		VSTU(out + 2*n, VZIPLO(e, o));
+		VSTU(out + 2*n + 4, VZIPHI(e, o));
+	}
+#endif
+	for(;n<N/2;n++) {
+		out[2*n] = v[n];
+		out[2*n+1] = odd * v[N-1-n];
+	}
+}
+
+void ffts_execute_1d_dct(ffts_plan_t *p, const void *in, void *out) {
+	ffts_dct_fwd(p, (const float *)in, (float *)out, 0);
+}
+
+void ffts_execute_1d_idct(ffts_plan_t *p, const void *in, void *out) {
+	ffts_dct_inv(p, (const float *)in, (float *)out, 0);
+}
+
+void ffts_execute_1d_dst(ffts_plan_t *p, const void *in, void *out) {
+	ffts_dct_fwd(p, (const float *)in, (float *)out, 1);
+}
+
+void ffts_execute_1d_idst(ffts_plan_t *p, const void *in, void *out) {
+	ffts_dct_inv(p, (const float *)in, (float *)out, 1);
+}
+
+void ffts_free_dct(ffts_plan_t *p) {
+	if(p->plans) {
+		if(p->plans[0]) ffts_free(p->plans[0]);
+		free(p->plans);
+	}
+	free(p->A);
+	free(p->B);
+	free(p->buf);
+	free(p);
+}
+
+static ffts_plan_t *ffts_init_1d_trig(size_t N, int sign, int dst) {
+	size_t k;
+
+	if(N < 4 || (N & 1)) {
+		LOG("DCT and DST sizes must be even and at least 4\n");
+		return NULL;
+	}
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	if(sign < 0) p->transform = dst ? &ffts_execute_1d_dst : &ffts_execute_1d_dct;
+	else         p->transform = dst ? &ffts_execute_1d_idst : &ffts_execute_1d_idct;
+	p->destroy = &ffts_free_dct;
+	p->N = N;
+	p->io_bytes = sizeof(float) * 2*N;
+	p->rank = 1;
+	p->sign = sign;
+
+	p->buf_size = sizeof(float) * (FFTS_DCT_SPEC(N) + N + 2);
+	p->transpose_buf_size = 0;
+	p->nplans = 1;
+	p->buf = valloc(p->buf_size);
+	p->A = valloc(sizeof(float) * FFTS_DCT_TSIZE(N));
+	p->B = NULL;
+	p->plans = malloc(sizeof(ffts_plan_t **) * 1);
+	if(p->plans) p->plans[0] = ffts_init_1d_real(N, sign);
+	if(!p->buf || !p->A || !p->plans || !p->plans[0]) {
+		ffts_free_dct(p);
+		return NULL;
+	}
+	p->isa = p->plans[0]->isa;
+
+	// the real plan's tables, rotated by w = exp(-i pi k / 2N) = W_4N^k
+	const ffts_twiddle_t *t = ffts_twiddle_table(4*N);
+	const float *A = p->plans[0]->A, *B = p->plans[0]->B;
+	float *T = p->A;
+	memset(T, 0, sizeof(float) * FFTS_DCT_TSIZE(N));
+	for(k=0;k<N/2;k++) {
+		double wr, wi, mr, mi;
+		ffts_twiddle_cs(t, 4*N, k, &wr, &wi);
+		ffts_twiddle_cs(t, 4*N, N/2 - k, &mr, &mi);
+		wi = -wi;
+		mi = -mi;
+		double ar = A[2*k], ai = A[2*k+1], br = B[2*k], bi = B[2*k+1];
+
+		if(sign < 0) {
+			// 2 w A[k] and 2 w B[k]
+			T[FFTS_DCT_T(k, 0)] = 2.0 * (wr*ar - wi*ai);
+			T[FFTS_DCT_T(k, 1)] = 2.0 * (wr*ai + wi*ar);
+			T[FFTS_DCT_T(k, 2)] = 2.0 * (wr*br - wi*bi);
+			T[FFTS_DCT_T(k, 3)] = 2.0 * (wr*bi + wi*br);
+		}else{
+			// conj(w A[k]) and conj(w[N/2-k]) B[k]
+			T[FFTS_DCT_T(k, 0)] = wr*ar - wi*ai;
+			T[FFTS_DCT_T(k, 1)] = -(wr*ai + wi*ar);
+			T[FFTS_DCT_T(k, 2)] = mr*br + mi*bi;
+			T[FFTS_DCT_T(k, 3)] = mr*bi - mi*br;
+		}
+	}
+
+	return p;
+}
+
+ffts_plan_t *ffts_init_1d_dct(size_t N, int sign) {
+	return ffts_init_1d_trig(N, sign, 0);
+}
+
+ffts_plan_t *ffts_init_1d_dst(size_t N, int sign) {
+	return ffts_init_1d_trig(N, sign, 1);
+}
+
+/*
+ * 2D DCTs of N1 x N2 row-major reals: the rows are transformed into the
+ * output, which is transposed into p->buf, the columns are transformed in
+ * place there and transposed back.
+ */
+
+// out (w x h) = in (h x w) transposed, a tile at a time
+static void ffts_dct_transpose(const float *in, float *out, size_t h, size_t w) {
+	size_t i0, j0, i, j;
+
+	for(i0=0;i0<h;i0+=16) {
+		size_t i1 = (i0 + 16 < h) ? i0 + 16 : h;
+		for(j0=0;j0<w;j0+=16) {
+			size_t j1 = (j0 + 16 < w) ? j0 + 16 : w;
+			for(i=i0;i<i1;i++) {
+				for(j=j0;j<j1;j++) out[j*h + i] = in[i*w + j];
+			}
+		}
+	}
+}
+
+void ffts_execute_2d_dct(ffts_plan_t *p, const void *vin, void *vout) {
+	const float *in = (const float *)vin;
+	float *out = (float *)vout;
+	float *buf = (float *)p->buf;
+	ffts_plan_t *cols = p->plans[0], *rows = p->plans[1];
+	size_t N1 = cols->N, N2 = rows->N, i;
+
+	for(i=0;i<N1;i++) rows->transform(rows, in + i*N2, out + i*N2);
+	ffts_dct_transpose(out, buf, N1, N2);
+	for(i=0;i<N2;i++) cols->transform(cols, buf + i*N1, buf + i*N1);
+	ffts_dct_transpose(buf, out, N2, N1);
+}
+
+void ffts_free_2d_dct(ffts_plan_t *p) {
+	if(p->plans) {
+		if(p->plans[0]) ffts_free(p->plans[0]);
+		if(p->plans[1]) ffts_free(p->plans[1]);
+		free(p->plans);
+	}
+	free(p->buf);
+	free(p);
+}
+
+ffts_plan_t *ffts_init_2d_dct(size_t N1, size_t N2, int sign) {
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->transform = &ffts_execute_2d_dct;
+	p->destroy = &ffts_free_2d_dct;
+	p->N = N1 * N2;
+	p->io_bytes = sizeof(float) * 2*N1*N2;
+	p->rank = 2;
+	p->sign = sign;
+
+	p->buf_size = sizeof(float) * N1 * N2;
+	p->transpose_buf_size = 0;
+	p->nplans = 2;
+	p->buf = valloc(p->buf_size);
+	p->plans = malloc(sizeof(ffts_plan_t **) * 2);
+	if(p->plans) {
+		p->plans[0] = ffts_init_1d_dct(N1, sign);
+		p->plans[1] = ffts_init_1d_dct(N2, sign);
+	}
+	if(!p->buf || !p->plans || !p->plans[0] || !p->plans[1]) {
+		ffts_free_2d_dct(p);
+		return NULL;
+	}
+	p->isa = p->plans[1]->isa;
+
+	return p;
+}
+
+/*
+ * Batched 8x8 and 16x16 block DCTs, for image and video coding. Blocks this
+ * small are done as Y = M X M^T with the B x B transform matrix M: first
+ * Z = M X, and then Y^T = M Z^T, with the transposes done in registers as
+ * the second pass loads Z and stores Y. Each pass works on a few columns
+ * at a time, as vectors along the rows.
+ */
+
+/* w[k] = sum_i M[k][i] r[i]. The rows of the DCT-II matrix are symmetric
+ * (even k) or antisymmetric (odd k) about the middle, and the columns of the
+ * DCT-III one likewise, so each output takes B/2 products. The halves of M
+ * those use are in S, with every element repeated across a vector. */
+__INLINE void ffts_dct_block_pass(const float *S, const V *r, V *w, size_t B, int inv) {
+	V e[8], o[8];
+	size_t i, k;
+
+	if(!inv) {
+		for(i=0;i<B/2;i++) {
+			e[i] = VADD(r[i], r[B-1-i]);
+			o[i] = VSUB(r[i], r[B-1-i]);
+		}
+		for(k=0;k<B;k++) {
+			const float *m = S + 4*k*(B/2);
+			const V *u = (k & 1) ? o : e;
+			V a = VMUL(VLD(m), u[0]);
+			for(i=1;i<B/2;i++) a = VADD(a, VMUL(VLD(m + 4*i), u[i]));
+			w[k] = a;
+		}
+	}else{
+		for(k=0;k<B/2;k++) {
+			const float *m = S + 4*k*B;
+			V a = VMUL(VLD(m), r[0]), b = VMUL(VLD(m + 4), r[1]);
+			for(i=2;i<B;i+=2) {
+				a = VADD(a, VMUL(VLD(m + 4*i), r[i]));
+				b = VADD(b, VMUL(VLD(m + 4*i + 4), r[i+1]));
+			}
+			w[k] = VADD(a, b);
+			w[B-1-k] = VSUB(a, b);
+		}
+	}
+}
+
+// transposes the 4 x 4 block in r[0..3]
+__INLINE void ffts_dct_tr4(V *r) {
+#ifdef FFTS_DCT_SIMD
+	V t0 = VZIPLO(r[0], r[1]), t1 = VZIPHI(r[0], r[1]);
+	V t2 = VZIPLO(r[2], r[3]), t3 = VZIPHI(r[2], r[3]);
+	r[0] = VLO2(t0, t2);
+	r[1] = VHI2(t0, t2);
+	r[2] = VLO2(t1, t3);
+	r[3] = VHI2(t1, t3);
+#endif
+}
+
+__INLINE void ffts_dct_blocks(ffts_plan_t *p, const float *in, float *out, size_t B) {
+	float __attribute__((aligned(64))) t[16*16];
+	const float *S = p->A;
+	int inv = p->sign > 0;
+	size_t b, i, k, l, q;
+
+	for(b=0;b<p->howmany;b++) {
+		const float *x = in + b*B*B;
+		float *y = out + b*B*B;
+		V r[16], w[16];
+
+		// t = Z = M X, down FFTS_DCT_VL columns of X at a time
+		for(q=0;q<B;q+=FFTS_DCT_VL) {
+			for(i=0;i<B;i++) r[i] = VLDU(x + i*B + q);
+			ffts_dct_block_pass(S, r, w, B, inv);
+			for(k=0;k<B;k++) VST(t + k*B + q, w[k]);
+		}
+
+		// Y^T = M Z^T, down FFTS_DCT_VL rows of Z at a time
+		for(q=0;q<B;q+=FFTS_DCT_VL) {
+			for(i=0;i<B;i+=FFTS_DCT_VL) {
+				for(l=0;l<FFTS_DCT_VL;l++) r[i+l] = VLD(t + (q+l)*B + i);
+				ffts_dct_tr4(r + i);
+			}
+			ffts_dct_block_pass(S, r, w, B, inv);
+			for(k=0;k<B;k+=FFTS_DCT_VL) {
+				ffts_dct_tr4(w + k);
+				for(l=0;l<FFTS_DCT_VL;l++) VSTU(y + (q+l)*B + k, w[k+l]);
+			}
+		}
+	}
+}
+
+void ffts_execute_dct_8x8(ffts_plan_t *p, const void *in, void *out) {
+	ffts_dct_blocks(p, (const float *)in, (float *)out, 8);
+}
+
+void ffts_execute_dct_16x16(ffts_plan_t *p, const void *in, void *out) {
+	ffts_dct_blocks(p, (const float *)in, (float *)out, 16);
+}
+
+ffts_plan_t *ffts_init_2d_dct_blocks(size_t B, int sign, size_t nblocks) {
+	size_t k, n;
+
+	if(B != 8 && B != 16) {
+		LOG("DCT blocks must be 8x8 or 16x16\n");
+		return NULL;
+	}
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->transform = (B == 8) ? &ffts_execute_dct_8x8 : &ffts_execute_dct_16x16;
+	p->destroy = &ffts_free_dct;
+	p->N = B;
+	p->rank = 2;
+	p->sign = sign;
+	p->howmany = nblocks;
+	p->io_bytes = sizeof(float) * 2*B*B * nblocks;
+#if defined(HAVE_SSE)
+	p->isa = FFTS_ISA_SSE;
+#elif defined(__aarch64__)
+	p->isa = FFTS_ISA_NEON;
+#else
+	p->isa = FFTS_ISA_SCALAR;
+#endif
+
+	// the blocks are worked on in registers and on the stack
+	p->buf = NULL;
+	p->buf_size = 0;
+	p->transpose_buf_size = 0;
+	p->plans = NULL;
+	p->nplans = 0;
+	p->A = valloc(sizeof(float) * 4 * B * B/2);
+	p->B = NULL;
+	if(!p->A) {
+		ffts_free_dct(p);
+		return NULL;
+	}
+
+	// M[k][n] = 2 cos(pi (2n+1) k / 2B) for the DCT-II, and its transpose
+	// with the k = 0 terms halved for the DCT-III. S holds M[k][n] (DCT-II)
+	// or M[n][k] (DCT-III) for n < B/2, each four times over
+	const ffts_twiddle_t *t = ffts_twiddle_table(4*B);
+	for(k=0;k<B;k++) {
+		for(n=0;n<B/2;n++) {
+			double c, sn;
+			ffts_twiddle_cs(t, 4*B, ((2*n + 1) * k) % (4*B), &c, &sn);
+			float m = 2.0 * c;
+			float *s = (sign < 0) ? p->A + 4*(k*(B/2) + n) : p->A + 4*(n*B + k);
+			if(sign > 0 && !k) m = 1.0f;
+			s[0] = s[1] = s[2] = s[3] = m;
+		}
+	}
+
+	return p;
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
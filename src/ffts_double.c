@@ -0,0 +1,391 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_double.h"
+#include "ffts_cpu.h"
+#include "ffts_twiddle.h"
+#include "macros-double.h"
+
+#include <string.h>
+
+/*
+ * Double precision transforms. These use the same conjugate-pair split-radix
+ * decomposition as the single precision engine (a size N transform is a size
+ * N/2 transform of the even samples plus size N/4 transforms of x[4n+1] and
+ * x[4n-1], combined with w^k and conj(w^k)), written in C over 2-wide double
+ * vectors instead of generated code. Sub-transforms are evaluated depth first
+ * into contiguous output, so each level works on data that is already in
+ * cache.
+ *
+ * p->ws holds one table of packed twiddles w_n^k, k < n/4, per level n >= 8;
+ * p->ws_is[log2(n)] is the offset (in doubles) of the table for level n.
+ */
+
+static void ffts_d_rec(const ffts_plan_t *p, const double *in, double *out,
+                       size_t n, size_t start, size_t stride) {
+	const size_t mask = p->N - 1;
+	const int inv = p->sign < 0;
+
+	if(n == 1) {
+		VDST(out, VDLD(in + 2*start));
+		return;
+	}
+	if(n == 2) {
+		VD x0 = VDLD(in + 2*start);
+		VD x1 = VDLD(in + 2*((start + stride) & mask));
+		VDST(out,     VDADD(x0, x1));
+		VDST(out + 2, VDSUB(x0, x1));
+		return;
+	}
+	if(n == 4) {
+		VD x0 = VDLD(in + 2*start);
+		VD x1 = VDLD(in + 2*((start +   stride) & mask));
+		VD x2 = VDLD(in + 2*((start + 2*stride) & mask));
+		VD x3 = VDLD(in + 2*((start + 3*stride) & mask));
+		VD t0 = VDADD(x0, x2), t1 = VDSUB(x0, x2);
+		VD t2 = VDADD(x1, x3), t3 = VDMULI(inv, VDSUB(x1, x3));
+		VDST(out,     VDADD(t0, t2));
+		VDST(out + 2, VDADD(t1, t3));
+		VDST(out + 4, VDSUB(t0, t2));
+		VDST(out + 6, VDSUB(t1, t3));
+		return;
+	}
+
+	ffts_d_rec(p, in, out,         n/2, start, 2*stride);
+	ffts_d_rec(p, in, out + n,     n/4, (start + stride) & mask, 4*stride);
+	ffts_d_rec(p, in, out + 3*n/2, n/4, (start - stride) & mask, 4*stride);
+
+	const double *w = (const double *)p->ws + p->ws_is[__builtin_ctzl(n)];
+	double *o0 = out;
+	double *o1 = out + n/2;
+	double *o2 = out + n;
+	double *o3 = out + 3*n/2;
+	size_t k;
+	for(k=0;k<n/2;k+=2) {
+		VD wk = VDLD(w + k);
+		VD z  = VDCMUL(VDLD(o2 + k), wk);
+		VD zc = VDCMULJ(VDLD(o3 + k), wk);
+		VD a = VDLD(o0 + k);
+		VD b = VDLD(o1 + k);
+		VD s = VDADD(z, zc);
+		VD d = VDMULI(inv, VDSUB(z, zc));
+		VDST(o0 + k, VDADD(a, s));
+		VDST(o2 + k, VDSUB(a, s));
+		VDST(o1 + k, VDADD(b, d));
+		VDST(o3 + k, VDSUB(b, d));
+	}
+}
+
+void ffts_free_1d_d(ffts_plan_t *p) {
+	free(p->ws);
+	free(p->ws_is);
+	free(p);
+}
+
+void ffts_execute_1d_d(ffts_plan_t *p, const void *in, void *out) {
+	ffts_d_rec(p, (const double *)in, (double *)out, p->N, 0, 1);
+}
+
+ffts_plan_t *ffts_init_1d_d(size_t N, int sign) {
+	if(N == 0 || (N & (N - 1)) != 0) {
+		LOG("Double precision FFT size must be a power of two\n");
+		return NULL;
+	}
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->transform = &ffts_execute_1d_d;
+	p->destroy = &ffts_free_1d_d;
+	p->buf_size = p->transpose_buf_size = 0;
+	p->nplans = 0;
+	p->N = N;
+	p->io_bytes = sizeof(double) * 4*N;
+	p->rank = 1;
+	p->sign = sign;
+	p->isa = ffts_cpu_base_isa();
+
+	size_t levels = __builtin_ctzl(N) + 1;
+	size_t n, k, size = 0;
+	p->ws_is = malloc(sizeof(size_t) * levels);
+	for(n=1;n<=N;n<<=1) {
+		p->ws_is[__builtin_ctzl(n)] = size;
+		if(n >= 8) size += 2 * (n/4);
+	}
+	p->ws = malloc(sizeof(double) * (size ? size : 2));
+
+	if(!p->ws_is || !p->ws) {
+		ffts_free_1d_d(p);
+		return NULL;
+	}
+
+	const ffts_twiddle_t *t = ffts_twiddle_table(N);
+	for(n=8;n<=N;n<<=1) {
+		double *w = (double *)p->ws + p->ws_is[__builtin_ctzl(n)];
+		for(k=0;k<n/4;k++) {
+			ffts_twiddle_cs(t, n, k, &w[2*k], &w[2*k+1]);
+			w[2*k+1] *= sign;
+		}
+	}
+
+	return p;
+}
+
+/*
+ * Multi-dimensional transforms. Each dimension is transformed where it lies,
+ * without transposes: the lines of dimension i (stride Ms[i]) are taken
+ * COLS_D neighbouring lines at a time, a cache line of doubles, gathered
+ * into p->buf, transformed, and written back a row at a time. The last
+ * dimension is contiguous and is transformed straight from in to out.
+ */
+
+#define COLS_D 4
+
+static void ffts_transform_lines_d(ffts_plan_t *t, const double *src, double *dst,
+                                   size_t L, size_t S, size_t count, double *buf) {
+	// padded by a cache line, as in ffts_transform_lines
+	size_t Ls = L + 4;
+	double *obuf = buf + 2*COLS_D*Ls;
+	size_t o, c, b, l;
+
+	for(o=0;o<count;o++) {
+		const double *ibase = src + 2*o*L*S;
+		double *obase = dst + 2*o*L*S;
+
+		if(S == 1 && src != dst) {
+			t->transform(t, ibase, obase);
+			continue;
+		}
+
+		for(c=0;c<S;c+=COLS_D) {
+			size_t nb = (c + COLS_D < S) ? COLS_D : S - c;
+			for(l=0;l<L;l++) {
+				const double *ip = ibase + 2*(l*S + c);
+				for(b=0;b<nb;b++) VDST(buf + 2*(b*Ls + l), VDLD(ip + 2*b));
+			}
+			for(b=0;b<nb;b++) {
+				t->transform(t, buf + 2*b*Ls, obuf + 2*b*Ls);
+			}
+			for(l=0;l<L;l++) {
+				double *op = obase + 2*(l*S + c);
+				for(b=0;b<nb;b++) VDST(op + 2*b, VDLD(obuf + 2*(b*Ls + l)));
+			}
+		}
+	}
+}
+
+static void ffts_free_nd_d(ffts_plan_t *p) {
+	int i, k;
+	for(i=0;i<p->rank;i++) {
+		ffts_plan_t *x = p->plans[i];
+		for(k=0;k<i;k++) {
+			if(p->plans[k] == x) x = NULL;
+		}
+		if(x) ffts_free(x);
+	}
+	free(p->Ns);
+	free(p->Ms);
+	free(p->plans);
+	free(p->buf);
+	free(p);
+}
+
+static void ffts_execute_nd_d(ffts_plan_t *p, const void *in, void *out) {
+	const double *src = (const double *)in;
+	double *dout = (double *)out;
+
+	int i;
+	for(i=p->rank-1;i>=0;i--) {
+		ffts_transform_lines_d(p->plans[i], src, dout, p->Ns[i], p->Ms[i],
+		                       p->N / (p->Ns[i] * p->Ms[i]), (double *)p->buf);
+		src = dout;
+	}
+}
+
+ffts_plan_t *ffts_init_nd_d(int rank, size_t *Ns, int sign) {
+	size_t vol = 1, maxL = 0;
+	int i, k;
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->transform = &ffts_execute_nd_d;
+	p->destroy = &ffts_free_nd_d;
+	p->rank = rank;
+	p->sign = sign;
+	p->Ns = malloc(sizeof(size_t) * rank);
+	p->Ms = malloc(sizeof(size_t) * rank);
+	p->plans = malloc(sizeof(ffts_plan_t **) * rank);
+	for(i=rank-1;i>=0;i--) {
+		p->Ns[i] = Ns[i];
+		p->Ms[i] = vol;
+		vol *= Ns[i];
+		if(Ns[i] > maxL) maxL = Ns[i];
+	}
+	p->N = vol;
+	p->io_bytes = sizeof(double) * 4*vol;
+	p->buf_size = sizeof(double) * 2 * 2*COLS_D*(maxL + 4);
+	p->transpose_buf_size = 0;
+	p->nplans = rank;
+	p->buf = malloc(p->buf_size);
+
+	for(i=0;i<rank;i++) {
+		p->plans[i] = NULL;
+		for(k=0;k<i;k++) {
+			if(p->Ns[k] == p->Ns[i]) p->plans[i] = p->plans[k];
+		}
+		if(!p->plans[i]) p->plans[i] = ffts_init_1d_d(p->Ns[i], sign);
+		if(!p->plans[i]) {
+			p->rank = i;
+			ffts_free_nd_d(p);
+			return NULL;
+		}
+	}
+	p->isa = p->plans[0]->isa;
+
+	return p;
+}
+
+ffts_plan_t *ffts_init_2d_d(size_t N1, size_t N2, int sign) {
+	size_t Ns[2];
+	Ns[0] = N1;
+	Ns[1] = N2;
+	return ffts_init_nd_d(2, Ns, sign);
+}
+
+/*
+ * Real transforms, as in ffts_real.c: a complex transform of size N/2 plus a
+ * recombination pass with the A and B coefficients.
+ */
+
+static void ffts_free_1d_real_d(ffts_plan_t *p) {
+	ffts_free(p->plans[0]);
+	free(p->plans);
+	free(p->buf);
+	free(p->A);
+	free(p->B);
+	free(p);
+}
+
+static void ffts_execute_1d_real_d(ffts_plan_t *p, const void *vin, void *vout) {
+	double *out = (double *)vout;
+	double *buf = (double *)p->buf;
+	const double *A = (const double *)p->A;
+	const double *B = (const double *)p->B;
+	size_t N = p->N;
+	size_t i;
+
+	p->plans[0]->transform(p->plans[0], vin, buf);
+	buf[N] = buf[0];
+	buf[N+1] = buf[1];
+
+	for(i=0;i<N/2;i++) {
+		out[2*i]   = buf[2*i]*A[2*i] - buf[2*i+1]*A[2*i+1] + buf[N-2*i]*B[2*i] + buf[N-2*i+1]*B[2*i+1];
+		out[2*i+1] = buf[2*i+1]*A[2*i] + buf[2*i]*A[2*i+1] + buf[N-2*i]*B[2*i+1] - buf[N-2*i+1]*B[2*i];
+	}
+	out[N] = buf[0] - buf[1];
+	out[N+1] = 0.0;
+}
+
+static void ffts_execute_1d_real_inv_d(ffts_plan_t *p, const void *vin, void *vout) {
+	const double *in = (const double *)vin;
+	double *buf = (double *)p->buf;
+	const double *A = (const double *)p->A;
+	const double *B = (const double *)p->B;
+	size_t N = p->N;
+	size_t i;
+
+	for(i=0;i<N/2;i++) {
+		buf[2*i]   = in[2*i]*A[2*i] + in[2*i+1]*A[2*i+1] + in[N-2*i]*B[2*i] - in[N-2*i+1]*B[2*i+1];
+		buf[2*i+1] = in[2*i+1]*A[2*i] - in[2*i]*A[2*i+1] - in[N-2*i]*B[2*i+1] - in[N-2*i+1]*B[2*i];
+	}
+
+	p->plans[0]->transform(p->plans[0], buf, vout);
+}
+
+ffts_plan_t *ffts_init_1d_real_d(size_t N, int sign) {
+	if(N < 2 || (N & (N - 1)) != 0) {
+		LOG("Double precision real FFT size must be a power of two\n");
+		return NULL;
+	}
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	if(sign < 0) p->transform = &ffts_execute_1d_real_d;
+	else         p->transform = &ffts_execute_1d_real_inv_d;
+	p->destroy = &ffts_free_1d_real_d;
+	p->N = N;
+	p->io_bytes = sizeof(double) * (2*N + 2);
+	p->rank = 1;
+	p->sign = sign;
+
+	p->plans = malloc(sizeof(ffts_plan_t **) * 1);
+	p->plans[0] = ffts_init_1d_d(N/2, sign);
+	if(!p->plans[0]) {
+		free(p->plans);
+		free(p);
+		return NULL;
+	}
+	p->isa = p->plans[0]->isa;
+
+	p->buf_size = sizeof(double) * 2 * ((N/2) + 1);
+	p->transpose_buf_size = 0;
+	p->nplans = 1;
+	p->buf = malloc(p->buf_size);
+	double *A = malloc(sizeof(double) * N);
+	double *B = malloc(sizeof(double) * N);
+	p->A = (float *)A;
+	p->B = (float *)B;
+
+	if(!p->buf || !A || !B) {
+		ffts_free_1d_real_d(p);
+		return NULL;
+	}
+
+	const ffts_twiddle_t *t = ffts_twiddle_table(N);
+	double s = (sign < 0) ? 0.5 : 1.0;
+	size_t i;
+	for(i=0;i<N/2;i++) {
+		double c, sn;
+		ffts_twiddle_cs(t, N, i, &c, &sn);
+		A[2*i]     = s * (1.0 - sn);
+		A[2*i + 1] = s * (-1.0 * c);
+		B[2*i]     = s * (1.0 + sn);
+		B[2*i + 1] = s * (1.0 * c);
+	}
+
+	return p;
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
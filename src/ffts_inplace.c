@@ -0,0 +1,319 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_inplace.h"
+#include "ffts_twiddle.h"
+#include "ffts_nd.h"
+
+#include <string.h>
+
+/*
+ * In-place plans. Only scratch space proportional to the side of the
+ * transform is used, so in and out may be the same buffer; if they differ the
+ * input is copied to out first. Neither buffer needs to be aligned.
+ *
+ * N-D plans from ffts_init_nd already work this way: each dimension is
+ * transformed where it lies by ffts_transform_lines.
+ *
+ * 1D: N = N1*N2 with N2 = N1 or 2*N1, viewed as N1 rows of N2. The columns
+ * are transformed and multiplied by W_N^(n2*k1) as above, then the rows, and
+ * the N1 x N2 result is transposed in place. The column pass gathers up to
+ * COLS neighbouring columns into p->buf at a time.
+ */
+
+#define COLS FFTS_LINES_COLS
+#define TSIZE 8
+
+typedef struct { uint64_t a, b; } ffts_pair_t;
+
+void ffts_transpose_square_inplace(uint64_t *data, size_t n) {
+	size_t i, j, x, y;
+	for(i=0;i<n;i+=TSIZE) {
+		for(j=i;j<n;j+=TSIZE) {
+			size_t im = (i + TSIZE < n) ? i + TSIZE : n;
+			size_t jm = (j + TSIZE < n) ? j + TSIZE : n;
+			for(y=i;y<im;y++) {
+				for(x=(i == j) ? y + 1 : j;x<jm;x++) {
+					uint64_t t = data[y*n + x];
+					data[y*n + x] = data[x*n + y];
+					data[x*n + y] = t;
+				}
+			}
+		}
+	}
+}
+
+static void ffts_transpose_pairs_inplace(ffts_pair_t *data, size_t n) {
+	size_t i, j, x, y;
+	for(i=0;i<n;i+=TSIZE) {
+		for(j=i;j<n;j+=TSIZE) {
+			size_t im = (i + TSIZE < n) ? i + TSIZE : n;
+			size_t jm = (j + TSIZE < n) ? j + TSIZE : n;
+			for(y=i;y<im;y++) {
+				for(x=(i == j) ? y + 1 : j;x<jm;x++) {
+					ffts_pair_t t = data[y*n + x];
+					data[y*n + x] = data[x*n + y];
+					data[x*n + y] = t;
+				}
+			}
+		}
+	}
+}
+
+/*
+ * Transforms lines of length L and element stride S from src to dst (which
+ * may be the same buffer). The data is count blocks of L*S elements, and the
+ * lines of a block are handled in units of up to COLS neighbouring lines;
+ * units u0..u1 of the count * ceil(S / COLS) units are done, so the work can
+ * be split between threads. buf holds FFTS_LINES_SCRATCH(L) elements: the
+ * gathered lines and their transforms.
+ *
+ * tw, if not NULL, holds the 1D twiddles: tw[0..N2) = W_N^j and
+ * tw[N2..N2+N1) = W_N^(j*N2) as double pairs, and line c is multiplied by
+ * W_N^(c*k) after the transform.
+ */
+void ffts_transform_lines(ffts_plan_t *t, const uint64_t *src, uint64_t *dst,
+                          size_t L, size_t S, size_t u0, size_t u1,
+                          uint64_t *buf, const double *tw, size_t N2) {
+	// gathered lines are padded by a cache line, so that power-of-two
+	// lengths don't map every line to the same cache sets
+	size_t Ls = L + (L & 1) + 8;
+	size_t ncg = (S + COLS - 1) / COLS;
+	uint64_t *obuf = buf + COLS * Ls;
+	size_t u, b, l;
+
+	for(u=u0;u<u1;u++) {
+		size_t o = u / ncg;
+		size_t c = (u % ncg) * COLS;
+		size_t nb = (c + COLS < S) ? COLS : S - c;
+		const uint64_t *ibase = src + o * L * S;
+		uint64_t *obase = dst + o * L * S;
+
+		// rows that the plan can read and write directly
+		if(S == 1 && !tw && src != dst && !(L & 1) &&
+		   !((uintptr_t)ibase & 15) && !((uintptr_t)obase & 15)) {
+			t->transform(t, ibase, obase);
+			continue;
+		}
+
+		for(l=0;l<L;l++) {
+			const uint64_t *ip = ibase + l * S + c;
+			for(b=0;b<nb;b++) buf[b*Ls + l] = ip[b];
+		}
+
+		for(b=0;b<nb;b++) {
+			t->transform(t, buf + b*Ls, obuf + b*Ls);
+			if(tw) {
+				float *f = (float *)(obuf + b*Ls);
+				size_t col = c + b;
+				const double *st = tw + 2*col;
+				double wr = 1.0, wi = 0.0;
+				// W_N^(col*l) by recurrence with W_N^col, restarted from
+				// tw_lo[e % N2] * tw_hi[e / N2] every 32 lines so the
+				// error doesn't build up
+				for(l=0;l<L;l++) {
+					double re = f[2*l], im = f[2*l+1], t;
+					if(!(l & 31)) {
+						size_t e = col * l;
+						const double *lo = tw + 2*(e % N2);
+						const double *hi = tw + 2*N2 + 2*(e / N2);
+						wr = lo[0]*hi[0] - lo[1]*hi[1];
+						wi = lo[0]*hi[1] + lo[1]*hi[0];
+					}
+					f[2*l]   = re*wr - im*wi;
+					f[2*l+1] = re*wi + im*wr;
+					t  = wr*st[0] - wi*st[1];
+					wi = wr*st[1] + wi*st[0];
+					wr = t;
+				}
+			}
+		}
+
+		// written back a row at a time, so that whole cache lines are stored
+		for(l=0;l<L;l++) {
+			uint64_t *op = obase + l * S + c;
+			for(b=0;b<nb;b++) op[b] = obuf[b*Ls + l];
+		}
+	}
+}
+
+static void ffts_free_inplace(ffts_plan_t *p) {
+	int i, k;
+	for(i=0;i<p->rank;i++) {
+		ffts_plan_t *x = p->plans[i];
+		for(k=0;k<i;k++) {
+			if(p->plans[k] == x) x = NULL;
+		}
+		if(x) ffts_free(x);
+	}
+	free(p->plans);
+	free(p->Ns);
+	free(p->buf);
+	free(p->ws);
+	free(p);
+}
+
+static void ffts_execute_1d_inplace(ffts_plan_t *p, const void *in, void *out) {
+	uint64_t *data = (uint64_t *)out;
+	uint64_t *buf = (uint64_t *)p->buf;
+	size_t N1 = p->Ns[0], N2 = p->Ns[1];
+	size_t i;
+
+	if(in != out) memcpy(out, in, sizeof(uint64_t) * p->N);
+
+	if(p->rank == 1) {
+		// small transforms: staged through a buffer of size N
+		memcpy(buf, data, sizeof(uint64_t) * p->N);
+		p->plans[0]->transform(p->plans[0], buf, buf + p->N);
+		memcpy(data, buf + p->N, sizeof(uint64_t) * p->N);
+		return;
+	}
+
+	ffts_transform_lines(p->plans[0], data, data, N1, N2, 0, (N2 + COLS - 1) / COLS, buf, (const double *)p->ws, N2);
+	ffts_transform_lines(p->plans[1], data, data, N2, 1, 0, N1, buf, NULL, 0);
+
+	if(N1 == N2) {
+		ffts_transpose_square_inplace(data, N1);
+	}else{
+		// transpose the N1 x N1 matrix of pairs, then deinterleave each
+		// run of 2*N1 elements
+		ffts_transpose_pairs_inplace((ffts_pair_t *)data, N1);
+		for(i=0;i<N1;i++) {
+			uint64_t *run = data + 2*N1*i;
+			size_t r;
+			memcpy(buf, run, sizeof(uint64_t) * 2 * N1);
+			for(r=0;r<N1;r++) {
+				run[r]      = buf[2*r];
+				run[N1 + r] = buf[2*r + 1];
+			}
+		}
+	}
+}
+
+ffts_plan_t *ffts_init_1d_inplace(size_t N, int sign) {
+	if(N == 0 || (N & (N - 1)) != 0) {
+		LOG("In-place FFT size must be a power of two\n");
+		return NULL;
+	}
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->transform = &ffts_execute_1d_inplace;
+	p->destroy = &ffts_free_inplace;
+	p->N = N;
+	p->io_bytes = sizeof(float) * 4*N;
+	p->sign = sign;
+	p->ws = NULL;
+	p->buf = NULL;
+	p->Ns = malloc(sizeof(size_t) * 2);
+	p->plans = malloc(sizeof(ffts_plan_t **) * 2);
+
+	if(N <= 64) {
+		p->rank = 1;
+		p->Ns[0] = N;
+		p->Ns[1] = 1;
+		p->plans[0] = ffts_init_1d(N, sign);
+		p->buf_size = sizeof(uint64_t) * 2 * N;
+		p->transpose_buf_size = 0;
+		p->nplans = 1;
+		p->buf = valloc(p->buf_size);
+		if(!p->plans[0]) {
+			p->rank = 0;
+			ffts_free_inplace(p);
+			return NULL;
+		}
+		p->isa = p->plans[0]->isa;
+		return p;
+	}
+
+	size_t N1 = (size_t)1 << (__builtin_ctzl(N) / 2);
+	size_t N2 = N / N1;
+	size_t i;
+
+	p->rank = 2;
+	p->Ns[0] = N1;
+	p->Ns[1] = N2;
+	p->plans[0] = ffts_init_1d(N1, sign);
+	p->plans[1] = (N2 == N1) ? p->plans[0] : ffts_init_1d(N2, sign);
+	if(!p->plans[0] || !p->plans[1]) {
+		if(!p->plans[0]) p->rank = 0;
+		else if(!p->plans[1]) p->plans[1] = p->plans[0];
+		ffts_free_inplace(p);
+		return NULL;
+	}
+	p->isa = p->plans[0]->isa;
+
+	// scratch for the line passes, which is also large enough for the
+	// final deinterleave
+	p->buf_size = sizeof(uint64_t) * FFTS_LINES_SCRATCH(N2);
+	p->transpose_buf_size = 0;
+	p->nplans = 2;
+	p->buf = valloc(p->buf_size);
+
+	// W_N^i for i < N2, composed from about 2 sqrt(N2) libm values, and
+	// W_N^(i N2) = W_N1^i for i < N1 from the master table, which only
+	// needs to cover the sub-plans
+	const ffts_twiddle_t *t = ffts_twiddle_table(N1);
+	double *tw = malloc(sizeof(double) * 2 * (N2 + N1));
+	if(tw && ffts_twiddle_range(tw, N, N2)) {
+		free(tw);
+		tw = NULL;
+	}
+	for(i=0;tw && i<N2;i++) tw[2*i+1] *= sign;
+	for(i=0;tw && i<N1;i++) {
+		ffts_twiddle_cs(t, N1, i, &tw[2*N2 + 2*i], &tw[2*N2 + 2*i+1]);
+		tw[2*N2 + 2*i+1] *= sign;
+	}
+	p->ws = tw;
+
+	if(!p->buf || !p->ws) {
+		ffts_free_inplace(p);
+		return NULL;
+	}
+
+	return p;
+}
+
+ffts_plan_t *ffts_init_nd_inplace(int rank, size_t *Ns, int sign) {
+	return ffts_init_nd(rank, Ns, sign);
+}
+
+ffts_plan_t *ffts_init_2d_inplace(size_t N1, size_t N2, int sign) {
+	size_t Ns[2];
+	Ns[0] = N1;
+	Ns[1] = N2;
+	return ffts_init_nd_inplace(2, Ns, sign);
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
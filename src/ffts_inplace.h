@@ -0,0 +1,57 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef __FFTS_INPLACE_H__
+#define __FFTS_INPLACE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ffts.h"
+
+#define FFTS_LINES_COLS 8
+/* scratch (in complex elements) that ffts_transform_lines needs for lines of length L */
+#define FFTS_LINES_SCRATCH(L) (2 * FFTS_LINES_COLS * ((L) + 9))
+
+void ffts_transform_lines(ffts_plan_t *t, const uint64_t *src, uint64_t *dst,
+                          size_t L, size_t S, size_t u0, size_t u1,
+                          uint64_t *buf, const double *tw, size_t N2);
+void ffts_transpose_square_inplace(uint64_t *data, size_t n);
+ffts_plan_t *ffts_init_1d_inplace(size_t N, int sign);
+ffts_plan_t *ffts_init_nd_inplace(int rank, size_t *Ns, int sign);
+ffts_plan_t *ffts_init_2d_inplace(size_t N1, size_t N2, int sign);
+
+#endif
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -0,0 +1,385 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_lanes.h"
+#include "ffts_cpu.h"
+#include "ffts_twiddle.h"
+
+#include <string.h>
+
+/*
+ * Batches of small transforms (N <= 32) run across vector lanes: each
+ * group of 4 (SSE, NEON) or 8 (AVX2) transforms is transposed so that a
+ * vector holds the same element of every transform, transformed with
+ * plain scalar-style butterflies on the vectors, and transposed back.
+ * Every lane does useful work and the twiddle factors and the call
+ * overhead are shared by the whole group. The transposes are done with
+ * vector shuffles when the transforms are contiguous (istride 1) or
+ * interleaved (idist 1), and element by element otherwise.
+ *
+ * The twiddle table holds W_N^e, e < N, taken from the master table
+ * (ffts_twiddle.h), each part splatted across FFTS_LANES_W floats, so
+ * both widths read the same table.
+ */
+#if defined(HAVE_SSE) || defined(__aarch64__)
+#define FFTS_LANES
+#endif
+
+#if defined(__x86_64__) && defined(HAVE_SSE) && !defined(DYNAMIC_DISABLED) && defined(__GNUC__)
+#define FFTS_LANES_AVX
+#endif
+
+#ifdef FFTS_LANES
+
+/*
+ * Four lanes don't beat the single transforms (ffts_small.c, and the
+ * generated code) beyond N = 4: the transposes cost more than the
+ * butterflies save. Eight lanes win at every size.
+ */
+#define FFTS_LANES_MAX_4 4
+
+// the butterflies are unrolled so the twiddle special cases fold away
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 8)
+#define LANES_UNROLL _Pragma("GCC unroll 16")
+#elif defined(__clang__)
+#define LANES_UNROLL _Pragma("unroll")
+#else
+#define LANES_UNROLL
+#endif
+
+// 5 bit reversal; shifted right for smaller sizes
+static const uint8_t ffts_lanes_rev[32] = {
+	0, 16, 8, 24, 4, 20, 12, 28, 2, 18, 10, 26, 6, 22, 14, 30,
+	1, 17, 9, 25, 5, 21, 13, 29, 3, 19, 11, 27, 7, 23, 15, 31
+};
+
+#if defined(HAVE_SSE)
+#include <xmmintrin.h>
+
+#define LANES 4
+#define LV __m128
+#define LANES_FN(f) f##_4
+#define LANES_TARGET
+#define LLD _mm_load_ps
+#define LST _mm_store_ps
+#define LADD _mm_add_ps
+#define LSUB _mm_sub_ps
+#define LMUL _mm_mul_ps
+#define LSPLAT _mm_set1_ps
+
+// four transforms, two elements at a time: 4x4 transposes of (re, im, re, im)
+__INLINE void ffts_lanes_rows_in_4(float *d, const float *src, size_t dist, size_t N) {
+	size_t j;
+	for(j=0;j<N;j+=2) {
+		__m128 r0 = _mm_loadu_ps(src + 2*j);
+		__m128 r1 = _mm_loadu_ps(src + dist + 2*j);
+		__m128 r2 = _mm_loadu_ps(src + 2*dist + 2*j);
+		__m128 r3 = _mm_loadu_ps(src + 3*dist + 2*j);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_store_ps(d + 8*j, r0);
+		_mm_store_ps(d + 8*j + 4, r1);
+		_mm_store_ps(d + 8*j + 8, r2);
+		_mm_store_ps(d + 8*j + 12, r3);
+	}
+}
+
+__INLINE void ffts_lanes_rows_out_4(float *dst, size_t dist, const float *d, size_t N, int shift) {
+	size_t j;
+	for(j=0;j<N;j+=2) {
+		const float *x = d + 8*(ffts_lanes_rev[j] >> shift);
+		const float *y = d + 8*(ffts_lanes_rev[j+1] >> shift);
+		__m128 r0 = _mm_load_ps(x), r1 = _mm_load_ps(x + 4);
+		__m128 r2 = _mm_load_ps(y), r3 = _mm_load_ps(y + 4);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(dst + 2*j, r0);
+		_mm_storeu_ps(dst + dist + 2*j, r1);
+		_mm_storeu_ps(dst + 2*dist + 2*j, r2);
+		_mm_storeu_ps(dst + 3*dist + 2*j, r3);
+	}
+}
+
+// element j of the four transforms is four adjacent complex values
+__INLINE void ffts_lanes_cols_in_4(float *d, const float *src, size_t stride, size_t N) {
+	size_t j;
+	for(j=0;j<N;j++) {
+		__m128 a = _mm_loadu_ps(src + j*stride), b = _mm_loadu_ps(src + j*stride + 4);
+		_mm_store_ps(d + 8*j, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)));
+		_mm_store_ps(d + 8*j + 4, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1)));
+	}
+}
+
+__INLINE void ffts_lanes_cols_out_4(float *dst, size_t stride, const float *d, size_t N, int shift) {
+	size_t j;
+	for(j=0;j<N;j++) {
+		const float *x = d + 8*(ffts_lanes_rev[j] >> shift);
+		__m128 re = _mm_load_ps(x), im = _mm_load_ps(x + 4);
+		_mm_storeu_ps(dst + j*stride, _mm_unpacklo_ps(re, im));
+		_mm_storeu_ps(dst + j*stride + 4, _mm_unpackhi_ps(re, im));
+	}
+}
+#else
+#include <arm_neon.h>
+
+#define LANES 4
+#define LV float32x4_t
+#define LANES_FN(f) f##_4
+#define LANES_TARGET
+#define LLD vld1q_f32
+#define LST vst1q_f32
+#define LADD vaddq_f32
+#define LSUB vsubq_f32
+#define LMUL vmulq_f32
+#define LSPLAT vdupq_n_f32
+
+// 4x4 transpose of r0..r3, in place
+__INLINE void ffts_lanes_tr_4(float32x4_t *r0, float32x4_t *r1, float32x4_t *r2, float32x4_t *r3) {
+	float32x4x2_t a = vzipq_f32(*r0, *r2), b = vzipq_f32(*r1, *r3);
+	float32x4x2_t lo = vzipq_f32(a.val[0], b.val[0]), hi = vzipq_f32(a.val[1], b.val[1]);
+	*r0 = lo.val[0];
+	*r1 = lo.val[1];
+	*r2 = hi.val[0];
+	*r3 = hi.val[1];
+}
+
+__INLINE void ffts_lanes_rows_in_4(float *d, const float *src, size_t dist, size_t N) {
+	size_t j;
+	for(j=0;j<N;j+=2) {
+		float32x4_t r0 = vld1q_f32(src + 2*j);
+		float32x4_t r1 = vld1q_f32(src + dist + 2*j);
+		float32x4_t r2 = vld1q_f32(src + 2*dist + 2*j);
+		float32x4_t r3 = vld1q_f32(src + 3*dist + 2*j);
+		ffts_lanes_tr_4(&r0, &r1, &r2, &r3);
+		vst1q_f32(d + 8*j, r0);
+		vst1q_f32(d + 8*j + 4, r1);
+		vst1q_f32(d + 8*j + 8, r2);
+		vst1q_f32(d + 8*j + 12, r3);
+	}
+}
+
+__INLINE void ffts_lanes_rows_out_4(float *dst, size_t dist, const float *d, size_t N, int shift) {
+	size_t j;
+	for(j=0;j<N;j+=2) {
+		const float *x = d + 8*(ffts_lanes_rev[j] >> shift);
+		const float *y = d + 8*(ffts_lanes_rev[j+1] >> shift);
+		float32x4_t r0 = vld1q_f32(x), r1 = vld1q_f32(x + 4);
+		float32x4_t r2 = vld1q_f32(y), r3 = vld1q_f32(y + 4);
+		ffts_lanes_tr_4(&r0, &r1, &r2, &r3);
+		vst1q_f32(dst + 2*j, r0);
+		vst1q_f32(dst + dist + 2*j, r1);
+		vst1q_f32(dst + 2*dist + 2*j, r2);
+		vst1q_f32(dst + 3*dist + 2*j, r3);
+	}
+}
+
+__INLINE void ffts_lanes_cols_in_4(float *d, const float *src, size_t stride, size_t N) {
+	size_t j;
+	for(j=0;j<N;j++) {
+		float32x4x2_t v = vld2q_f32(src + j*stride);
+		vst1q_f32(d + 8*j, v.val[0]);
+		vst1q_f32(d + 8*j + 4, v.val[1]);
+	}
+}
+
+__INLINE void ffts_lanes_cols_out_4(float *dst, size_t stride, const float *d, size_t N, int shift) {
+	size_t j;
+	for(j=0;j<N;j++) {
+		const float *x = d + 8*(ffts_lanes_rev[j] >> shift);
+		float32x4x2_t v;
+		v.val[0] = vld1q_f32(x);
+		v.val[1] = vld1q_f32(x + 4);
+		vst2q_f32(dst + j*stride, v);
+	}
+}
+#endif
+
+#include "ffts_lanes_impl.h"
+
+#undef LANES
+#undef LV
+#undef LANES_FN
+#undef LANES_TARGET
+#undef LLD
+#undef LST
+#undef LADD
+#undef LSUB
+#undef LMUL
+#undef LSPLAT
+
+#ifdef FFTS_LANES_AVX
+#include <immintrin.h>
+
+#define LANES 8
+#define LV __m256
+#define LANES_FN(f) f##_8
+#define LANES_TARGET __attribute__((target("avx2,fma")))
+#define LLD _mm256_load_ps
+#define LST _mm256_store_ps
+#define LADD _mm256_add_ps
+#define LSUB _mm256_sub_ps
+#define LMUL _mm256_mul_ps
+#define LSPLAT _mm256_set1_ps
+
+// 4x4 transposes of r0..r3 within each 128-bit half
+LANES_TARGET __INLINE void ffts_lanes_tr_8(__m256 *r0, __m256 *r1, __m256 *r2, __m256 *r3) {
+	__m256 t0 = _mm256_unpacklo_ps(*r0, *r1), t1 = _mm256_unpackhi_ps(*r0, *r1);
+	__m256 t2 = _mm256_unpacklo_ps(*r2, *r3), t3 = _mm256_unpackhi_ps(*r2, *r3);
+	*r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1,0,1,0));
+	*r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3,2,3,2));
+	*r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1,0,1,0));
+	*r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3,2,3,2));
+}
+
+// transforms b and b+4 share a vector, in the low and high halves
+LANES_TARGET __INLINE __m256 ffts_lanes_ld2_8(const float *lo, const float *hi) {
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+}
+
+LANES_TARGET __INLINE void ffts_lanes_st2_8(float *lo, float *hi, __m256 x) {
+	_mm_storeu_ps(lo, _mm256_castps256_ps128(x));
+	_mm_storeu_ps(hi, _mm256_extractf128_ps(x, 1));
+}
+
+LANES_TARGET __INLINE void ffts_lanes_rows_in_8(float *d, const float *src, size_t dist, size_t N) {
+	size_t j;
+	for(j=0;j<N;j+=2) {
+		const float *s = src + 2*j;
+		__m256 r0 = ffts_lanes_ld2_8(s, s + 4*dist);
+		__m256 r1 = ffts_lanes_ld2_8(s + dist, s + 5*dist);
+		__m256 r2 = ffts_lanes_ld2_8(s + 2*dist, s + 6*dist);
+		__m256 r3 = ffts_lanes_ld2_8(s + 3*dist, s + 7*dist);
+		ffts_lanes_tr_8(&r0, &r1, &r2, &r3);
+		_mm256_store_ps(d + 16*j, r0);
+		_mm256_store_ps(d + 16*j + 8, r1);
+		_mm256_store_ps(d + 16*j + 16, r2);
+		_mm256_store_ps(d + 16*j + 24, r3);
+	}
+}
+
+LANES_TARGET __INLINE void ffts_lanes_rows_out_8(float *dst, size_t dist, const float *d, size_t N, int shift) {
+	size_t j;
+	for(j=0;j<N;j+=2) {
+		const float *x = d + 16*(ffts_lanes_rev[j] >> shift);
+		const float *y = d + 16*(ffts_lanes_rev[j+1] >> shift);
+		float *s = dst + 2*j;
+		__m256 r0 = _mm256_load_ps(x), r1 = _mm256_load_ps(x + 8);
+		__m256 r2 = _mm256_load_ps(y), r3 = _mm256_load_ps(y + 8);
+		ffts_lanes_tr_8(&r0, &r1, &r2, &r3);
+		ffts_lanes_st2_8(s, s + 4*dist, r0);
+		ffts_lanes_st2_8(s + dist, s + 5*dist, r1);
+		ffts_lanes_st2_8(s + 2*dist, s + 6*dist, r2);
+		ffts_lanes_st2_8(s + 3*dist, s + 7*dist, r3);
+	}
+}
+
+// the shuffles leave the lanes in the order 0 1 4 5 2 3 6 7; the
+// permutes put them back, so every input layout meets every output one
+LANES_TARGET __INLINE void ffts_lanes_cols_in_8(float *d, const float *src, size_t stride, size_t N) {
+	size_t j;
+	for(j=0;j<N;j++) {
+		__m256 a = _mm256_loadu_ps(src + j*stride), b = _mm256_loadu_ps(src + j*stride + 8);
+		__m256d re = _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)));
+		__m256d im = _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1)));
+		_mm256_store_ps(d + 16*j, _mm256_castpd_ps(_mm256_permute4x64_pd(re, _MM_SHUFFLE(3,1,2,0))));
+		_mm256_store_ps(d + 16*j + 8, _mm256_castpd_ps(_mm256_permute4x64_pd(im, _MM_SHUFFLE(3,1,2,0))));
+	}
+}
+
+// the unpacks give elements 0 1 4 5 and 2 3 6 7; their halves are swapped
+LANES_TARGET __INLINE void ffts_lanes_cols_out_8(float *dst, size_t stride, const float *d, size_t N, int shift) {
+	size_t j;
+	for(j=0;j<N;j++) {
+		const float *x = d + 16*(ffts_lanes_rev[j] >> shift);
+		__m256 re = _mm256_load_ps(x), im = _mm256_load_ps(x + 8);
+		__m256 lo = _mm256_unpacklo_ps(re, im), hi = _mm256_unpackhi_ps(re, im);
+		_mm256_storeu_ps(dst + j*stride, _mm256_permute2f128_ps(lo, hi, 0x20));
+		_mm256_storeu_ps(dst + j*stride + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+	}
+}
+
+#include "ffts_lanes_impl.h"
+#endif
+
+#endif
+
+int ffts_lanes_init(ffts_plan_t *p) {
+#ifdef FFTS_LANES
+	const ffts_twiddle_t *tw;
+	size_t N = p->N, e, l;
+	int isa;
+	float *w;
+
+	if(N < 2 || N > FFTS_LANES_MAX || (N & (N - 1)) || p->howmany < 4) return -1;
+
+#if defined(FFTS_LANES_AVX)
+	isa = (ffts_cpu_isa() == FFTS_ISA_AVX2 && p->howmany >= 8) ? FFTS_ISA_AVX2 : FFTS_ISA_SSE;
+#elif defined(HAVE_SSE)
+	isa = FFTS_ISA_SSE;
+#else
+	isa = FFTS_ISA_NEON;
+#endif
+	if(isa != FFTS_ISA_AVX2 && N > FFTS_LANES_MAX_4) return -1;
+
+	// the same float twiddles as the single plans, from the master table
+	tw = ffts_twiddle_table(N);
+	w = valloc(sizeof(float) * 2*FFTS_LANES_W * N);
+	if(!w) return -1;
+	for(e=0;e<N;e++) {
+		float x[2];
+		ffts_lut_twiddle(tw, N, e, x);
+		for(l=0;l<FFTS_LANES_W;l++) {
+			w[2*FFTS_LANES_W*e + l] = x[0];
+			w[2*FFTS_LANES_W*e + FFTS_LANES_W + l] = (p->sign < 0) ? x[1] : -x[1];
+		}
+	}
+	p->ws = w;
+	p->isa = isa;
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+size_t ffts_lanes_execute(ffts_plan_t *p, const float *in, float *out) {
+	size_t i = 0;
+
+#ifdef FFTS_LANES_AVX
+	if(p->isa == FFTS_ISA_AVX2) i = ffts_lanes_run_8(p, in, out, 0);
+#endif
+#ifdef FFTS_LANES
+	// the last few transforms are done four at a time
+	if(p->N <= FFTS_LANES_MAX_4) i = ffts_lanes_run_4(p, in, out, i);
+#endif
+	return i;
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
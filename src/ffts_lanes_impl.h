@@ -0,0 +1,197 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/*
+ * The lane kernels, written once for any vector width. ffts_lanes.c
+ * includes this for each width with LANES, the vector type LV, its
+ * operations (LLD, LST, LADD, LSUB, LMUL, LSPLAT), LANES_FN for naming,
+ * LANES_TARGET for the instruction set, and the transposes in and out of
+ * the lane layout, LANES_FN(ffts_lanes_rows_in) etc., defined.
+ *
+ * A group of LANES transforms is held in d with the real parts of
+ * element j at d + 2*LANES*j and the imaginary parts after them.
+ */
+
+// x *= W_N^e, where w[2*FFTS_LANES_W*e] holds the splatted W_N^e
+LANES_TARGET __INLINE void LANES_FN(ffts_lanes_twiddle)(LV *xr, LV *xi, const float *w,
+                                                      size_t e, size_t N, int sign) {
+	LV r = *xr, m = *xi;
+
+	if(!e) return;
+	if(e == N/4) {
+		// sign * i
+		LV z = LSPLAT(0.0f);
+		*xr = (sign < 0) ? m : LSUB(z, m);
+		*xi = (sign < 0) ? LSUB(z, r) : r;
+	}else if(N >= 8 && (e == N/8 || e == 3*N/8)) {
+		// (1 + sign i) / sqrt 2 and (-1 + sign i) / sqrt 2
+		LV h = LSPLAT(0.70710678118654752440f), nh = LSPLAT(-0.70710678118654752440f);
+		LV a = LADD(r, m), b = LSUB(m, r);
+		if(e == N/8) {
+			*xr = LMUL(h, (sign < 0) ? a : LSUB(r, m));
+			*xi = LMUL(h, (sign < 0) ? b : a);
+		}else{
+			*xr = (sign < 0) ? LMUL(h, b) : LMUL(nh, a);
+			*xi = (sign < 0) ? LMUL(nh, a) : LMUL(h, LSUB(r, m));
+		}
+	}else{
+		LV c = LLD(w + 2*FFTS_LANES_W*e);
+		LV s = LLD(w + 2*FFTS_LANES_W*e + FFTS_LANES_W);
+		*xr = LSUB(LMUL(r, c), LMUL(m, s));
+		*xi = LADD(LMUL(r, s), LMUL(m, c));
+	}
+}
+
+/*
+ * Radix-2 decimation in frequency, with the stages taken two at a time
+ * as radix-4 butterflies: natural order in, bit reversed order out.
+ */
+LANES_TARGET __INLINE void LANES_FN(ffts_lanes_fft)(float *d, const float *w, size_t N, int sign) {
+	size_t L, b, k;
+
+	LANES_UNROLL
+	for(L=N;L>=4;L/=4) {
+		size_t q = L/4, s = N/L;
+		LANES_UNROLL
+		for(b=0;b<N;b+=L) {
+			LANES_UNROLL
+			for(k=0;k<q;k++) {
+				float *x0 = d + 2*LANES*(b + k);
+				float *x1 = x0 + 2*LANES*q;
+				float *x2 = x1 + 2*LANES*q;
+				float *x3 = x2 + 2*LANES*q;
+				LV t0r = LADD(LLD(x0), LLD(x2)), t0i = LADD(LLD(x0 + LANES), LLD(x2 + LANES));
+				LV t1r = LSUB(LLD(x0), LLD(x2)), t1i = LSUB(LLD(x0 + LANES), LLD(x2 + LANES));
+				LV t2r = LADD(LLD(x1), LLD(x3)), t2i = LADD(LLD(x1 + LANES), LLD(x3 + LANES));
+				LV dr  = LSUB(LLD(x1), LLD(x3)), di  = LSUB(LLD(x1 + LANES), LLD(x3 + LANES));
+				LV yr = LSUB(t0r, t2r), yi = LSUB(t0i, t2i);
+				LV zr, zi, ur, ui;
+
+				// t1 + sign i d and t1 - sign i d
+				if(sign < 0) {
+					zr = LADD(t1r, di); zi = LSUB(t1i, dr);
+					ur = LSUB(t1r, di); ui = LADD(t1i, dr);
+				}else{
+					zr = LSUB(t1r, di); zi = LADD(t1i, dr);
+					ur = LADD(t1r, di); ui = LSUB(t1i, dr);
+				}
+				LANES_FN(ffts_lanes_twiddle)(&yr, &yi, w, 2*k*s, N, sign);
+				LANES_FN(ffts_lanes_twiddle)(&zr, &zi, w, k*s, N, sign);
+				LANES_FN(ffts_lanes_twiddle)(&ur, &ui, w, 3*k*s, N, sign);
+
+				LST(x0, LADD(t0r, t2r)); LST(x0 + LANES, LADD(t0i, t2i));
+				LST(x1, yr); LST(x1 + LANES, yi);
+				LST(x2, zr); LST(x2 + LANES, zi);
+				LST(x3, ur); LST(x3 + LANES, ui);
+			}
+		}
+	}
+
+	if(L == 2) {
+		LANES_UNROLL
+		for(b=0;b<N;b+=2) {
+			float *x0 = d + 2*LANES*b;
+			float *x1 = x0 + 2*LANES;
+			LV ar = LLD(x0), ai = LLD(x0 + LANES);
+			LV br = LLD(x1), bi = LLD(x1 + LANES);
+			LST(x0, LADD(ar, br)); LST(x0 + LANES, LADD(ai, bi));
+			LST(x1, LSUB(ar, br)); LST(x1 + LANES, LSUB(ai, bi));
+		}
+	}
+}
+
+LANES_TARGET __INLINE size_t LANES_FN(ffts_lanes_loop)(ffts_plan_t *p, const float *in, float *out,
+                                                     size_t first, size_t N, int sign) {
+	float __attribute__((aligned(32))) d[2*LANES*FFTS_LANES_MAX];
+	const float *w = (const float *)p->ws;
+	size_t is = 2*p->istride, id = 2*p->idist;
+	size_t os = 2*p->ostride, od = 2*p->odist;
+	int shift = 5 - __builtin_ctzl(N);
+	size_t g, j, l;
+
+	for(g=first;g+LANES<=p->howmany;g+=LANES) {
+		const float *src = in + g*id;
+		float *dst = out + g*od;
+
+		if(is == 2) LANES_FN(ffts_lanes_rows_in)(d, src, id, N);
+		else if(id == 2) LANES_FN(ffts_lanes_cols_in)(d, src, is, N);
+		else{
+			for(j=0;j<N;j++) {
+				for(l=0;l<LANES;l++) {
+					d[2*LANES*j + l] = src[l*id + j*is];
+					d[2*LANES*j + LANES + l] = src[l*id + j*is + 1];
+				}
+			}
+		}
+
+		LANES_FN(ffts_lanes_fft)(d, w, N, sign);
+
+		if(os == 2) LANES_FN(ffts_lanes_rows_out)(dst, od, d, N, shift);
+		else if(od == 2) LANES_FN(ffts_lanes_cols_out)(dst, os, d, N, shift);
+		else{
+			for(j=0;j<N;j++) {
+				const float *x = d + 2*LANES*(ffts_lanes_rev[j] >> shift);
+				for(l=0;l<LANES;l++) {
+					dst[l*od + j*os] = x[l];
+					dst[l*od + j*os + 1] = x[LANES + l];
+				}
+			}
+		}
+	}
+	return g;
+}
+
+// the loop specialized for each size and direction
+LANES_TARGET static size_t LANES_FN(ffts_lanes_run)(ffts_plan_t *p, const float *in, float *out,
+                                                  size_t first) {
+	if(p->sign < 0) {
+		switch(p->N) {
+			case 2:  return LANES_FN(ffts_lanes_loop)(p, in, out, first, 2, -1);
+			case 4:  return LANES_FN(ffts_lanes_loop)(p, in, out, first, 4, -1);
+			case 8:  return LANES_FN(ffts_lanes_loop)(p, in, out, first, 8, -1);
+			case 16: return LANES_FN(ffts_lanes_loop)(p, in, out, first, 16, -1);
+			case 32: return LANES_FN(ffts_lanes_loop)(p, in, out, first, 32, -1);
+		}
+	}else{
+		switch(p->N) {
+			case 2:  return LANES_FN(ffts_lanes_loop)(p, in, out, first, 2, 1);
+			case 4:  return LANES_FN(ffts_lanes_loop)(p, in, out, first, 4, 1);
+			case 8:  return LANES_FN(ffts_lanes_loop)(p, in, out, first, 8, 1);
+			case 16: return LANES_FN(ffts_lanes_loop)(p, in, out, first, 16, 1);
+			case 32: return LANES_FN(ffts_lanes_loop)(p, in, out, first, 32, 1);
+		}
+	}
+	return first;
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
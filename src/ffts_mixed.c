@@ -0,0 +1,354 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_mixed.h"
+#include "macros.h"
+#include "ffts_cpu.h"
+
+#include <string.h>
+
+/*
+ * Transforms of size N = P * m, where P is a power of two and m > 1 only has
+ * factors 3, 5 and 7.
+ *
+ * The input is viewed as a P x m matrix (x[m*n2 + n1]). Each of the m columns
+ * is transformed with a power-of-two plan of size P and stored as row n1 of an
+ * m x P matrix, which is then multiplied by the twiddles W_N^(n1*k2). The
+ * remaining size m transforms run down the columns of that matrix with
+ * Stockham radix-3/5/7 passes, which leave the result in natural order. Every
+ * butterfly operates on whole rows, so the passes are vectorized across the P
+ * independent transforms; when P is 1 the rows are padded to two lanes.
+ */
+
+int ffts_mixed_supported(size_t N) {
+	if(!N) return 0;
+	while(!(N & 1)) N >>= 1;
+	while(!(N % 3)) N /= 3;
+	while(!(N % 5)) N /= 5;
+	while(!(N % 7)) N /= 7;
+	return N == 1;
+}
+
+static void ffts_mixed_twiddle(float *w, double re, double im) {
+	w[0] = w[1] = w[2] = w[3] = re;
+	w[4] = w[6] = im;
+	w[5] = w[7] = -im;
+}
+
+static void ffts_mixed_pass_3(int inv, const float *in, float *out, size_t m, size_t L, const float *tw) {
+	const V c1 = VLIT4(-0.5f, -0.5f, -0.5f, -0.5f);
+	const V s1 = VLIT4(0.86602540378443864676f, 0.86602540378443864676f, 0.86602540378443864676f, 0.86602540378443864676f);
+
+	size_t p, i;
+	for(p=0;p<m;p++) {
+		const float *i0 = in + p*L;
+		const float *i1 = i0 + m*L;
+		const float *i2 = i1 + m*L;
+		float *o0 = out + 3*p*L;
+		float *o1 = o0 + L;
+		float *o2 = o1 + L;
+
+		for(i=0;i<L;i+=4) {
+			V a0 = VLD(i0 + i), a1 = VLD(i1 + i), a2 = VLD(i2 + i);
+			V t1 = VADD(a1, a2);
+			V t2 = VADD(a0, VMUL(c1, t1));
+			V t3 = IMULI(inv, VMUL(s1, VSUB(a1, a2)));
+			V y1 = VADD(t2, t3);
+			V y2 = VSUB(t2, t3);
+			if(p) {
+				y1 = IMUL(y1, VLD(tw    ), VLD(tw + 4));
+				y2 = IMUL(y2, VLD(tw + 8), VLD(tw + 12));
+			}
+			VSTU(o0 + i, VADD(a0, t1));
+			VSTU(o1 + i, y1);
+			VSTU(o2 + i, y2);
+		}
+		tw += 2*8;
+	}
+}
+
+static void ffts_mixed_pass_5(int inv, const float *in, float *out, size_t m, size_t L, const float *tw) {
+	const V c1 = VLIT4( 0.30901699437494742410f,  0.30901699437494742410f,  0.30901699437494742410f,  0.30901699437494742410f);
+	const V c2 = VLIT4(-0.80901699437494742410f, -0.80901699437494742410f, -0.80901699437494742410f, -0.80901699437494742410f);
+	const V s1 = VLIT4( 0.95105651629515357212f,  0.95105651629515357212f,  0.95105651629515357212f,  0.95105651629515357212f);
+	const V s2 = VLIT4( 0.58778525229247312917f,  0.58778525229247312917f,  0.58778525229247312917f,  0.58778525229247312917f);
+
+	size_t p, i;
+	for(p=0;p<m;p++) {
+		const float *i0 = in + p*L;
+		float *o0 = out + 5*p*L;
+
+		for(i=0;i<L;i+=4) {
+			V a0 = VLD(i0 + i);
+			V a1 = VLD(i0 + 1*m*L + i);
+			V a2 = VLD(i0 + 2*m*L + i);
+			V a3 = VLD(i0 + 3*m*L + i);
+			V a4 = VLD(i0 + 4*m*L + i);
+			V b1 = VADD(a1, a4), d1 = VSUB(a1, a4);
+			V b2 = VADD(a2, a3), d2 = VSUB(a2, a3);
+			V r1 = VADD(a0, VADD(VMUL(c1, b1), VMUL(c2, b2)));
+			V r2 = VADD(a0, VADD(VMUL(c2, b1), VMUL(c1, b2)));
+			V j1 = IMULI(inv, VADD(VMUL(s1, d1), VMUL(s2, d2)));
+			V j2 = IMULI(inv, VSUB(VMUL(s2, d1), VMUL(s1, d2)));
+			V y[4];
+			y[0] = VADD(r1, j1);
+			y[1] = VADD(r2, j2);
+			y[2] = VSUB(r2, j2);
+			y[3] = VSUB(r1, j1);
+			VSTU(o0 + i, VADD(a0, VADD(b1, b2)));
+
+			size_t k;
+			for(k=0;k<4;k++) {
+				if(p) y[k] = IMUL(y[k], VLD(tw + k*8), VLD(tw + k*8 + 4));
+				VSTU(o0 + (k+1)*L + i, y[k]);
+			}
+		}
+		tw += 4*8;
+	}
+}
+
+static void ffts_mixed_pass_7(int inv, const float *in, float *out, size_t m, size_t L, const float *tw) {
+	static const float c[3][3] = {
+		{  0.62348980185873353053f, -0.22252093395631440429f, -0.90096886790241912624f },
+		{ -0.22252093395631440429f, -0.90096886790241912624f,  0.62348980185873353053f },
+		{ -0.90096886790241912624f,  0.62348980185873353053f, -0.22252093395631440429f }
+	};
+	static const float s[3][3] = {
+		{  0.78183148246802980871f,  0.97492791218182360702f,  0.43388373911755812048f },
+		{  0.97492791218182360702f, -0.43388373911755812048f, -0.78183148246802980871f },
+		{  0.43388373911755812048f, -0.78183148246802980871f,  0.97492791218182360702f }
+	};
+
+	size_t p, i, j, k;
+	for(p=0;p<m;p++) {
+		const float *i0 = in + p*L;
+		float *o0 = out + 7*p*L;
+
+		for(i=0;i<L;i+=4) {
+			V a0 = VLD(i0 + i);
+			V b[3], d[3], y0 = a0;
+			for(j=0;j<3;j++) {
+				V x0 = VLD(i0 + (j+1)*m*L + i);
+				V x1 = VLD(i0 + (6-j)*m*L + i);
+				b[j] = VADD(x0, x1);
+				d[j] = VSUB(x0, x1);
+				y0 = VADD(y0, b[j]);
+			}
+			VSTU(o0 + i, y0);
+
+			for(k=0;k<3;k++) {
+				V r = a0, q = VLIT4(0.0f, 0.0f, 0.0f, 0.0f);
+				for(j=0;j<3;j++) {
+					r = VADD(r, VMUL(VLIT4(c[k][j], c[k][j], c[k][j], c[k][j]), b[j]));
+					q = VADD(q, VMUL(VLIT4(s[k][j], s[k][j], s[k][j], s[k][j]), d[j]));
+				}
+				q = IMULI(inv, q);
+				V ya = VADD(r, q);
+				V yb = VSUB(r, q);
+				if(p) {
+					ya = IMUL(ya, VLD(tw + k*8),     VLD(tw + k*8 + 4));
+					yb = IMUL(yb, VLD(tw + (5-k)*8), VLD(tw + (5-k)*8 + 4));
+				}
+				VSTU(o0 + (k+1)*L + i, ya);
+				VSTU(o0 + (6-k)*L + i, yb);
+			}
+		}
+		tw += 6*8;
+	}
+}
+
+void ffts_free_1d_mixed(ffts_plan_t *p) {
+	if(p->plans && p->plans[0]) ffts_free(p->plans[0]);
+	free(p->plans);
+	free(p->factors);
+	FFTS_FREE(p->A);
+	FFTS_FREE(p->B);
+	FFTS_FREE(p->buf);
+	free(p);
+}
+
+void ffts_execute_1d_mixed(ffts_plan_t *p, const void *vin, void *vout) {
+	const float *in = (const float *)vin;
+	float *out = (float *)vout;
+	ffts_plan_t *row = p->plans[0];
+	size_t m = 1, P, L, i, j, k;
+	int inv = p->sign < 0;
+
+	for(k=0;p->factors[k];k++) m *= p->factors[k];
+	P = p->N / m;
+	L = (P < 2 ? 2 : P) * 2;
+
+	float *buf0 = (float *)p->buf;
+	float *buf1 = buf0 + m*L;
+	float *tmp  = buf1 + m*L;
+
+	// size P transforms of the columns, into the rows of buf0, then twiddle
+	const float *tw = p->A;
+	for(i=0;i<m;i++) {
+		float *r = buf0 + i*L;
+		if(row) {
+			for(j=0;j<P;j++) {
+				tmp[2*j]   = in[2*(m*j + i)];
+				tmp[2*j+1] = in[2*(m*j + i) + 1];
+			}
+			row->transform(row, tmp, r);
+		}else{
+			r[0] = in[2*i];
+			r[1] = in[2*i+1];
+			r[2] = r[3] = 0.0f;
+		}
+		for(j=0;j<L;j+=4) {
+			VST(r + j, IMUL(VLD(r + j), VLD(tw), VLD(tw + 4)));
+			tw += 8;
+		}
+	}
+
+	// size m transforms down the columns
+	const float *src = buf0;
+	size_t n = m, s = 1;
+	tw = p->B;
+	for(k=0;p->factors[k];k++) {
+		size_t r = p->factors[k];
+		float *dst;
+
+		if(!p->factors[k+1]) dst = (P < 2) ? tmp : out;
+		else                 dst = (src == buf0) ? buf1 : buf0;
+
+		switch(r) {
+			case 3: ffts_mixed_pass_3(inv, src, dst, n/r, s*L, tw); break;
+			case 5: ffts_mixed_pass_5(inv, src, dst, n/r, s*L, tw); break;
+			case 7: ffts_mixed_pass_7(inv, src, dst, n/r, s*L, tw); break;
+		}
+
+		tw += (n/r) * (r-1) * 8;
+		src = dst;
+		n /= r;
+		s *= r;
+	}
+
+	if(P < 2) {
+		for(i=0;i<m;i++) {
+			out[2*i]   = tmp[4*i];
+			out[2*i+1] = tmp[4*i+1];
+		}
+	}
+}
+
+ffts_plan_t *ffts_init_1d_mixed(size_t N, int sign) {
+	size_t P = 1, m, L, nf = 0, i, j, k;
+
+	while(!(N & P)) P <<= 1;
+	m = N / P;
+	L = (P < 2 ? 2 : P) * 2;
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->transform = &ffts_execute_1d_mixed;
+	p->destroy = &ffts_free_1d_mixed;
+	p->N = N;
+	p->io_bytes = sizeof(float) * 4*N;
+	p->rank = 1;
+	p->sign = sign;
+
+	p->plans = calloc(1, sizeof(ffts_plan_t *));
+	if(!p->plans) {
+		free(p);
+		return NULL;
+	}
+	if(P > 1) p->plans[0] = ffts_init_1d(P, sign);
+	p->isa = p->plans[0] ? p->plans[0]->isa : ffts_cpu_base_isa();
+
+	// odd radices, largest first, zero terminated
+	for(k=m;k>1;nf++) k /= (!(k % 7)) ? 7 : (!(k % 5)) ? 5 : 3;
+	p->factors = malloc(sizeof(size_t) * (nf + 1));
+
+	size_t tw_size = 0, n = m;
+	for(k=m;p->factors && k>1;) {
+		size_t r = (!(k % 7)) ? 7 : (!(k % 5)) ? 5 : 3;
+		tw_size += (k / r) * (r - 1);
+		k /= r;
+	}
+
+	p->A = FFTS_MALLOC(sizeof(float) * m * L * 2, 32);
+	p->B = FFTS_MALLOC(sizeof(float) * 8 * (tw_size ? tw_size : 1), 32);
+	p->buf_size = sizeof(float) * (2 * m * L + (P < 2 ? m * L : P * 2));
+	p->transpose_buf_size = 0;
+	p->nplans = (P > 1) ? 1 : 0;
+	p->buf = FFTS_MALLOC(p->buf_size, 32);
+
+	if((P > 1 && !p->plans[0]) || !p->factors || !p->A || !p->B || !p->buf) {
+		ffts_free_1d_mixed(p);
+		return NULL;
+	}
+
+	for(i=0,k=m;k>1;i++) {
+		p->factors[i] = (!(k % 7)) ? 7 : (!(k % 5)) ? 5 : 3;
+		k /= p->factors[i];
+	}
+	p->factors[nf] = 0;
+
+	// twiddles for the size P columns: W_N^(n1*k2), two complex at a time
+	float *A = p->A;
+	for(i=0;i<m;i++) {
+		for(j=0;j<L/2;j+=2) {
+			double a0 = sign * 2.0 * PI * (double)((i * j) % N) / (double)N;
+			double a1 = sign * 2.0 * PI * (double)((i * (j+1)) % N) / (double)N;
+			A[0] = A[1] = cos(a0);
+			A[2] = A[3] = cos(a1);
+			A[4] = sin(a0);
+			A[5] = -sin(a0);
+			A[6] = sin(a1);
+			A[7] = -sin(a1);
+			A += 8;
+		}
+	}
+
+	// twiddles for the Stockham passes: W_n^(p*k), k = 1..r-1, per pass
+	float *B = p->B;
+	for(k=0;k<nf;k++) {
+		size_t r = p->factors[k];
+		for(i=0;i<n/r;i++) {
+			for(j=1;j<r;j++) {
+				double a = sign * 2.0 * PI * (double)(i * j) / (double)n;
+				ffts_mixed_twiddle(B, cos(a), sin(a));
+				B += 8;
+			}
+		}
+		n /= r;
+	}
+
+	return p;
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -32,9 +32,11 @@
 */
 
 #include "ffts_nd.h"
+#include "ffts_inplace.h"
 
-#ifdef HAVE_NEON
-#include "neon.h"
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#include <unistd.h>
 #endif
 
 void ffts_free_nd(ffts_plan_t *p) {
@@ -45,7 +47,7 @@ void ffts_free_nd(ffts_plan_t *p) {
 		ffts_plan_t *x = p->plans[i];
 		int k;
 		for(k=0;k<i;k++) {
-			if(p->Ms[i] == p->Ms[k]) x = NULL;
+			if(p->plans[k] == x) x = NULL;
 		}
 		
 		if(x)	ffts_free(x);
@@ -58,218 +60,93 @@ void ffts_free_nd(ffts_plan_t *p) {
 	free(p->transpose_buf);
 	free(p);
 }
-#define TSIZE 8
 #include <string.h>
-void ffts_transpose(uint64_t *in, uint64_t *out, int w, int h, uint64_t *buf) {
-
-#ifdef HAVE_NEON 
-	size_t i,j,k;
-	int linebytes = w*8;
-
-	for(j=0;j<h;j+=8) {
-		for(i=0;i<w;i+=8) {
-			neon_transpose_to_buf(in + j*w + i, buf, w);
-
-			uint64_t *p = out + i*h + j;
-			uint64_t *pbuf = buf;
-			uint64_t *ptemp;
-
-			__asm__ __volatile__(
-							 "mov %[ptemp], %[p]\n\t"
-							 "add %[p], %[p], %[w], lsl #3\n\t"
-							 "vld1.32 {q8,q9}, [%[pbuf], :128]!\n\t"
-							 "vld1.32 {q10,q11}, [%[pbuf], :128]!\n\t"
-							 "vld1.32 {q12,q13}, [%[pbuf], :128]!\n\t"
-							 "vld1.32 {q14,q15}, [%[pbuf], :128]!\n\t"
-							 "vst1.32 {q8,q9}, [%[ptemp], :128]!\n\t"
-							 "vst1.32 {q10,q11}, [%[ptemp], :128]!\n\t"
-							 "mov %[ptemp], %[p]\n\t" 
-							 "add %[p], %[p], %[w], lsl #3\n\t"
-							 "vst1.32 {q12,q13}, [%[ptemp], :128]!\n\t"
-							 "vst1.32 {q14,q15}, [%[ptemp], :128]!\n\t"
-							 "mov %[ptemp], %[p]\n\t"
-							 "add %[p], %[p], %[w], lsl #3\n\t"
-							 "vld1.32 {q8,q9}, [%[pbuf], :128]!\n\t"
-							 "vld1.32 {q10,q11}, [%[pbuf], :128]!\n\t"
-							 "vld1.32 {q12,q13}, [%[pbuf], :128]!\n\t"
-							 "vld1.32 {q14,q15}, [%[pbuf], :128]!\n\t"
-							 "vst1.32 {q8,q9}, [%[ptemp], :128]!\n\t"
-							 "vst1.32 {q10,q11}, [%[ptemp], :128]!\n\t"
-							 "mov %[ptemp], %[p]\n\t" 
-							 "add %[p], %[p], %[w], lsl #3\n\t"
-							 "vst1.32 {q12,q13}, [%[ptemp], :128]!\n\t"
-							 "vst1.32 {q14,q15}, [%[ptemp], :128]!\n\t"
-							 "mov %[ptemp], %[p]\n\t"
-							 "add %[p], %[p], %[w], lsl #3\n\t"
-							 "vld1.32 {q8,q9}, [%[pbuf], :128]!\n\t"
-							 "vld1.32 {q10,q11}, [%[pbuf], :128]!\n\t"
-							 "vld1.32 {q12,q13}, [%[pbuf], :128]!\n\t"
-							 "vld1.32 {q14,q15}, [%[pbuf], :128]!\n\t"
-							 "vst1.32 {q8,q9}, [%[ptemp], :128]!\n\t"
-							 "vst1.32 {q10,q11}, [%[ptemp], :128]!\n\t"
-							 "mov %[ptemp], %[p]\n\t" 
-							 "add %[p], %[p], %[w], lsl #3\n\t"
-							 "vst1.32 {q12,q13}, [%[ptemp], :128]!\n\t"
-							 "vst1.32 {q14,q15}, [%[ptemp], :128]!\n\t"
-							 "mov %[ptemp], %[p]\n\t"
-							 "add %[p], %[p], %[w], lsl #3\n\t"
-							 "vld1.32 {q8,q9}, [%[pbuf], :128]!\n\t"
-							 "vld1.32 {q10,q11}, [%[pbuf], :128]!\n\t"
-							 "vld1.32 {q12,q13}, [%[pbuf], :128]!\n\t"
-							 "vld1.32 {q14,q15}, [%[pbuf], :128]!\n\t"
-							 "vst1.32 {q8,q9}, [%[ptemp], :128]!\n\t"
-							 "vst1.32 {q10,q11}, [%[ptemp], :128]!\n\t"
-							 "mov %[ptemp], %[p]\n\t" 
-							 "vst1.32 {q12,q13}, [%[ptemp], :128]!\n\t"
-							 "vst1.32 {q14,q15}, [%[ptemp], :128]!\n\t"
-							 
-						: [p] "+r" (p), [pbuf] "+r" (pbuf), [ptemp] "+r" (ptemp)
-						: [w] "r" (w)
-						: "memory", "q8", "q9", "q10", "q11"
-						);
-//			out[i*h + j] = in[j*w + i];
-		}
-	}
-#else
-#ifdef HAVE_SSE
-	uint64_t tmp[TSIZE*TSIZE] __attribute__((aligned(64)));
-	int tx, ty;
-	int x, y;
-	int tw = w / TSIZE;
-	int th = h / TSIZE;
-	for (ty=0;ty<th;ty++) {
-		for (tx=0;tx<tw;tx++) {
-			uint64_t *ip0 = in + w*TSIZE*ty + tx * TSIZE;
-			uint64_t *op0 = tmp;//out + h*TSIZE*tx + ty*TSIZE;
-
-			// Copy/transpose to tmp
-			for (y=0;y<TSIZE;y+=2) {
-				//for (x=0;x<TSIZE;x+=2) {
-					//op[x*TSIZE] = ip[x];
-					__m128d q0 = _mm_load_pd((double *)(ip0 + 0*w));
-					__m128d q1 = _mm_load_pd((double *)(ip0 + 1*w));
-					__m128d q2 = _mm_load_pd((double *)(ip0 + 2*w));
-					__m128d q3 = _mm_load_pd((double *)(ip0 + 3*w));
-					__m128d q4 = _mm_load_pd((double *)(ip0 + 4*w));
-					__m128d q5 = _mm_load_pd((double *)(ip0 + 5*w));
-					__m128d q6 = _mm_load_pd((double *)(ip0 + 6*w));
-					__m128d q7 = _mm_load_pd((double *)(ip0 + 7*w));
-					ip0 += 2;	
-					
-					__m128d t0 = _mm_shuffle_pd(q0, q1, _MM_SHUFFLE2(0, 0));
-					__m128d t1 = _mm_shuffle_pd(q0, q1, _MM_SHUFFLE2(1, 1));
-					__m128d t2 = _mm_shuffle_pd(q2, q3, _MM_SHUFFLE2(0, 0));
-					__m128d t3 = _mm_shuffle_pd(q2, q3, _MM_SHUFFLE2(1, 1));
-					__m128d t4 = _mm_shuffle_pd(q4, q5, _MM_SHUFFLE2(0, 0));
-					__m128d t5 = _mm_shuffle_pd(q4, q5, _MM_SHUFFLE2(1, 1));
-					__m128d t6 = _mm_shuffle_pd(q6, q7, _MM_SHUFFLE2(0, 0));
-					__m128d t7 = _mm_shuffle_pd(q6, q7, _MM_SHUFFLE2(1, 1));
-					//_mm_store_pd((double *)(op0 + y*h + x), t0);
-					//_mm_store_pd((double *)(op0 + y*h + x + h), t1);
-					_mm_store_pd((double *)(op0 + 0), t0);
-					_mm_store_pd((double *)(op0 + 0 + TSIZE), t1);
-					_mm_store_pd((double *)(op0 + 2 ), t2);
-					_mm_store_pd((double *)(op0 + 2 + TSIZE), t3);
-					_mm_store_pd((double *)(op0 + 4 ), t4);
-					_mm_store_pd((double *)(op0 + 4 + TSIZE), t5);
-					_mm_store_pd((double *)(op0 + 6 ), t6);
-					_mm_store_pd((double *)(op0 + 6 + TSIZE), t7);
-				//}
-				op0 += 2*TSIZE;
-			}
-			
-			op0 = out + h*tx*TSIZE + ty*TSIZE;
-			ip0 = tmp;
-			for (y=0;y<TSIZE;y+=1) {
-		//		memcpy(op0, ip0, TSIZE * sizeof(*ip0));
-				
-				__m128d q0 = _mm_load_pd((double *)(ip0 + 0));
-				__m128d q1 = _mm_load_pd((double *)(ip0 + 2));
-				__m128d q2 = _mm_load_pd((double *)(ip0 + 4));
-				__m128d q3 = _mm_load_pd((double *)(ip0 + 6));
-				_mm_store_pd((double *)(op0 + 0), q0);
-				_mm_store_pd((double *)(op0 + 2), q1);
-				_mm_store_pd((double *)(op0 + 4), q2);
-				_mm_store_pd((double *)(op0 + 6), q3);
-				
-				op0 += h;
-				ip0 += TSIZE;
-			}
 
-		}
-	}
 /*
-	size_t i,j;
-	for(i=0;i<w;i+=2) {
-		for(j=0;j<h;j+=2) {
-//		out[i*h + j] = in[j*w + i];
-  		__m128d q0 = _mm_load_pd((double *)(in + j*w + i));
-  		__m128d q1 = _mm_load_pd((double *)(in + j*w + i + w));
-  		__m128d t0 = _mm_shuffle_pd(q0, q1, _MM_SHUFFLE2(0, 0));
-  		__m128d t1 = _mm_shuffle_pd(q0, q1, _MM_SHUFFLE2(1, 1));
-  		_mm_store_pd((double *)(out + i*h + j), t0);
-  		_mm_store_pd((double *)(out + i*h + j + h), t1);
-		}
-	}
-*/
-#endif
-#endif
+ * Each dimension is transformed where it lies, starting with the last: the
+ * rows are transformed straight from in to out, and every other dimension is
+ * then transformed in out by gathering a few neighbouring lines at a time into
+ * p->buf (see ffts_transform_lines), so no transposes or full-volume buffers
+ * are needed. p->Ms[i] is the element stride of dimension i.
+ */
+static size_t ffts_nd_units(ffts_plan_t *p, int i) {
+	size_t L = p->Ns[i], S = p->Ms[i];
+	return (p->N / (L * S)) * ((S + FFTS_LINES_COLS - 1) / FFTS_LINES_COLS);
+}
 
+static size_t ffts_nd_scratch(ffts_plan_t *p) {
+	size_t maxL = 0;
+	int i;
+	for(i=0;i<p->rank;i++) {
+		if(p->Ns[i] > maxL) maxL = p->Ns[i];
+	}
+	// rounded to a cache line, so every thread's slice stays aligned
+	return (FFTS_LINES_SCRATCH(maxL) + 7) & ~(size_t)7;
 }
 
 void ffts_execute_nd(ffts_plan_t *p, const void *  in, void *  out) {
 
-	uint64_t *din = (uint64_t *)in;
-	uint64_t *buf = p->buf;
+	const uint64_t *src = (const uint64_t *)in;
 	uint64_t *dout = (uint64_t *)out;
 
-	size_t i,j;
-	for(i=0;i<p->Ns[0];i++) {
-		p->plans[0]->transform(p->plans[0], din + (i * p->Ms[0]), buf + (i * p->Ms[0]));	
-	}
-	ffts_transpose(buf, dout, p->Ms[0], p->Ns[0], p->transpose_buf);	
-
-	for(i=1;i<p->rank;i++) {
-		for(j=0;j<p->Ns[i];j++) { 
-			p->plans[i]->transform(p->plans[i], dout + (j * p->Ms[i]), buf + (j * p->Ms[i]));	
-		}
-		ffts_transpose(buf, dout, p->Ms[i], p->Ns[i], p->transpose_buf);	
+	int i;
+	for(i=p->rank-1;i>=0;i--) {
+		ffts_transform_lines(p->plans[i], src, dout, p->Ns[i], p->Ms[i],
+		                     0, ffts_nd_units(p, i), p->buf, NULL, 0);
+		src = dout;
 	}
 }
 
 ffts_plan_t *ffts_init_nd(int rank, size_t *Ns, int sign) {
 	size_t vol = 1;
 
-	ffts_plan_t *p = malloc(sizeof(ffts_plan_t));
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
 
 	p->transform = &ffts_execute_nd;
 	p->destroy = &ffts_free_nd;
 
 	p->rank = rank;
+	p->sign = sign;
 	p->Ns = malloc(sizeof(size_t) * rank);
 	p->Ms = malloc(sizeof(size_t) * rank);
 	p->plans = malloc(sizeof(ffts_plan_t **) * rank);
+	p->buf = NULL;
+	p->transpose_buf = NULL;
 	int i;
-	for(i=0;i<rank;i++) {
+	for(i=rank-1;i>=0;i--) {
 		p->Ns[i] = Ns[i];
+		p->Ms[i] = vol;
 		vol *= Ns[i];	
 	}
-	p->buf = valloc(sizeof(float) * 2 * vol);
+	p->N = vol;
+	p->io_bytes = sizeof(float) * 4*vol;
 
 	for(i=0;i<rank;i++) {
-		p->Ms[i] = vol / p->Ns[i];
-
 		p->plans[i] = NULL;
 		int k;
 		for(k=0;k<i;k++) {
-			if(p->Ms[k] == p->Ms[i]) 
+			if(p->Ns[k] == p->Ns[i]) 
 				p->plans[i] = p->plans[k];
 		}
 
-		if(!p->plans[i]) p->plans[i] = ffts_init_1d(p->Ms[i], sign); 
+		if(!p->plans[i]) p->plans[i] = ffts_init_1d(p->Ns[i], sign); 
+		if(!p->plans[i]) {
+			p->rank = i;
+			ffts_free_nd(p);
+			return NULL;
+		}
+	}
+
+	p->isa = p->plans[0]->isa;
+	for(i=1;i<rank;i++) {
+		if(p->plans[i]->isa > p->isa) p->isa = p->plans[i]->isa;
 	}
 
-	p->transpose_buf = valloc(sizeof(float) * 2 * 8 * 8);
+	p->buf_size = sizeof(uint64_t) * ffts_nd_scratch(p);
+	p->transpose_buf_size = 0;
+	p->nplans = rank;
+	p->buf = valloc(p->buf_size);
 	return p;
 }
 
@@ -280,4 +157,186 @@ ffts_plan_t *ffts_init_2d(size_t N1, size_t N2, int sign) {
 	Ns[1] = N2;
 	return ffts_init_nd(2, Ns, sign);
 }
+
+#ifdef HAVE_LIBPTHREAD
+/*
+ * Worker pool for threaded N-D plans. Each stage of ffts_execute_nd (the
+ * transforms along one dimension) is split into n contiguous bands of work
+ * units; the calling thread works on band 0 while the workers take the rest.
+ * The 1D sub-plans are only read during execution, so they are shared; each
+ * participant has its own slice of p->buf.
+ */
+typedef struct _ffts_nd_pool_t ffts_nd_pool_t;
+
+typedef struct {
+	ffts_nd_pool_t *pool;
+	size_t id;
+} ffts_nd_worker_t;
+
+struct _ffts_nd_pool_t {
+	ffts_plan_t *p;
+	size_t n;
+	pthread_t *threads;
+	ffts_nd_worker_t *workers;
+
+	pthread_mutex_t lock;
+	pthread_cond_t start, done;
+	unsigned long gen;
+	size_t pending;
+	int quit;
+
+	/* the stage being executed */
+	int dim;
+	size_t scratch;
+	const uint64_t *src;
+	uint64_t *dst;
+};
+
+static void ffts_nd_stage(ffts_nd_pool_t *pool, size_t id) {
+	ffts_plan_t *p = pool->p;
+	int i = pool->dim;
+	size_t units = ffts_nd_units(p, i);
+	size_t u0 = units * id / pool->n;
+	size_t u1 = units * (id + 1) / pool->n;
+	uint64_t *buf = (uint64_t *)p->buf + id * pool->scratch;
+
+	if(u1 > u0) {
+		ffts_transform_lines(p->plans[i], pool->src, pool->dst, p->Ns[i], p->Ms[i],
+		                     u0, u1, buf, NULL, 0);
+	}
+}
+
+static void *ffts_nd_worker(void *arg) {
+	ffts_nd_worker_t *w = (ffts_nd_worker_t *)arg;
+	ffts_nd_pool_t *pool = w->pool;
+	unsigned long gen = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	for(;;) {
+		while(pool->gen == gen && !pool->quit) pthread_cond_wait(&pool->start, &pool->lock);
+		if(pool->quit) break;
+		gen = pool->gen;
+		pthread_mutex_unlock(&pool->lock);
+
+		ffts_nd_stage(pool, w->id);
+
+		pthread_mutex_lock(&pool->lock);
+		if(!--pool->pending) pthread_cond_signal(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+static void ffts_nd_run(ffts_nd_pool_t *pool, int dim, const uint64_t *src, uint64_t *dst) {
+	pthread_mutex_lock(&pool->lock);
+	pool->dim = dim;
+	pool->src = src;
+	pool->dst = dst;
+	pool->pending = pool->n - 1;
+	pool->gen++;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+
+	ffts_nd_stage(pool, 0);
+
+	pthread_mutex_lock(&pool->lock);
+	while(pool->pending) pthread_cond_wait(&pool->done, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void ffts_execute_nd_threaded(ffts_plan_t *p, const void *in, void *out) {
+	ffts_nd_pool_t *pool = (ffts_nd_pool_t *)p->pool;
+	uint64_t *dout = (uint64_t *)out;
+
+	// A copy made by ffts_execute_scratch doesn't own the workers
+	if(p != pool->p) {
+		ffts_execute_nd(p, in, out);
+		return;
+	}
+
+	const uint64_t *src = (const uint64_t *)in;
+	int i;
+	for(i=p->rank-1;i>=0;i--) {
+		ffts_nd_run(pool, i, src, dout);
+		src = dout;
+	}
+}
+
+void ffts_free_nd_threaded(ffts_plan_t *p) {
+	ffts_nd_pool_t *pool = (ffts_nd_pool_t *)p->pool;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = 1;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+
+	size_t i;
+	for(i=1;i<pool->n;i++) pthread_join(pool->threads[i], NULL);
+
+	pthread_cond_destroy(&pool->start);
+	pthread_cond_destroy(&pool->done);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->threads);
+	free(pool->workers);
+	free(pool);
+
+	ffts_free_nd(p);
+}
+#endif
+
+ffts_plan_t *ffts_init_nd_threaded(int rank, size_t *Ns, int sign, int nthreads) {
+	ffts_plan_t *p = ffts_init_nd(rank, Ns, sign);
+	if(!p) return NULL;
+
+#ifdef HAVE_LIBPTHREAD
+	if(nthreads <= 0) nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if(nthreads <= 1) return p;
+
+	ffts_nd_pool_t *pool = calloc(1, sizeof(ffts_nd_pool_t));
+	size_t scratch = ffts_nd_scratch(p);
+	void *bufs = valloc(sizeof(uint64_t) * scratch * nthreads);
+	pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+	ffts_nd_worker_t *workers = malloc(sizeof(ffts_nd_worker_t) * nthreads);
+	if(!pool || !bufs || !threads || !workers) {
+		free(pool);
+		free(bufs);
+		free(threads);
+		free(workers);
+		return p;
+	}
+
+	pool->p = p;
+	pool->threads = threads;
+	pool->workers = workers;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done, NULL);
+
+	free(p->buf);
+	p->buf = bufs;
+	pool->scratch = scratch;
+	p->pool = pool;
+	p->transform = &ffts_execute_nd_threaded;
+	p->destroy = &ffts_free_nd_threaded;
+
+	// The caller is participant 0; if a thread can't be started, carry on
+	// with the ones that were.
+	size_t i;
+	for(i=1;i<(size_t)nthreads;i++) {
+		pool->workers[i].pool = pool;
+		pool->workers[i].id = i;
+		if(pthread_create(&pool->threads[i], NULL, ffts_nd_worker, &pool->workers[i])) break;
+	}
+	pool->n = i;
+#endif
+
+	return p;
+}
+
+ffts_plan_t *ffts_init_2d_threaded(size_t N1, size_t N2, int sign, int nthreads) {
+	size_t Ns[2];
+	Ns[0] = N1;
+	Ns[1] = N2;
+	return ffts_init_nd_threaded(2, Ns, sign, nthreads);
+}
 // vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -0,0 +1,356 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_pruned.h"
+#include "ffts_inplace.h"
+#include "ffts_real.h"
+#include "ffts_twiddle.h"
+#include "macros.h"
+
+#include <string.h>
+
+/*
+ * Pruned power-of-two transforms, for input that is zero past the first nin
+ * elements, or when only the first nout outputs are wanted. N = P * L with P
+ * the smallest power of two covering the pruned side, so that only size P
+ * transforms are run, a group of FFTS_LINES_COLS at a time:
+ *
+ *  input pruned:  X[L*k2 + k1] = DFT_P(x[n] * W_N^(n*k1))[k2] over n < nin,
+ *                 so the zeros are never transformed, and the L results are
+ *                 written out a row at a time.
+ *  output pruned: the transpose of the above. The decimated sequences
+ *                 x[L*n2 + n1] are gathered a row at a time and transformed,
+ *                 and X[k] = sum_n1 W_N^(n1*k) * DFT_P(x[L*n2 + n1])[k] is
+ *                 accumulated for k < nout only.
+ *
+ * Both twiddle passes cost a few butterfly passes, so when neither is
+ * expected to beat the full transform the zeros are copied in and the
+ * unwanted outputs dropped instead. Either way only the first nin inputs are
+ * read and the first nout outputs written.
+ *
+ * p->Ns holds P, L, the number of input floats (odd for the half size plan
+ * of a real transform, whose last input pair has no imaginary part) and
+ * nout, and R. p->ws holds W_N^(j*l), for l < L and j < nin or nout, as the
+ * product of W_N^((j % R)*l) and W_N^((j - j % R)*l), in the layout IMUL
+ * takes; R is about the square root of nin or nout, which keeps the table
+ * small.
+ */
+
+#define COLS FFTS_LINES_COLS
+
+// gathered transforms are padded by a cache line, as in ffts_transform_lines
+#define PAD 8
+
+#define MAX_R 32
+
+static void ffts_pruned_set_tw(float *h, size_t j, const ffts_twiddle_t *t, int sign, size_t e, size_t N) {
+	float *q = h + 8*(j/2) + 2*(j&1);
+	double re, im;
+	ffts_twiddle_cs(t, N, e, &re, &im);
+	im *= sign;
+	q[0] = q[1] = re;
+	q[4] = im;
+	q[5] = -im;
+}
+
+// twiddle rows for l < L: R factors W_N^(r*l), then n / R factors
+// W_N^(R*m*l), each in both halves of a pair
+static float *ffts_pruned_tw(size_t N, size_t L, size_t n, size_t R, int sign) {
+	size_t nm = (n + R - 1) / R, l, i;
+	float *wa = FFTS_MALLOC(sizeof(float) * (4*R + 8*nm) * L, 32);
+	float *wb = wa + 4*R*L;
+	const ffts_twiddle_t *t = ffts_twiddle_table(N);
+
+	if(!wa) return NULL;
+	for(l=0;l<L;l++) {
+		for(i=0;i<R;i++) ffts_pruned_set_tw(wa + 4*R*l, i, t, sign, (i * l) % N, N);
+		for(i=0;i<nm;i++) {
+			ffts_pruned_set_tw(wb + 8*nm*l, 2*i, t, sign, (R * i * l) % N, N);
+			ffts_pruned_set_tw(wb + 8*nm*l, 2*i + 1, t, sign, (R * i * l) % N, N);
+		}
+	}
+	return wa;
+}
+
+static void ffts_pruned_tw_at(const float *wa, const float *wb, size_t R, size_t j,
+                              float *wr, float *wi) {
+	const float *qa = wa + 8*((j % R)/2) + 2*(j&1);
+	const float *qb = wb + 8*(j / R);
+	*wr = qa[0]*qb[0] - qa[4]*qb[4];
+	*wi = qa[0]*qb[4] + qa[4]*qb[0];
+}
+
+void ffts_free_1d_pruned(ffts_plan_t *p) {
+	if(p->plans) {
+		if(p->plans[0]) ffts_free(p->plans[0]);
+		free(p->plans);
+	}
+	free(p->Ns);
+	if(p->ws) FFTS_FREE(p->ws);
+	if(p->buf) FFTS_FREE(p->buf);
+	free(p);
+}
+
+void ffts_execute_1d_pruned_full(ffts_plan_t *p, const void *in, void *out) {
+	ffts_plan_t *t = p->plans[0];
+	size_t N = p->N, nfin = p->Ns[2], nout = p->Ns[3];
+	float *buf = (float *)p->buf;
+
+	if(nfin < 2*N) {
+		memcpy(buf, in, sizeof(float) * nfin);
+		if(p->buf != p->pruned_buf) memset(buf + nfin, 0, sizeof(float) * (2*N - nfin));
+		in = buf;
+	}
+	if(nout < N) {
+		t->transform(t, in, buf + 2*N);
+		memcpy(out, buf + 2*N, sizeof(float) * 2 * nout);
+	}else{
+		t->transform(t, in, out);
+	}
+}
+
+void ffts_execute_1d_pruned_in(ffts_plan_t *p, const void *vin, void *vout) {
+	const float *in = (const float *)vin;
+	uint64_t *out = (uint64_t *)vout;
+	ffts_plan_t *t = p->plans[0];
+	size_t P = p->Ns[0], L = p->Ns[1], nfin = p->Ns[2], nout = p->Ns[3], R = p->Ns[4];
+	size_t nc = nfin / 2, nin = (nfin + 1) / 2, nm = (nin + R - 1) / R;
+	size_t Ps = P + PAD;
+	float *x = (float *)p->buf;
+	uint64_t *y = (uint64_t *)(x + 2*Ps);
+	size_t k1, k2, b, i, m;
+
+	// x[nin..P) stays zero for every column
+	if(p->buf != p->pruned_buf) memset(x + 2*nin, 0, sizeof(float) * 2 * (P - nin));
+
+	for(k1=0;k1<L;k1+=COLS) {
+		size_t nb = (k1 + COLS < L) ? COLS : L - k1;
+
+		for(b=0;b<nb;b++) {
+			const float *wa = (const float *)p->ws + 4*R*(k1 + b);
+			const float *wb = (const float *)p->ws + 4*R*L + 8*nm*(k1 + b);
+
+			for(i=0,m=0;i+1<nc;m++) {
+				V wre = VLD(wb + 8*m), wim = VLD(wb + 8*m + 4);
+				const float *w = wa - 4*R*m;
+				for(;i<R*(m+1) && i+1<nc;i+=2) {
+					V a = IMUL(VLDU(in + 2*i), VLD(w + 4*i), VLD(w + 4*i + 4));
+					VST(x + 2*i, IMUL(a, wre, wim));
+				}
+			}
+			for(;i<nin;i++) {
+				float re = in[2*i], im = (i < nc) ? in[2*i+1] : 0.0f, wr, wi;
+				ffts_pruned_tw_at(wa, wb, R, i, &wr, &wi);
+				x[2*i]   = re*wr - im*wi;
+				x[2*i+1] = re*wi + im*wr;
+			}
+			t->transform(t, x, y + b*Ps);
+		}
+
+		for(k2=0;k2*L+k1<nout;k2++) {
+			uint64_t *o = out + k2*L + k1;
+			size_t n = nout - (k2*L + k1);
+			if(n > nb) n = nb;
+			for(b=0;b<n;b++) o[b] = y[b*Ps + k2];
+		}
+	}
+}
+
+void ffts_execute_1d_pruned_out(ffts_plan_t *p, const void *vin, void *vout) {
+	const uint64_t *in = (const uint64_t *)vin;
+	ffts_plan_t *t = p->plans[0];
+	size_t P = p->Ns[0], L = p->Ns[1], nfin = p->Ns[2], nout = p->Ns[3], R = p->Ns[4];
+	size_t nc = nfin / 2, nin = (nfin + 1) / 2, nm = (nout + R - 1) / R;
+	size_t Ps = P + PAD;
+	uint64_t *x = (uint64_t *)p->buf;
+	float *y = (float *)(x + COLS*Ps);
+	float *acc = y + 2*Ps;
+	size_t n1, n2, b, k, m;
+
+	memset(acc, 0, sizeof(float) * 2 * nout);
+
+	for(n1=0;n1<L;n1+=COLS) {
+		size_t nb = (n1 + COLS < L) ? COLS : L - n1;
+
+		for(n2=0;n2<P;n2++) {
+			size_t j = L*n2 + n1;
+			if(j + nb <= nc) {
+				for(b=0;b<nb;b++) x[b*Ps + n2] = in[j + b];
+			}else{
+				// past the end of the input, which is zero
+				for(b=0;b<nb;b++) {
+					float *e = (float *)(x + b*Ps + n2);
+					e[0] = (j + b < nin) ? ((const float *)in)[2*(j+b)] : 0.0f;
+					e[1] = (j + b < nc) ? ((const float *)in)[2*(j+b) + 1] : 0.0f;
+				}
+			}
+		}
+
+		for(b=0;b<nb;b++) {
+			const float *wa = (const float *)p->ws + 4*R*(n1 + b);
+			const float *wb = (const float *)p->ws + 4*R*L + 8*nm*(n1 + b);
+
+			t->transform(t, x + b*Ps, y);
+
+			for(k=0,m=0;k+1<nout;m++) {
+				V wre = VLD(wb + 8*m), wim = VLD(wb + 8*m + 4);
+				const float *w = wa - 4*R*m;
+				for(;k<R*(m+1) && k+1<nout;k+=2) {
+					V a = IMUL(VLD(y + 2*k), VLD(w + 4*k), VLD(w + 4*k + 4));
+					VST(acc + 2*k, VADD(VLD(acc + 2*k), IMUL(a, wre, wim)));
+				}
+			}
+			for(;k<nout;k++) {
+				float wr, wi;
+				ffts_pruned_tw_at(wa, wb, R, k, &wr, &wi);
+				acc[2*k]   += y[2*k]*wr - y[2*k+1]*wi;
+				acc[2*k+1] += y[2*k]*wi + y[2*k+1]*wr;
+			}
+		}
+	}
+
+	memcpy(vout, acc, sizeof(float) * 2 * nout);
+}
+
+static size_t ffts_pruned_side(size_t N, size_t n) {
+	size_t P = 8;
+	while(P < n) P <<= 1;
+	return (P < N) ? P : N;
+}
+
+static size_t ffts_log2(size_t n) {
+	size_t l = 0;
+	while(((size_t)1 << l) < n) l++;
+	return l;
+}
+
+static ffts_plan_t *ffts_init_1d_pruned_floats(size_t N, int sign, size_t nfin, size_t nout) {
+	size_t Pin, Pout, P, L, R, n, full, cin, cout;
+	int mode;
+
+	if(N < 8 || (N & (N - 1)) != 0) {
+		LOG("Pruned FFT size must be a power of two of at least 8\n");
+		return NULL;
+	}
+	if(!nfin || nfin > 2*N) nfin = 2*N;
+	if(!nout || nout > N) nout = N;
+	if(nfin == 2*N && nout == N) return ffts_init_1d(N, sign);
+
+	// in passes over the data: the twiddle and transpose passes cost about
+	// eight butterfly passes while the data fits in cache and four when it
+	// doesn't, and transforms smaller than 256 cost about as much as one of
+	// 256. When pruning doesn't pay, the full transform with copies.
+	Pin = ffts_pruned_side(N, (nfin + 1) / 2);
+	Pout = ffts_pruned_side(N, nout);
+	full = ffts_log2(N);
+	cin = ((Pin < 256) ? 8 : ffts_log2(Pin)) + ((N > 65536) ? 4 : 8);
+	cout = ((Pout < 256) ? 8 : ffts_log2(Pout)) + ((N > 65536) ? 4 : 8);
+	if(Pin < N && cin < full && cin <= cout) mode = FFTS_PRUNED_IN;
+	else if(Pout < N && cout < full) mode = FFTS_PRUNED_OUT;
+	else mode = FFTS_PRUNED_FULL;
+
+	P = (mode == FFTS_PRUNED_IN) ? Pin : (mode == FFTS_PRUNED_OUT) ? Pout : N;
+	L = N / P;
+	n = (mode == FFTS_PRUNED_IN) ? (nfin + 1) / 2 : nout;
+	for(R=2;R<MAX_R && R*R<n;R<<=1);
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->transform = (mode == FFTS_PRUNED_IN)  ? &ffts_execute_1d_pruned_in :
+	               (mode == FFTS_PRUNED_OUT) ? &ffts_execute_1d_pruned_out :
+	                                           &ffts_execute_1d_pruned_full;
+	p->destroy = &ffts_free_1d_pruned;
+	p->N = N;
+	p->io_bytes = sizeof(float) * (nfin + 2*nout);
+	p->rank = 1;
+	p->sign = sign;
+	p->ws = NULL;
+	p->buf = NULL;
+	p->Ns = malloc(sizeof(size_t) * 5);
+	p->plans = malloc(sizeof(ffts_plan_t **) * 1);
+	if(!p->Ns || !p->plans) {
+		free(p->plans);
+		p->plans = NULL;
+		ffts_free_1d_pruned(p);
+		return NULL;
+	}
+	p->Ns[0] = P;
+	p->Ns[1] = L;
+	p->Ns[2] = nfin;
+	p->Ns[3] = nout;
+	p->Ns[4] = R;
+
+	p->plans[0] = ffts_init_1d(P, sign);
+	if(!p->plans[0]) {
+		ffts_free_1d_pruned(p);
+		return NULL;
+	}
+	p->isa = p->plans[0]->isa;
+
+	if(mode != FFTS_PRUNED_FULL) p->ws = ffts_pruned_tw(N, L, n, R, sign);
+	p->buf_size = (mode == FFTS_PRUNED_IN) ? sizeof(float) * 2 * (COLS + 1) * (P + PAD) :
+	              (mode == FFTS_PRUNED_OUT) ? sizeof(float) * 2 * ((COLS + 1) * (P + PAD) + nout) :
+	                            sizeof(float) * 4 * N;
+	p->transpose_buf_size = 0;
+	p->nplans = 1;
+	p->buf = FFTS_MALLOC(p->buf_size, 32);
+	if(p->buf && mode != FFTS_PRUNED_OUT) memset(p->buf, 0, p->buf_size);
+
+	p->transpose_buf = NULL;
+	p->pruned = mode;
+	p->pruned_buf = p->buf;
+	if((mode != FFTS_PRUNED_FULL && !p->ws) || !p->buf) {
+		ffts_free_1d_pruned(p);
+		return NULL;
+	}
+
+	return p;
+}
+
+ffts_plan_t *ffts_init_1d_pruned(size_t N, int sign, size_t nin, size_t nout) {
+	return ffts_init_1d_pruned_floats(N, sign, (nin > N) ? 2*N : 2*nin, nout);
+}
+
+ffts_plan_t *ffts_init_1d_real_pruned(size_t N, size_t nin) {
+	if(N < 16 || (N & (N - 1)) != 0) {
+		LOG("Pruned real FFT size must be a power of two of at least 16\n");
+		return NULL;
+	}
+	if(!nin || nin > N) nin = N;
+
+	// pairs of real samples are the complex inputs of the half size plan
+	return ffts_init_1d_real_half(N, -1, ffts_init_1d_pruned_floats(N/2, -1, nin, 0));
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
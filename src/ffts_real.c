@@ -32,6 +32,79 @@
 */
 
 #include "ffts_real.h"
+#include "macros.h"
+#include "ffts_cpu.h"
+#include "ffts_twiddle.h"
+
+/*
+ * The recombination passes compute, for k < N/2,
+ *
+ *   forward: out[k] = buf[k]*A[k] + conj(buf[N/2-k])*B[k]
+ *   inverse: buf[k] = in[k]*conj(A[k]) + conj(in[N/2-k]*B[k])
+ *
+ * Each vector holds consecutive complex values, so the mirrored operand is
+ * loaded unaligned and has its complex values reversed.
+ */
+#if defined(HAVE_SSE) || defined(__aarch64__)
+#define CONJ (VLIT4(-0.0f, 0.0f, -0.0f, 0.0f))
+#define NEGRE (VLIT4(0.0f, -0.0f, 0.0f, -0.0f))
+
+/* x * w for two complex values */
+__INLINE V CMUL(V x, V w) {
+	return VADD(VMUL(x, VDUPRE(w)), VXOR(VMUL(VSWAPPAIRS(x), VDUPIM(w)), NEGRE));
+}
+#endif
+
+#if defined(__x86_64__) && defined(HAVE_SSE) && !defined(DYNAMIC_DISABLED) && defined(__GNUC__)
+#define FFTS_REAL_AVX
+#include <immintrin.h>
+
+/* four complex values per iteration; returns the number of outputs written */
+
+__attribute__((target("avx")))
+static __m256 ffts_real_cmul_avx(__m256 x, __m256 w) {
+	return _mm256_addsub_ps(_mm256_mul_ps(x, _mm256_moveldup_ps(w)),
+	                        _mm256_mul_ps(_mm256_permute_ps(x, 0xB1), _mm256_movehdup_ps(w)));
+}
+
+__attribute__((target("avx")))
+static __m256 ffts_real_rev_avx(__m256 y) {
+	y = _mm256_permute2f128_ps(y, y, 1);
+	return _mm256_permute_ps(y, _MM_SHUFFLE(1,0,3,2));
+}
+
+__attribute__((target("avx")))
+static size_t ffts_real_fwd_avx(float *out, const float *buf, const float *A, const float *B, size_t N) {
+	const __m256 conj = _mm256_set_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f);
+	size_t i;
+	for(i=0;i+4<=N/2;i+=4) {
+		__m256 x = _mm256_loadu_ps(buf + 2*i);
+		__m256 y = ffts_real_rev_avx(_mm256_loadu_ps(buf + N - 2*i - 6));
+		__m256 a = _mm256_loadu_ps(A + 2*i);
+		__m256 b = _mm256_loadu_ps(B + 2*i);
+		_mm256_storeu_ps(out + 2*i, _mm256_add_ps(ffts_real_cmul_avx(x, a),
+		                                          ffts_real_cmul_avx(_mm256_xor_ps(y, conj), b)));
+	}
+	_mm256_zeroupper();
+	return i;
+}
+
+__attribute__((target("avx")))
+static size_t ffts_real_inv_avx(float *buf, const float *in, const float *A, const float *B, size_t N) {
+	const __m256 conj = _mm256_set_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f);
+	size_t i;
+	for(i=0;i+4<=N/2;i+=4) {
+		__m256 x = _mm256_loadu_ps(in + 2*i);
+		__m256 y = ffts_real_rev_avx(_mm256_loadu_ps(in + N - 2*i - 6));
+		__m256 a = _mm256_loadu_ps(A + 2*i);
+		__m256 b = _mm256_loadu_ps(B + 2*i);
+		_mm256_storeu_ps(buf + 2*i, _mm256_add_ps(ffts_real_cmul_avx(x, _mm256_xor_ps(a, conj)),
+		                                          _mm256_xor_ps(ffts_real_cmul_avx(y, b), conj)));
+	}
+	_mm256_zeroupper();
+	return i;
+}
+#endif
 
 void ffts_free_1d_real(ffts_plan_t *p) {
 	ffts_free(p->plans[0]);
@@ -100,16 +173,29 @@ void ffts_execute_1d_real(ffts_plan_t *p, const void *vin, void *vout) {
 												:
 												: "memory", "q8", "q9", "q10", "q11", "q12", "q13", "q14", "q15"
 												);
+	}
 #else
-	for(i=0;i<N/2;i++) {
+	i = 0;
+#if defined(FFTS_REAL_AVX)
+	if(p->plans[0]->isa == FFTS_ISA_AVX2) i = ffts_real_fwd_avx(out, buf, A, B, N);
+#endif
+#if defined(HAVE_SSE) || defined(__aarch64__)
+	for(;i+2<=N/2;i+=2) {
+		V x = VLDU(buf + 2*i);
+		V y = VREVPAIRS(VLDU(buf + N - 2*i - 2));
+		V a = VLD(A + 2*i);
+		V b = VLD(B + 2*i);
+		VSTU(out + 2*i, VADD(CMUL(x, a), CMUL(VXOR(y, CONJ), b)));
+	}
+#endif
+	for(;i<N/2;i++) {
 		out[2*i]   = buf[2*i]*A[2*i] - buf[2*i+1]*A[2*i+1] + buf[N-2*i]*B[2*i] + buf[N-2*i+1]*B[2*i+1];
 		out[2*i+1] = buf[2*i+1]*A[2*i] + buf[2*i]*A[2*i+1] + buf[N-2*i]*B[2*i+1] - buf[N-2*i+1]*B[2*i];
 
 //	out[2*N-2*i] = out[2*i];
 //	out[2*N-2*i+1] = -out[2*i+1];
-
-#endif	
 	}
+#endif
 	
 	out[N] = buf[0] - buf[1];
 	out[N+1] = 0.0f;
@@ -173,52 +259,74 @@ void ffts_execute_1d_real_inv(ffts_plan_t *p, const void *vin, void *vout) {
 												);
 
 
+	}
 #else
-	for(i=0;i<N/2;i++) {
+	i = 0;
+#if defined(FFTS_REAL_AVX)
+	if(p->plans[0]->isa == FFTS_ISA_AVX2) i = ffts_real_inv_avx(buf, in, A, B, N);
+#endif
+#if defined(HAVE_SSE) || defined(__aarch64__)
+	for(;i+2<=N/2;i+=2) {
+		V x = VLDU(in + 2*i);
+		V y = VREVPAIRS(VLDU(in + N - 2*i - 2));
+		V a = VLD(A + 2*i);
+		V b = VLD(B + 2*i);
+		VST(buf + 2*i, VADD(CMUL(x, VXOR(a, CONJ)), VXOR(CMUL(y, b), CONJ)));
+	}
+#endif
+	for(;i<N/2;i++) {
 		buf[2*i]   = in[2*i]*A[2*i] + in[2*i+1]*A[2*i+1] + in[N-2*i]*B[2*i] - in[N-2*i+1]*B[2*i+1];
 		buf[2*i+1] = in[2*i+1]*A[2*i] - in[2*i]*A[2*i+1] - in[N-2*i]*B[2*i+1] - in[N-2*i+1]*B[2*i];
+	}
 #endif
-}
 	
 	p->plans[0]->transform(p->plans[0], buf, out);
 	
 }
 
 ffts_plan_t *ffts_init_1d_real(size_t N, int sign) {
-	ffts_plan_t *p = malloc(sizeof(ffts_plan_t));
+	return ffts_init_1d_real_half(N, sign, ffts_init_1d(N/2, sign));
+}
+
+/* a real plan of size N that does its complex transforms with half, a size
+ * N/2 plan of the same sign that it takes ownership of */
+ffts_plan_t *ffts_init_1d_real_half(size_t N, int sign, ffts_plan_t *half) {
+	if(!half) return NULL;
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
 
 	if(sign < 0) p->transform = &ffts_execute_1d_real;
 	else         p->transform = &ffts_execute_1d_real_inv;
 	
 	p->destroy = &ffts_free_1d_real;
 	p->N = N;
+	p->io_bytes = sizeof(float) * (2*N + 2);
 	p->rank = 1;
 	p->plans = malloc(sizeof(ffts_plan_t **) * 1);
 
-	p->plans[0] = ffts_init_1d(N/2, sign); 
+	p->plans[0] = half;
+	p->isa = p->plans[0]->isa;
 
-	p->buf = valloc(sizeof(float) * 2 * ((N/2) + 1));
+	p->buf_size = sizeof(float) * 2 * ((N/2) + 1);
+	p->transpose_buf_size = 0;
+	p->nplans = 1;
+	p->buf = valloc(p->buf_size);
 
 	p->A = valloc(sizeof(float) * N);
 	p->B = valloc(sizeof(float) * N);
 
-  if(sign < 0) {
-		int i;
-		for (i = 0; i < N/2; i++) {
-			p->A[2 * i]     = 0.5 * (1.0 - sin (2.0f * PI / (double) (N) * (double) i));
-			p->A[2 * i + 1] = 0.5 * (-1.0 * cos (2.0f * PI / (double) (N) * (double) i));
-			p->B[2 * i]     = 0.5 * (1.0 + sin (2.0f * PI / (double) (N) * (double) i));
-			p->B[2 * i + 1] = 0.5 * (1.0 * cos (2.0f * PI / (double) (N) * (double) i));
-		}
-	}else{
-		int i;
-		for (i = 0; i < N/2; i++) {
-			p->A[2 * i]     = 1.0 * (1.0 - sin (2.0f * PI / (double) (N) * (double) i));
-			p->A[2 * i + 1] = 1.0 * (-1.0 * cos (2.0f * PI / (double) (N) * (double) i));
-			p->B[2 * i]     = 1.0 * (1.0 + sin (2.0f * PI / (double) (N) * (double) i));
-			p->B[2 * i + 1] = 1.0 * (1.0 * cos (2.0f * PI / (double) (N) * (double) i));
-		}
-  }
+	// the A and B coefficients from the master table (see ffts_twiddle.h)
+	const ffts_twiddle_t *tw = ffts_twiddle_table(N);
+	double scale = (sign < 0) ? 0.5 : 1.0;
+	size_t i;
+	for(i=0;i<N/2;i++) {
+		double c, s;
+		ffts_twiddle_cs(tw, N, i, &c, &s);
+		p->A[2 * i]     = scale * (1.0 - s);
+		p->A[2 * i + 1] = scale * (-1.0 * c);
+		p->B[2 * i]     = scale * (1.0 + s);
+		p->B[2 * i + 1] = scale * (1.0 * c);
+	}
 	
 	return p;
 }
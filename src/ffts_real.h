@@ -40,7 +40,7 @@
 
 #include "ffts.h"
 
-#ifdef HAVE_NEON 
+#if defined(HAVE_NEON) || defined(__aarch64__)
 	#include <arm_neon.h>
 #endif
 #ifdef HAVE_SSE
@@ -48,6 +48,7 @@
 #endif
 
 ffts_plan_t *ffts_init_1d_real(size_t N, int sign);
+ffts_plan_t *ffts_init_1d_real_half(size_t N, int sign, ffts_plan_t *half);
 
 #endif
 
@@ -32,11 +32,20 @@
 */
 
 #include "ffts_real_nd.h"
+#include "ffts_inplace.h"
 
 #ifdef __ARM_NEON__
 #include "neon.h"
 #endif
 
+/*
+ * Real N-D transforms. The last dimension is done with real transforms on
+ * the contiguous rows, giving Ns[rank-1]/2+1 complex values per row, and the
+ * other dimensions with complex transforms straight down the columns of
+ * that (see ffts_transform_lines), so there are no transposes. p->Ms[i] is
+ * the complex element stride of dimension i, and p->Ms[rank-1] the row width.
+ */
+
 void ffts_free_nd_real(ffts_plan_t *p) {
 
 	int i;
@@ -60,73 +69,58 @@ void ffts_free_nd_real(ffts_plan_t *p) {
 	free(p);
 }
 
-void ffts_scalar_transpose(uint64_t *in, uint64_t *out, int w, int h, uint64_t *buf) {
-
-	size_t i,j;
-	for(i=0;i<w;i+=1) {
-		for(j=0;j<h;j+=1) {
-			out[i*h + j] = in[j*w + i];
-		}
-	}
-
+static size_t ffts_nd_real_units(ffts_plan_t *p, int i) {
+	size_t L = p->Ns[i], S = p->Ms[i];
+	size_t vol = (p->N / p->Ns[p->rank-1]) * p->Ms[p->rank-1];
+	return (vol / (L * S)) * ((S + FFTS_LINES_COLS - 1) / FFTS_LINES_COLS);
 }
 
 void ffts_execute_nd_real(ffts_plan_t *p, const void *  in, void *  out) {
 
-	uint32_t *din = (uint32_t *)in;
-	uint64_t *buf = p->buf;
+	const float *din = (const float *)in;
 	uint64_t *dout = (uint64_t *)out;
+	ffts_plan_t *rows = p->plans[p->rank-1];
+	size_t n = p->Ns[p->rank-1], w = p->Ms[p->rank-1];
 
-	size_t i,j;
-	for(i=0;i<p->Ns[0];i++) {
-		p->plans[0]->transform(p->plans[0], din + (i * p->Ms[0]), buf + (i * (p->Ms[0] / 2 + 1)));	
+	size_t i;
+	int k;
+	for(i=0;i<p->N/n;i++) {
+		rows->transform(rows, din + i * n, dout + i * w);
 	}
-	ffts_scalar_transpose(buf, dout, p->Ms[0] / 2 + 1, p->Ns[0], p->transpose_buf);	
 
-	for(i=1;i<p->rank;i++) {
-		for(j=0;j<p->Ns[i];j++) { 
-			p->plans[i]->transform(p->plans[i], dout + (j * p->Ms[i]), buf + (j * p->Ms[i]));	
-		}
-		ffts_scalar_transpose(buf, dout, p->Ms[i], p->Ns[i], p->transpose_buf);	
+	for(k=p->rank-2;k>=0;k--) {
+		ffts_transform_lines(p->plans[k], dout, dout, p->Ns[k], p->Ms[k],
+		                     0, ffts_nd_real_units(p, k), p->transpose_buf, NULL, 0);
 	}
 }
 
 void ffts_execute_nd_real_inv(ffts_plan_t *p, const void *  in, void *  out) {
 
-	uint64_t *din = (uint64_t *)in;
-	uint64_t *buf = p->buf;
-	uint64_t *buf2;
-	uint64_t *dout = (uint64_t *)out;
-	size_t vol = 1;
-	
-	float *bufr = (float *)(p->buf);
+	const uint64_t *src = (const uint64_t *)in;
+	uint64_t *buf = (uint64_t *)p->buf;
 	float *doutr = (float *)out;
-
-	size_t i,j;
-
-	for(i=0;i<p->rank;i++) {
-		vol *= p->Ns[i];
+	ffts_plan_t *rows = p->plans[p->rank-1];
+	size_t n = p->Ns[p->rank-1], w = p->Ms[p->rank-1];
+
+	size_t i;
+	int k;
+	// the input is left alone, so the first pass goes to buf
+	for(k=p->rank-2;k>=0;k--) {
+		ffts_transform_lines(p->plans[k], src, buf, p->Ns[k], p->Ms[k],
+		                     0, ffts_nd_real_units(p, k), p->transpose_buf, NULL, 0);
+		src = buf;
 	}
 
-	buf2 = buf + vol;
-
-	ffts_scalar_transpose(din, buf, p->Ms[0], p->Ns[0], p->transpose_buf);	
-
-	for(i=0;i<p->Ms[0];i++) {
-		p->plans[0]->transform(p->plans[0], buf + (i * p->Ns[0]), buf2 + (i * p->Ns[0]));	
+	for(i=0;i<p->N/n;i++) {
+		rows->transform(rows, src + i * w, doutr + i * n);
 	}
-	
-	ffts_scalar_transpose(buf2, buf, p->Ns[0], p->Ms[0], p->transpose_buf);	
-	for(j=0;j<p->Ms[1];j++) { 
-  	p->plans[1]->transform(p->plans[1], buf + (j * (p->Ms[0])), &doutr[j * p->Ns[1]]);	
-  }
 }
 
 ffts_plan_t *ffts_init_nd_real(int rank, size_t *Ns, int sign) {
-	size_t vol = 1;
-	size_t bufsize;
+	size_t vol = 1, maxL = 0;
 
-	ffts_plan_t *p = malloc(sizeof(ffts_plan_t));
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
 
 	if(sign < 0) p->transform = &ffts_execute_nd_real;
 	else         p->transform = &ffts_execute_nd_real_inv;
@@ -134,56 +128,52 @@ ffts_plan_t *ffts_init_nd_real(int rank, size_t *Ns, int sign) {
 	p->destroy = &ffts_free_nd_real;
 
 	p->rank = rank;
+	p->sign = sign;
 	p->Ns = malloc(sizeof(size_t) * rank);
 	p->Ms = malloc(sizeof(size_t) * rank);
 	p->plans = malloc(sizeof(ffts_plan_t **) * rank);
+	p->buf = NULL;
+	p->transpose_buf = NULL;
 	int i;
-	for(i=0;i<rank;i++) {
+	for(i=rank-1;i>=0;i--) {
 		p->Ns[i] = Ns[i];
-		vol *= Ns[i];	
-	}
-	
-	//There is probably a prettier way of doing this, but it works..
-	if(sign < 0) {
-		bufsize = 2 * vol;
+		p->Ms[i] = (i == rank-1) ? Ns[i] / 2 + 1 : vol;
+		vol *= (i == rank-1) ? p->Ms[i] : Ns[i];
+		if(i < rank-1 && Ns[i] > maxL) maxL = Ns[i];
 	}
-	else {
-		bufsize = 2 * (Ns[0] * ((vol / Ns[0]) / 2 + 1) + vol);
-	}
-
-	p->buf = valloc(sizeof(float) * bufsize);
+	p->N = vol / p->Ms[rank-1] * Ns[rank-1];
+	p->io_bytes = sizeof(float) * (p->N + 2*vol);
 
 	for(i=0;i<rank;i++) {
-		p->Ms[i] = vol / p->Ns[i];
-		
 		p->plans[i] = NULL;
 		int k;
 
-		if(sign < 0) {
-			for(k=1;k<i;k++) {
-				if(p->Ms[k] == p->Ms[i]) p->plans[i] = p->plans[k];
-			}
-			if(!i)                p->plans[i] = ffts_init_1d_real(p->Ms[i], sign); 
-			else if(!p->plans[i]) p->plans[i] = ffts_init_1d(p->Ms[i], sign); 
+		if(i == rank-1) {
+			p->plans[i] = ffts_init_1d_real(p->Ns[i], sign);
 		}else{
-  		for(k=0;k<i;k++) {
-  			if(p->Ns[k] == p->Ns[i]) p->plans[i] = p->plans[k];
-  		}
-			if(i==rank-1)         p->plans[i] = ffts_init_1d_real(p->Ns[i], sign); 
-			else if(!p->plans[i]) p->plans[i] = ffts_init_1d(p->Ns[i], sign); 
-		}
-	}
-	if(sign < 0) {
-		for(i=1;i<rank;i++) {
-			p->Ns[i] = p->Ns[i] / 2 + 1;
+			for(k=0;k<i;k++) {
+				if(p->Ns[k] == p->Ns[i]) p->plans[i] = p->plans[k];
+			}
+			if(!p->plans[i]) p->plans[i] = ffts_init_1d(p->Ns[i], sign);
 		}
-	}else{
-		for(i=0;i<rank-1;i++) {
-			p->Ms[i] = p->Ms[i] / 2 + 1;
+		if(!p->plans[i]) {
+			p->rank = i;
+			ffts_free_nd_real(p);
+			return NULL;
 		}
 	}
 
-	p->transpose_buf = valloc(sizeof(float) * 2 * 8 * 8);
+	p->isa = p->plans[0]->isa;
+	for(i=1;i<rank;i++) {
+		if(p->plans[i]->isa > p->isa) p->isa = p->plans[i]->isa;
+	}
+
+	// the complex spectrum for the inverse, and the column scratch
+	p->buf_size = (sign > 0 && rank > 1) ? sizeof(uint64_t) * vol : 0;
+	p->transpose_buf_size = (rank > 1) ? sizeof(uint64_t) * FFTS_LINES_SCRATCH(maxL) : 0;
+	p->nplans = rank;
+	if(p->buf_size) p->buf = valloc(p->buf_size);
+	if(p->transpose_buf_size) p->transpose_buf = valloc(p->transpose_buf_size);
 	return p;
 }
 
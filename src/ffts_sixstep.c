@@ -0,0 +1,163 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_sixstep.h"
+#include "ffts_twiddle.h"
+#include "ffts_inplace.h"
+
+#include <string.h>
+
+/*
+ * Six-step transforms for large powers of two. N = N1*N2 (N2 = N1 or 2*N1)
+ * is viewed as N1 rows of N2, and done in two passes over memory with
+ * sub-plans of size N1 and N2 that fit in cache:
+ *
+ *  1. columns: groups of neighbouring columns of in are gathered, transformed,
+ *     multiplied by W_N^(n2*k1) and stored to p->buf (ffts_transform_lines);
+ *  2. rows: ROWS rows of p->buf at a time are transformed into scratch and
+ *     written transposed to out, ROWS consecutive elements per output row.
+ *
+ * W_N^e is formed from two tables of N2 and N1 entries at p->ws, so neither
+ * the tables nor the generated code grow with N.
+ */
+
+#define ROWS 8
+
+void ffts_free_1d_sixstep(ffts_plan_t *p) {
+	ffts_free(p->plans[0]);
+	if(p->plans[1] != p->plans[0]) ffts_free(p->plans[1]);
+	free(p->plans);
+	free(p->Ns);
+	free(p->ws);
+	free(p->buf);
+	free(p->transpose_buf);
+	free(p);
+}
+
+void ffts_execute_1d_sixstep(ffts_plan_t *p, const void *vin, void *vout) {
+	const uint64_t *in = (const uint64_t *)vin;
+	uint64_t *out = (uint64_t *)vout;
+	uint64_t *buf = (uint64_t *)p->buf;
+	uint64_t *tmp = (uint64_t *)p->transpose_buf;
+	ffts_plan_t *rows = p->plans[1];
+	size_t N1 = p->Ns[0], N2 = p->Ns[1];
+	size_t r, b, k;
+
+	ffts_transform_lines(p->plans[0], in, buf, N1, N2, 0,
+	                     (N2 + FFTS_LINES_COLS - 1) / FFTS_LINES_COLS,
+	                     tmp, (const double *)p->ws, N2);
+
+	for(r=0;r<N1;r+=ROWS) {
+		for(b=0;b<ROWS;b++) {
+			rows->transform(rows, buf + (r + b) * N2, tmp + b * N2);
+		}
+		for(k=0;k<N2;k++) {
+			uint64_t *o = out + k * N1 + r;
+			for(b=0;b<ROWS;b++) o[b] = tmp[b * N2 + k];
+		}
+	}
+}
+
+ffts_plan_t *ffts_init_1d_sixstep(size_t N, int sign) {
+	if(N < 64 || (N & (N - 1)) != 0) {
+		LOG("Six-step FFT size must be a power of two of at least 64\n");
+		return NULL;
+	}
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	size_t N1 = (size_t)1 << (__builtin_ctzl(N) / 2);
+	size_t N2 = N / N1;
+	size_t i;
+
+	p->transform = &ffts_execute_1d_sixstep;
+	p->destroy = &ffts_free_1d_sixstep;
+	p->N = N;
+	p->io_bytes = sizeof(float) * 4*N;
+	p->rank = 1;
+	p->sign = sign;
+	p->buf = NULL;
+	p->transpose_buf = NULL;
+	p->ws = NULL;
+	p->Ns = malloc(sizeof(size_t) * 2);
+	p->Ns[0] = N1;
+	p->Ns[1] = N2;
+
+	p->plans = malloc(sizeof(ffts_plan_t **) * 2);
+	p->plans[0] = ffts_init_1d(N1, sign);
+	p->plans[1] = (N2 == N1) ? p->plans[0] : ffts_init_1d(N2, sign);
+	if(!p->plans[0] || !p->plans[1]) {
+		if(p->plans[0]) ffts_free(p->plans[0]);
+		if(p->plans[1] && p->plans[1] != p->plans[0]) ffts_free(p->plans[1]);
+		free(p->plans);
+		free(p->Ns);
+		free(p);
+		return NULL;
+	}
+	p->isa = p->plans[0]->isa;
+
+	// scratch for the column pass, or ROWS rows for the row pass
+	size_t scratch = FFTS_LINES_SCRATCH(N1);
+	if(ROWS * N2 > scratch) scratch = ROWS * N2;
+	p->buf_size = sizeof(uint64_t) * N;
+	p->transpose_buf_size = sizeof(uint64_t) * scratch;
+	p->nplans = 2;
+	p->buf = valloc(p->buf_size);
+	p->transpose_buf = valloc(p->transpose_buf_size);
+
+	// W_N^i for i < N2, composed from about 2 sqrt(N2) libm values, and
+	// W_N^(i N2) = W_N1^i for i < N1 from the master table, which only
+	// needs to cover the sub-plans
+	const ffts_twiddle_t *t = ffts_twiddle_table(N1);
+	double *tw = malloc(sizeof(double) * 2 * (N2 + N1));
+	if(tw && ffts_twiddle_range(tw, N, N2)) {
+		free(tw);
+		tw = NULL;
+	}
+	for(i=0;tw && i<N2;i++) tw[2*i+1] *= sign;
+	for(i=0;tw && i<N1;i++) {
+		ffts_twiddle_cs(t, N1, i, &tw[2*N2 + 2*i], &tw[2*N2 + 2*i+1]);
+		tw[2*N2 + 2*i+1] *= sign;
+	}
+	p->ws = tw;
+
+	if(!p->buf || !p->transpose_buf || !p->ws) {
+		ffts_free_1d_sixstep(p);
+		return NULL;
+	}
+
+	return p;
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -154,4 +154,11 @@
     dout[0] = r0[0]; dout[1] = r0[1];
     dout[2] = r1[0]; dout[3] = r1[1];
 }
+
+ void firstpass_1(ffts_plan_t *p, const void *in, void *out)
+{
+    const data_t *din = (const data_t *)in;
+    data_t *dout = (data_t *)out;
+    dout[0] = din[0]; dout[1] = din[1];
+}
 // vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
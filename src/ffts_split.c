@@ -0,0 +1,168 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_split.h"
+#include "ffts_stats.h"
+
+/*
+ * Split format plans wrap an interleaved plan of the same size. The input is
+ * interleaved into p->buf with vector unpacks, transformed into the second
+ * half of p->buf, and split back out. Planar radix-4 kernels were tried, but
+ * they stay well behind the generated split-radix code, whose leaves keep 16
+ * points in registers, even with the two conversion passes.
+ */
+
+typedef struct {
+	const float *re, *im;
+} ffts_split_src_t;
+
+typedef struct {
+	float *re, *im;
+} ffts_split_dst_t;
+
+static void ffts_split_interleave(float *out, const float *re, const float *im, size_t N) {
+	size_t i = 0;
+#if defined(HAVE_SSE)
+	for(;i+4<=N;i+=4) {
+		__m128 r = _mm_loadu_ps(re + i);
+		__m128 m = _mm_loadu_ps(im + i);
+		_mm_store_ps(out + 2*i,     _mm_unpacklo_ps(r, m));
+		_mm_store_ps(out + 2*i + 4, _mm_unpackhi_ps(r, m));
+	}
+#elif defined(HAVE_NEON) || defined(__aarch64__)
+	for(;i+4<=N;i+=4) {
+		float32x4x2_t v;
+		v.val[0] = vld1q_f32(re + i);
+		v.val[1] = vld1q_f32(im + i);
+		vst2q_f32(out + 2*i, v);
+	}
+#endif
+	for(;i<N;i++) {
+		out[2*i]   = re[i];
+		out[2*i+1] = im[i];
+	}
+}
+
+static void ffts_split_deinterleave(float *re, float *im, const float *in, size_t N) {
+	size_t i = 0;
+#if defined(HAVE_SSE)
+	for(;i+4<=N;i+=4) {
+		__m128 a = _mm_load_ps(in + 2*i);
+		__m128 b = _mm_load_ps(in + 2*i + 4);
+		_mm_storeu_ps(re + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)));
+		_mm_storeu_ps(im + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1)));
+	}
+#elif defined(HAVE_NEON) || defined(__aarch64__)
+	for(;i+4<=N;i+=4) {
+		float32x4x2_t v = vld2q_f32(in + 2*i);
+		vst1q_f32(re + i, v.val[0]);
+		vst1q_f32(im + i, v.val[1]);
+	}
+#endif
+	for(;i<N;i++) {
+		re[i] = in[2*i];
+		im[i] = in[2*i+1];
+	}
+}
+
+void ffts_free_1d_split(ffts_plan_t *p) {
+	ffts_free(p->plans[0]);
+	free(p->plans);
+	free(p->buf);
+	free(p);
+}
+
+void ffts_execute_1d_split(ffts_plan_t *p, const void *vin, void *vout) {
+	const ffts_split_src_t *in = (const ffts_split_src_t *)vin;
+	const ffts_split_dst_t *out = (const ffts_split_dst_t *)vout;
+	size_t N = p->N;
+	float *ibuf = (float *)p->buf;
+	float *obuf = ibuf + 2 * (N + (N & 1));
+
+	ffts_split_interleave(ibuf, in->re, in->im, N);
+	p->plans[0]->transform(p->plans[0], ibuf, obuf);
+	ffts_split_deinterleave(out->re, out->im, obuf, N);
+}
+
+ffts_plan_t *ffts_init_1d_split(size_t N, int sign) {
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->transform = &ffts_execute_1d_split;
+	p->destroy = &ffts_free_1d_split;
+	p->N = N;
+	p->io_bytes = sizeof(float) * 4*N;
+	p->rank = 1;
+	p->sign = sign;
+
+	p->plans = malloc(sizeof(ffts_plan_t **) * 1);
+	if(p->plans) p->plans[0] = ffts_init_1d(N, sign);
+	if(!p->plans || !p->plans[0]) {
+		free(p->plans);
+		free(p);
+		return NULL;
+	}
+	p->isa = p->plans[0]->isa;
+
+	p->buf_size = sizeof(float) * 2 * 2 * (N + (N & 1));
+	p->transpose_buf_size = 0;
+	p->nplans = 1;
+	p->buf = valloc(p->buf_size);
+	if(!p->buf) {
+		ffts_free_1d_split(p);
+		return NULL;
+	}
+
+	return p;
+}
+
+void ffts_execute_split(ffts_plan_t *p, const float *in_re, const float *in_im,
+                        float *out_re, float *out_im) {
+	ffts_split_src_t in;
+	ffts_split_dst_t out;
+
+	if(p->transform != &ffts_execute_1d_split) {
+		LOG("ffts_execute_split: plan was not created with ffts_init_1d_split\n");
+		return;
+	}
+
+	in.re = in_re;
+	in.im = in_im;
+	out.re = out_re;
+	out.im = out_im;
+	FFTS_STATS_BEGIN(t);
+	p->transform(p, &in, &out);
+	FFTS_STATS_END(p, t, p->io_bytes);
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -32,6 +32,8 @@
 */
 #include "ffts_static.h"
 
+#ifdef HAVE_NEON
+
 void ffts_static_rec_i(ffts_plan_t *p, float *data, size_t N) {
 	if(N > 16) {
 		size_t N1 = N >> 1;
@@ -99,4 +101,258 @@ void ffts_static_transform_i(ffts_plan_t *p, const void *in, void *out) {
 		neon_static_e_i(p, in, out);
 	ffts_static_rec_i(p, out, p->N);
 }
+ffts_static_func_t ffts_static_select(size_t N, int sign) {
+	return (sign < 0) ? ffts_static_transform_f : ffts_static_transform_i;
+}
+
+#else
+
+/*
+ * The static engine on the macros.h kernels, for builds without the code
+ * generator. It follows the NEON one: leaves straight from the input to the
+ * output positions in p->offsets, then the split radix passes of
+ * ffts_static_rec, two levels at a time with K_N. Data stays interleaved
+ * throughout, and the twiddles are in the layout ffts_init_1d builds for the
+ * generated code. Sizes 32 to 4096 get their own copies of the whole
+ * transform (ffts_static_select), with the sizes, loop counts and strides
+ * known at compile time so the passes unroll.
+ */
+
+#define FFTS_STATIC_INLINE static inline __attribute__((always_inline))
+
+/* inputs k and k+M/4 of two 4-point transforms, one per complex element */
+FFTS_STATIC_INLINE void ffts_static_dft4(int inv, V a0, V a1, V a2, V a3, V *y) {
+	V t0 = VADD(a0, a2), t1 = VSUB(a0, a2);
+	V t2 = VADD(a1, a3), t3 = IMULI(inv, VSUB(a1, a3));
+	y[0] = VADD(t0, t2);
+	y[1] = VSUB(t1, t3);
+	y[2] = VSUB(t0, t2);
+	y[3] = VADD(t1, t3);
+}
+
+FFTS_STATIC_INLINE void ffts_static_dft8(int inv, const V *x, V *y) {
+	const V h = VLIT4(0.70710678118654757273731092936941f, 0.70710678118654757273731092936941f,
+	                  0.70710678118654757273731092936941f, 0.70710678118654757273731092936941f);
+	V e[4], o[4];
+
+	ffts_static_dft4(inv, x[0], x[2], x[4], x[6], e);
+	ffts_static_dft4(inv, x[1], x[3], x[5], x[7], o);
+	o[1] = VMUL(VSUB(o[1], IMULI(inv, o[1])), h);
+	o[2] = IMULI(inv, o[2]);
+	o[3] = VMUL(VADD(o[3], IMULI(inv, o[3])), h);
+	y[0] = VADD(e[0], o[0]); y[4] = VSUB(e[0], o[0]);
+	y[1] = VADD(e[1], o[1]); y[5] = VSUB(e[1], o[1]);
+	y[2] = VSUB(e[2], o[2]); y[6] = VADD(e[2], o[2]);
+	y[3] = VSUB(e[3], o[3]); y[7] = VADD(e[3], o[3]);
+}
+
+/*
+ * Sorted by input position, the N/8 leaves are 8-point transforms of the
+ * first inputs, then pairs of 4-point transforms, then 8-point transforms
+ * whose first input is N/8 before their base (see ffts_elaborate_offsets).
+ */
+#define FFTS_LEAF_EE  0
+#define FFTS_LEAF_OO  1
+#define FFTS_LEAF_EE2 2
+
+FFTS_STATIC_INLINE void ffts_static_leaf(int inv, int type, const V *x, V *y) {
+	if(type == FFTS_LEAF_EE) {
+		ffts_static_dft8(inv, x, y);
+	}else if(type == FFTS_LEAF_OO) {
+		ffts_static_dft4(inv, x[0], x[2], x[4], x[6], y);
+		ffts_static_dft4(inv, x[7], x[1], x[3], x[5], y + 4);
+	}else{
+		V r[8] = { x[7], x[0], x[1], x[2], x[3], x[4], x[5], x[6] };
+		ffts_static_dft8(inv, r, y);
+	}
+}
+
+/* two leaves, starting at input j, of the given types */
+FFTS_STATIC_INLINE void ffts_static_leaves2(int inv, int t0, int t1, ffts_plan_t *p,
+                                            const float *in, float *out, size_t N, size_t j) {
+	const float *i0 = in + 2*j;
+	size_t s = N / 4;
+	float *o0 = out + p->offsets[j], *o1 = out + p->offsets[j+1];
+	V x[8], y0[8], y1[8], *y = y0;
+
+	x[0] = VLDU(i0);       x[1] = VLDU(i0 + s);   x[2] = VLDU(i0 + 2*s); x[3] = VLDU(i0 + 3*s);
+	x[4] = VLDU(i0 + 4*s); x[5] = VLDU(i0 + 5*s); x[6] = VLDU(i0 + 6*s); x[7] = VLDU(i0 + 7*s);
+	ffts_static_leaf(inv, t0, x, y0);
+	if(t1 != t0) {
+		ffts_static_leaf(inv, t1, x, y1);
+		y = y1;
+	}
+	S_4(VUNPACKLO(y0[0], y0[1]), VUNPACKLO(y0[2], y0[3]), VUNPACKLO(y0[4], y0[5]), VUNPACKLO(y0[6], y0[7]),
+	    o0, o0 + 4, o0 + 8, o0 + 12);
+	S_4(VUNPACKHI(y[0], y[1]), VUNPACKHI(y[2], y[3]), VUNPACKHI(y[4], y[5]), VUNPACKHI(y[6], y[7]),
+	    o1, o1 + 4, o1 + 8, o1 + 12);
+}
+
+FFTS_STATIC_INLINE void ffts_static_leaves(int inv, ffts_plan_t *p, const float *in, float *out, size_t N) {
+	size_t L = N / 8;
+	size_t i0 = (L/3 + 1) / 2, i1 = (L/3 + ((L % 3) > 1)) / 2;
+	size_t n_ee = 2*i0 + !(__builtin_ctzl(N) & 1);
+	size_t n_oo = 2*i1 + 1;
+	size_t j = 0;
+
+	for(;j+1<n_ee;j+=2) ffts_static_leaves2(inv, FFTS_LEAF_EE, FFTS_LEAF_EE, p, in, out, N, j);
+	if(j < n_ee) {
+		ffts_static_leaves2(inv, FFTS_LEAF_EE, FFTS_LEAF_OO, p, in, out, N, j);
+		j += 2;
+	}
+	for(;j+1<n_ee+n_oo;j+=2) ffts_static_leaves2(inv, FFTS_LEAF_OO, FFTS_LEAF_OO, p, in, out, N, j);
+	if(j < n_ee+n_oo) {
+		ffts_static_leaves2(inv, FFTS_LEAF_OO, FFTS_LEAF_EE2, p, in, out, N, j);
+		j += 2;
+	}
+	for(;j<L;j+=2) ffts_static_leaves2(inv, FFTS_LEAF_EE2, FFTS_LEAF_EE2, p, in, out, N, j);
+}
+
+/*
+ * The last two levels of the transform at data of size N: the inner K_N
+ * forms the half size transform in the first half, the outer two the full one
+ */
+FFTS_STATIC_INLINE void ffts_static_x8(int inv, float *data, size_t N, const float *LUT) {
+	size_t s = N / 4;
+	size_t i;
+
+#pragma GCC unroll 4
+	for(i=0;i<N/16;i++) {
+		V r0 = VLDU(data),         r1 = VLDU(data + s),     r2 = VLDU(data + 2*s), r3 = VLDU(data + 3*s);
+		V r4 = VLDU(data + 4*s),   r5 = VLDU(data + 5*s),   r6 = VLDU(data + 6*s), r7 = VLDU(data + 7*s);
+
+		K_N(inv, VLD(LUT),      VLD(LUT + 4),  &r0, &r1, &r2, &r3);
+		K_N(inv, VLD(LUT + 8),  VLD(LUT + 12), &r0, &r2, &r4, &r6);
+		S_4(r0, r2, r4, r6, data, data + 2*s, data + 4*s, data + 6*s);
+		K_N(inv, VLD(LUT + 16), VLD(LUT + 20), &r1, &r3, &r5, &r7);
+		S_4(r1, r3, r5, r7, data + s, data + 3*s, data + 5*s, data + 7*s);
+		data += 4;
+		LUT += 24;
+	}
+}
+
+FFTS_STATIC_INLINE void ffts_static_x4(int inv, float *data, const float *LUT) {
+	V r0 = VLDU(data),      r1 = VLDU(data + 8),  r2 = VLDU(data + 16), r3 = VLDU(data + 24);
+	V r4 = VLDU(data + 4),  r5 = VLDU(data + 12), r6 = VLDU(data + 20), r7 = VLDU(data + 28);
+
+	K_N(inv, VLD(LUT),     VLD(LUT + 4),  &r0, &r1, &r2, &r3);
+	K_N(inv, VLD(LUT + 8), VLD(LUT + 12), &r4, &r5, &r6, &r7);
+	S_4(r0, r1, r2, r3, data, data + 8, data + 16, data + 24);
+	S_4(r4, r5, r6, r7, data + 4, data + 12, data + 20, data + 28);
+}
+
+FFTS_STATIC_INLINE const float *ffts_static_lut(ffts_plan_t *p, size_t N) {
+	return (const float *)p->ws + (p->ws_is[__builtin_ctzl(N)-4] << 1);
+}
+
+void ffts_static_rec_i(ffts_plan_t *p, float *data, size_t N) {
+	if(N > 16) {
+		size_t N1 = N >> 1;
+		size_t N2 = N >> 2;
+		size_t N3 = N >> 3;
+
+		ffts_static_rec_i(p, data, N2);
+		ffts_static_rec_i(p, data + N1, N3);
+		ffts_static_rec_i(p, data + N1 + N2, N3);
+		ffts_static_rec_i(p, data + N, N2);
+		ffts_static_rec_i(p, data + N + N1, N2);
+		ffts_static_x8(1, data, N, ffts_static_lut(p, N));
+	}else if(N==16){
+		ffts_static_x4(1, data, p->ws);
+	}
+}
+
+void ffts_static_rec_f(ffts_plan_t *p, float *data, size_t N) {
+	if(N > 16) {
+		size_t N1 = N >> 1;
+		size_t N2 = N >> 2;
+		size_t N3 = N >> 3;
+
+		ffts_static_rec_f(p, data, N2);
+		ffts_static_rec_f(p, data + N1, N3);
+		ffts_static_rec_f(p, data + N1 + N2, N3);
+		ffts_static_rec_f(p, data + N, N2);
+		ffts_static_rec_f(p, data + N + N1, N2);
+		ffts_static_x8(0, data, N, ffts_static_lut(p, N));
+	}else if(N==16){
+		ffts_static_x4(0, data, p->ws);
+	}
+}
+
+void ffts_static_transform_f(ffts_plan_t *p, const void *in, void *out) {
+	ffts_static_leaves(0, p, in, out, p->N);
+	ffts_static_rec_f(p, out, p->N);
+}
+
+void ffts_static_transform_i(ffts_plan_t *p, const void *in, void *out) {
+	ffts_static_leaves(1, p, in, out, p->N);
+	ffts_static_rec_i(p, out, p->N);
+}
+
+/*
+ * The size specialized transforms: ffts_static_rec_<N>_<f|i> is the
+ * recursion above for one size, so every pass below it is expanded in place
+ */
+#define FFTS_STATIC_REC(N, N2, N3, s, inv) \
+static void ffts_static_rec_##N##_##s(ffts_plan_t *p, float *data) { \
+	ffts_static_rec_##N2##_##s(p, data); \
+	ffts_static_rec_##N3##_##s(p, data + N/2); \
+	ffts_static_rec_##N3##_##s(p, data + N/2 + N/4); \
+	ffts_static_rec_##N2##_##s(p, data + N); \
+	ffts_static_rec_##N2##_##s(p, data + N + N/2); \
+	ffts_static_x8(inv, data, N, ffts_static_lut(p, N)); \
+}
+
+#define FFTS_STATIC_SIZES(s, inv) \
+FFTS_STATIC_INLINE void ffts_static_rec_4_##s(ffts_plan_t *p, float *data) { } \
+FFTS_STATIC_INLINE void ffts_static_rec_8_##s(ffts_plan_t *p, float *data) { } \
+FFTS_STATIC_INLINE void ffts_static_rec_16_##s(ffts_plan_t *p, float *data) { \
+	ffts_static_x4(inv, data, p->ws); \
+} \
+FFTS_STATIC_REC(32,   8,    4,    s, inv) \
+FFTS_STATIC_REC(64,   16,   8,    s, inv) \
+FFTS_STATIC_REC(128,  32,   16,   s, inv) \
+FFTS_STATIC_REC(256,  64,   32,   s, inv) \
+FFTS_STATIC_REC(512,  128,  64,   s, inv) \
+FFTS_STATIC_REC(1024, 256,  128,  s, inv) \
+FFTS_STATIC_REC(2048, 512,  256,  s, inv) \
+FFTS_STATIC_REC(4096, 1024, 512,  s, inv)
+
+FFTS_STATIC_SIZES(f, 0)
+FFTS_STATIC_SIZES(i, 1)
+
+#define FFTS_STATIC_TRANSFORM(N) \
+static void ffts_static_transform_##N##_f(ffts_plan_t *p, const void *in, void *out) { \
+	ffts_static_leaves(0, p, in, out, N); \
+	ffts_static_rec_##N##_f(p, out); \
+} \
+static void ffts_static_transform_##N##_i(ffts_plan_t *p, const void *in, void *out) { \
+	ffts_static_leaves(1, p, in, out, N); \
+	ffts_static_rec_##N##_i(p, out); \
+}
+
+FFTS_STATIC_TRANSFORM(32)
+FFTS_STATIC_TRANSFORM(64)
+FFTS_STATIC_TRANSFORM(128)
+FFTS_STATIC_TRANSFORM(256)
+FFTS_STATIC_TRANSFORM(512)
+FFTS_STATIC_TRANSFORM(1024)
+FFTS_STATIC_TRANSFORM(2048)
+FFTS_STATIC_TRANSFORM(4096)
+
+static const ffts_static_func_t ffts_static_sized[2][8] = {
+	{ ffts_static_transform_32_f,   ffts_static_transform_64_f,   ffts_static_transform_128_f,
+	  ffts_static_transform_256_f,  ffts_static_transform_512_f,  ffts_static_transform_1024_f,
+	  ffts_static_transform_2048_f, ffts_static_transform_4096_f },
+	{ ffts_static_transform_32_i,   ffts_static_transform_64_i,   ffts_static_transform_128_i,
+	  ffts_static_transform_256_i,  ffts_static_transform_512_i,  ffts_static_transform_1024_i,
+	  ffts_static_transform_2048_i, ffts_static_transform_4096_i }
+};
+
+ffts_static_func_t ffts_static_select(size_t N, int sign) {
+	if(N >= 32 && N <= 4096) return ffts_static_sized[sign > 0][__builtin_ctzl(N) - 5];
+	return (sign < 0) ? ffts_static_transform_f : ffts_static_transform_i;
+}
+
+#endif
 // vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
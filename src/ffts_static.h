@@ -35,7 +35,13 @@
 #define __FFTS_STATIC_H__
 
 #include "ffts.h"
+#ifdef HAVE_NEON
 #include "neon.h"
+#else
+#include "macros.h"
+#endif
+
+typedef void (*ffts_static_func_t)(ffts_plan_t *, const void *, void *);
 
 void ffts_static_rec_f(ffts_plan_t *p, float *data, size_t N) ;
 void ffts_static_transform_f(ffts_plan_t *p, const void *in, void *out);
@@ -43,5 +49,8 @@ void ffts_static_transform_f(ffts_plan_t *p, const void *in, void *out);
 void ffts_static_rec_i(ffts_plan_t *p, float *data, size_t N) ;
 void ffts_static_transform_i(ffts_plan_t *p, const void *in, void *out);
 
+/* the transform for a plan of size N >= 32 */
+ffts_static_func_t ffts_static_select(size_t N, int sign);
+
 #endif
 // vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -0,0 +1,61 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_stats.h"
+
+#include <string.h>
+
+int ffts_plan_stats(ffts_plan_t *p, ffts_plan_stats_t *stats) {
+	memset(stats, 0, sizeof(ffts_plan_stats_t));
+#ifdef FFTS_INSTRUMENT
+	stats->calls = __atomic_load_n(&p->calls, __ATOMIC_RELAXED);
+	stats->cycles = __atomic_load_n(&p->cycles, __ATOMIC_RELAXED);
+	stats->bytes = __atomic_load_n(&p->bytes, __ATOMIC_RELAXED);
+	return 0;
+#else
+	(void)p;
+	return -1;
+#endif
+}
+
+void ffts_plan_stats_reset(ffts_plan_t *p) {
+#ifdef FFTS_INSTRUMENT
+	__atomic_store_n(&p->calls, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&p->cycles, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&p->bytes, 0, __ATOMIC_RELAXED);
+#else
+	(void)p;
+#endif
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
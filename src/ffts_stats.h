@@ -0,0 +1,96 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef __FFTS_STATS_H__
+#define __FFTS_STATS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ffts.h"
+
+#if defined(FFTS_INSTRUMENT) && !defined(__x86_64__) && !defined(__i386__) && !defined(__aarch64__)
+#include <time.h>
+#endif
+
+typedef struct {
+	uint64_t calls, cycles, bytes;
+} ffts_plan_stats_t;
+
+int ffts_plan_stats(ffts_plan_t *, ffts_plan_stats_t *);
+void ffts_plan_stats_reset(ffts_plan_t *);
+
+/*
+ * Execution counters, kept in the plan by builds configured with
+ * --enable-instrumentation. The public entry points time the call and
+ * add it to the plan they were given (not to the plans it's built
+ * from); plans may be shared between threads, so the counters are
+ * updated atomically. Without FFTS_INSTRUMENT the macros are empty.
+ */
+#ifdef FFTS_INSTRUMENT
+
+__INLINE uint64_t ffts_stats_clock(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+	uint64_t t;
+	__asm__ __volatile__("mrs %0, cntvct_el0" : "=r" (t));
+	return t;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+__INLINE void ffts_stats_add(ffts_plan_t *p, uint64_t start, uint64_t bytes) {
+	uint64_t t = ffts_stats_clock() - start;
+	__atomic_fetch_add(&p->calls, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&p->cycles, t, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&p->bytes, bytes, __ATOMIC_RELAXED);
+}
+
+#define FFTS_STATS_BEGIN(t)         uint64_t t = ffts_stats_clock()
+#define FFTS_STATS_END(p, t, bytes) ffts_stats_add((p), (t), (bytes))
+
+#else
+
+#define FFTS_STATS_BEGIN(t)
+#define FFTS_STATS_END(p, t, bytes)
+
+#endif
+
+#endif
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
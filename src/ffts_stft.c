@@ -0,0 +1,239 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_stft.h"
+#include "ffts_real.h"
+#include "ffts_stats.h"
+#include "macros.h"
+
+#include <string.h>
+
+/*
+ * Short-time Fourier transforms over a stream, with frames of N samples
+ * every hop samples, built on a real plan of size N.
+ *
+ * The analysis keeps the last N input samples in a ring. Each frame is
+ * windowed while it is gathered out of the ring into an aligned buffer, in
+ * one vectorized pass, and transformed from there; frame f covers input
+ * samples f*hop .. f*hop+N.
+ *
+ * The synthesis transforms each spectrum back, multiplies it by the window
+ * again and overlap-adds it. When a frame has been added, the first hop
+ * samples of the sum are final; they're scaled by 1/(N * sum w^2) over the
+ * frames that overlap there, so analysis followed by synthesis gives back
+ * the input once the first N - hop samples have gone through.
+ *
+ * Frames are N+4 floats apart rather than the N+2 of a spectrum, so that
+ * with an aligned frames buffer every frame is aligned for the real plan.
+ */
+
+#define FFTS_STFT_STRIDE(N) ((N) + 4)
+
+typedef struct {
+	size_t N, hop;
+	size_t pos;     // next ring position written, the oldest sample
+	size_t fill;    // samples until the next frame is complete
+	float *ring;    // analysis: last N inputs; synthesis: overlap-add sum
+	float *frame;
+	float *window;
+	float *norm;    // synthesis: scale for each of the hop output samples
+} ffts_stft_t;
+
+// out[i] = w[i] * in[i], at any alignment
+static void ffts_stft_window(float *out, const float *in, const float *w, size_t n) {
+	size_t i;
+	for(i=0;i+4<=n;i+=4) VSTU(out + i, VMUL(VLDU(in + i), VLDU(w + i)));
+	for(;i<n;i++) out[i] = in[i] * w[i];
+}
+
+static void ffts_stft_frame(ffts_plan_t *p, ffts_stft_t *s, float *out) {
+	size_t first = s->N - s->pos;
+
+	ffts_stft_window(s->frame, s->ring + s->pos, s->window, first);
+	ffts_stft_window(s->frame + first, s->ring, s->window + first, s->pos);
+	p->plans[0]->transform(p->plans[0], s->frame, out);
+}
+
+static size_t ffts_stft_run(ffts_plan_t *p, const float *in, size_t n, float *frames) {
+	ffts_stft_t *s = (ffts_stft_t *)p->buf;
+	size_t nframes = 0;
+
+	while(n) {
+		size_t m = (n < s->fill) ? n : s->fill;
+		size_t k = s->N - s->pos;
+		if(k > m) k = m;
+
+		memcpy(s->ring + s->pos, in, sizeof(float) * k);
+		memcpy(s->ring, in + k, sizeof(float) * (m - k));
+		s->pos = (s->pos + m) % s->N;
+		s->fill -= m;
+		in += m;
+		n -= m;
+
+		if(!s->fill) {
+			ffts_stft_frame(p, s, frames + nframes * FFTS_STFT_STRIDE(s->N));
+			nframes++;
+			s->fill = s->hop;
+		}
+	}
+	return nframes;
+}
+
+static size_t ffts_istft_run(ffts_plan_t *p, const float *frames, size_t nframes, float *out) {
+	ffts_stft_t *s = (ffts_stft_t *)p->buf;
+	size_t f, i, N = s->N, hop = s->hop;
+
+	for(f=0;f<nframes;f++) {
+		float *acc = s->ring;
+
+		p->plans[0]->transform(p->plans[0], frames + f * FFTS_STFT_STRIDE(N), s->frame);
+		for(i=0;i+4<=N;i+=4) {
+			VST(acc + i, VADD(VLD(acc + i), VMUL(VLD(s->frame + i), VLD(s->window + i))));
+		}
+
+		for(i=0;i<hop;i++) out[i] = acc[i] * s->norm[i];
+		memmove(acc, acc + hop, sizeof(float) * (N - hop));
+		memset(acc + N - hop, 0, sizeof(float) * hop);
+		out += hop;
+	}
+	return nframes * hop;
+}
+
+size_t ffts_execute_stft(ffts_plan_t *p, const float *in, size_t n, float *frames) {
+	FFTS_STATS_BEGIN(t);
+	size_t nframes = ffts_stft_run(p, in, n, frames);
+	FFTS_STATS_END(p, t, sizeof(float) * (n + nframes * (p->N + 2)));
+	return nframes;
+}
+
+size_t ffts_execute_istft(ffts_plan_t *p, const float *frames, size_t nframes, float *out) {
+	FFTS_STATS_BEGIN(t);
+	size_t n = ffts_istft_run(p, frames, nframes, out);
+	FFTS_STATS_END(p, t, sizeof(float) * (n + nframes * (p->N + 2)));
+	return n;
+}
+
+// a single frame, with no state: N samples in, N/2+1 complex out
+void ffts_execute_1d_stft(ffts_plan_t *p, const void *in, void *out) {
+	ffts_stft_t *s = (ffts_stft_t *)p->buf;
+
+	ffts_stft_window(s->frame, (const float *)in, s->window, s->N);
+	p->plans[0]->transform(p->plans[0], s->frame, out);
+}
+
+// a single frame back, windowed but not overlap-added
+void ffts_execute_1d_istft(ffts_plan_t *p, const void *in, void *out) {
+	ffts_stft_t *s = (ffts_stft_t *)p->buf;
+
+	p->plans[0]->transform(p->plans[0], in, s->frame);
+	ffts_stft_window((float *)out, s->frame, s->window, s->N);
+}
+
+void ffts_free_stft(ffts_plan_t *p) {
+	ffts_stft_t *s = (ffts_stft_t *)p->buf;
+
+	if(p->plans) {
+		if(p->plans[0]) ffts_free(p->plans[0]);
+		free(p->plans);
+	}
+	if(s) {
+		free(s->ring);
+		free(s->frame);
+		free(s->window);
+		free(s->norm);
+		free(s);
+	}
+	free(p);
+}
+
+ffts_plan_t *ffts_init_stft(size_t N, size_t hop, const float *window, int sign) {
+	size_t i, k;
+
+	if(N < 8 || (N & (N - 1)) != 0) {
+		LOG("STFT frame size must be a power of two of at least 8\n");
+		return NULL;
+	}
+	if(!hop || hop > N) {
+		LOG("STFT hop size must be between 1 and the frame size\n");
+		return NULL;
+	}
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->transform = (sign < 0) ? &ffts_execute_1d_stft : &ffts_execute_1d_istft;
+	p->destroy = &ffts_free_stft;
+	p->N = N;
+	p->io_bytes = sizeof(float) * (2*N + 2);
+	p->rank = 1;
+	p->sign = sign;
+
+	ffts_stft_t *s = calloc(1, sizeof(ffts_stft_t));
+	p->buf = s;
+	p->nplans = -1;
+	p->plans = malloc(sizeof(ffts_plan_t **) * 1);
+	if(!s || !p->plans) {
+		ffts_free_stft(p);
+		return NULL;
+	}
+	p->plans[0] = ffts_init_1d_real(N, sign);
+
+	s->N = N;
+	s->hop = hop;
+	s->pos = 0;
+	s->fill = N;
+	s->ring = valloc(sizeof(float) * N);
+	s->frame = valloc(sizeof(float) * N);
+	s->window = valloc(sizeof(float) * N);
+	if(sign > 0) s->norm = malloc(sizeof(float) * hop);
+	if(!p->plans[0] || !s->ring || !s->frame || !s->window || (sign > 0 && !s->norm)) {
+		ffts_free_stft(p);
+		return NULL;
+	}
+	p->isa = p->plans[0]->isa;
+
+	memset(s->ring, 0, sizeof(float) * N);
+	for(i=0;i<N;i++) s->window[i] = window ? window[i] : 1.0f;
+
+	if(sign > 0) {
+		for(i=0;i<hop;i++) {
+			double w2 = 0.0;
+			for(k=i;k<N;k+=hop) w2 += (double)s->window[k] * s->window[k];
+			s->norm[i] = (w2 > 0.0) ? (float)(1.0 / (w2 * N)) : 0.0f;
+		}
+	}
+
+	return p;
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
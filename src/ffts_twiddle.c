@@ -0,0 +1,175 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_twiddle.h"
+
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+
+static pthread_mutex_t ffts_twiddle_lock = PTHREAD_MUTEX_INITIALIZER;
+#define TWIDDLE_LOCK()   pthread_mutex_lock(&ffts_twiddle_lock)
+#define TWIDDLE_UNLOCK() pthread_mutex_unlock(&ffts_twiddle_lock)
+#else
+#define TWIDDLE_LOCK()
+#define TWIDDLE_UNLOCK()
+#endif
+
+#ifdef HAVE_SSE
+#include <emmintrin.h>
+#endif
+
+/*
+ * One table serves every plan: it's grown (replaced by a larger one) when
+ * a plan needs a size it doesn't cover, so plan creation copies twiddles
+ * instead of calling sin and cos for each. The replaced tables are kept,
+ * on the prev list, for plans being set up from them; they add up to less
+ * than the current one.
+ */
+#define FFTS_TWIDDLE_MIN 1024
+
+static ffts_twiddle_t *ffts_twiddle_cur = NULL;
+
+/*
+ * Fills c[0..Q] with cos(2 pi t / 4Q). Only about 2 sqrt(Q) values come
+ * from libm: t = aB + b is split so that cos(x + y) = cos x cos y -
+ * sin x sin y, with x and y exact to the last bit, gives the rest to
+ * within an ulp or two of a double. The products are done two at a time.
+ */
+static int ffts_twiddle_gen(double *c, size_t Q) {
+	size_t B = (size_t)1 << ((__builtin_ctzl(Q) + 1) / 2);
+	size_t A = Q / B;
+	double M = 4.0 * Q;
+	double *ca, *sa, *cb, *sb;
+	size_t a, b;
+
+	ca = malloc(sizeof(double) * 2 * (A + B));
+	if(!ca) return -1;
+	sa = ca + A;
+	cb = sa + A;
+	sb = cb + B;
+
+	for(a=0;a<A;a++) {
+		ca[a] = cos(2.0 * PI * (double)(a * B) / M);
+		sa[a] = sin(2.0 * PI * (double)(a * B) / M);
+	}
+	for(b=0;b<B;b++) {
+		cb[b] = cos(2.0 * PI * (double)b / M);
+		sb[b] = sin(2.0 * PI * (double)b / M);
+	}
+
+	for(a=0;a<A;a++) {
+		double *d = c + a*B;
+#ifdef HAVE_SSE
+		__m128d x = _mm_set1_pd(ca[a]), y = _mm_set1_pd(sa[a]);
+		for(b=0;b<B;b+=2) {
+			__m128d u = _mm_mul_pd(x, _mm_loadu_pd(cb + b));
+			__m128d v = _mm_mul_pd(y, _mm_loadu_pd(sb + b));
+			_mm_storeu_pd(d + b, _mm_sub_pd(u, v));
+		}
+#else
+		for(b=0;b<B;b++) d[b] = ca[a]*cb[b] - sa[a]*sb[b];
+#endif
+	}
+	c[0] = 1.0;
+	c[Q] = 0.0;
+
+	free(ca);
+	return 0;
+}
+
+/*
+ * W_N^k for k < n as (cos, sin) pairs of 2 pi k / N, for plans that need
+ * a few twiddles of a size too large to grow the master table to. k = aB
+ * + b is split as in ffts_twiddle_gen, so about 2 sqrt(n) values come
+ * from libm and the rest from one complex product each.
+ */
+int ffts_twiddle_range(double *w, size_t N, size_t n) {
+	size_t B = 1, A, a, b, k;
+	double *ab;
+
+	while(B * B < n) B *= 2;
+	A = (n + B - 1) / B;
+	ab = malloc(sizeof(double) * 2 * (A + B));
+	if(!ab) return -1;
+
+	for(a=0;a<A;a++) {
+		ab[2*a]   = cos(2.0 * PI * (double)(a * B) / (double)N);
+		ab[2*a+1] = sin(2.0 * PI * (double)(a * B) / (double)N);
+	}
+	for(b=0;b<B;b++) {
+		ab[2*A + 2*b]   = cos(2.0 * PI * (double)b / (double)N);
+		ab[2*A + 2*b+1] = sin(2.0 * PI * (double)b / (double)N);
+	}
+	for(k=0;k<n;k++) {
+		const double *x = ab + 2*(k / B), *y = ab + 2*A + 2*(k % B);
+		w[2*k]   = x[0]*y[0] - x[1]*y[1];
+		w[2*k+1] = x[1]*y[0] + x[0]*y[1];
+	}
+
+	free(ab);
+	return 0;
+}
+
+const ffts_twiddle_t *ffts_twiddle_table(size_t n) {
+	ffts_twiddle_t *t;
+	size_t M;
+
+	if(!n || (n & (n - 1))) return NULL;
+
+	t = __atomic_load_n(&ffts_twiddle_cur, __ATOMIC_ACQUIRE);
+	if(t && t->M >= n) return t;
+
+	TWIDDLE_LOCK();
+	t = ffts_twiddle_cur;
+	if(!t || t->M < n) {
+		ffts_twiddle_t *g;
+
+		M = (n < FFTS_TWIDDLE_MIN) ? FFTS_TWIDDLE_MIN : n;
+		g = malloc(sizeof(ffts_twiddle_t) + sizeof(double) * (M/4 + 1));
+		if(g) {
+			g->M = M;
+			g->c = (const double *)(g + 1);
+			g->prev = t;
+			if(ffts_twiddle_gen((double *)(g + 1), M/4)) {
+				free(g);
+				g = NULL;
+			}
+		}
+		if(g) __atomic_store_n(&ffts_twiddle_cur, g, __ATOMIC_RELEASE);
+		t = g;
+	}
+	TWIDDLE_UNLOCK();
+	return t;
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
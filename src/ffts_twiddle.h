@@ -0,0 +1,98 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef __FFTS_TWIDDLE_H__
+#define __FFTS_TWIDDLE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ffts.h"
+
+/*
+ * The master twiddle table: c[t] = cos(2 pi t / M) for t = 0..M/4, in
+ * double precision, M a power of two. Every W_n^k with n dividing M is
+ * read from it by symmetry. Tables are never freed, so a pointer from
+ * ffts_twiddle_table stays valid after the table is grown.
+ */
+typedef struct _ffts_twiddle_t {
+	size_t M;
+	const double *c;
+	struct _ffts_twiddle_t *prev;
+} ffts_twiddle_t;
+
+/* the master table grown to cover size n; NULL if n isn't a power of two
+ * (or there's no memory), in which case ffts_twiddle_cs falls back to libm */
+const ffts_twiddle_t *ffts_twiddle_table(size_t n);
+
+/* (cos, sin) of 2 pi k / N at w[2k], w[2k+1] for k < n, n much less than
+ * N, without growing the master table to N; -1 if there's no memory */
+int ffts_twiddle_range(double *w, size_t N, size_t n);
+
+// c = cos(2 pi k / n), s = sin(2 pi k / n), for k < n
+__INLINE void ffts_twiddle_cs(const ffts_twiddle_t *t, size_t n, size_t k, double *c, double *s) {
+	size_t q, x, r;
+	double cr, sr;
+
+	if(!t || n > t->M) {
+		double a = 2.0 * PI * (double)k / (double)n;
+		*c = cos(a);
+		*s = sin(a);
+		return;
+	}
+
+	q = t->M / 4;
+	x = k * (t->M / n);
+	r = x & (q - 1);
+	cr = t->c[r];
+	sr = t->c[q - r];
+	switch((x / q) & 3) {
+		case 0: *c =  cr; *s =  sr; break;
+		case 1: *c = -sr; *s =  cr; break;
+		case 2: *c = -cr; *s = -sr; break;
+		default: *c = sr; *s = -cr; break;
+	}
+}
+
+// w = W_n^k = exp(-2 pi i k / n), rounded to float as the LUTs hold it
+__INLINE void ffts_lut_twiddle(const ffts_twiddle_t *t, size_t n, size_t k, float *w) {
+	double c, s;
+	ffts_twiddle_cs(t, n, k, &c, &s);
+	w[0] = c;
+	w[1] = -s;
+}
+
+#endif
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
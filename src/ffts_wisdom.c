@@ -0,0 +1,439 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_wisdom.h"
+#include "ffts_cache.h"
+#include "ffts_cpu.h"
+
+#ifdef DYNAMIC_DISABLED
+	#include "ffts_static.h"
+#else
+	#include "codegen.h"
+	#include "ffts_code.h"
+#endif
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __x86_64__
+void sse_constants();
+void sse_constants_inv();
+#endif
+
+/*
+ * Wisdom files hold 1D power-of-two plans: the header, a record per plan,
+ * then each plan's offsets, input indexes, LUT indexes and LUTs, 64 byte
+ * aligned, and last a page aligned region with the generated code of all
+ * of them. Importing maps the file read-only and the code region read and
+ * execute, and points the plans at them; nothing is recomputed. The code
+ * only reaches its tables through the plan, and calls within itself
+ * relative to where it is, so it runs wherever it is mapped.
+ *
+ * The header records the kernel set, pointer size and plan layout of the
+ * library that wrote the file, and its build id: a hash of the library
+ * version and of the templates the code is generated from (see
+ * ffts_codegen_build_id). Files that don't match in all of these are
+ * rejected, so code is only run by the build that generated it. Plans of
+ * sizes below 32 have no tables and are just recreated.
+ */
+
+#define FFTS_WISDOM_MAGIC "FFTSWISD"
+
+typedef struct {
+	char magic[8];
+	uint32_t version, isa, ptr_size, plan_size;
+	uint64_t count, size;
+	uint64_t code, code_size;   // region with the generated code
+	uint64_t build;             // ffts_wisdom_build_id of the writer
+} ffts_wisdom_header_t;
+
+typedef struct {
+	uint64_t N;
+	int32_t sign, isa;
+	uint64_t i0, i1, i2, n_luts;
+	uint64_t offsets, is, ws_is, ws, ws_size;   // file offsets, 0 if absent
+	uint64_t code, code_size, entry;            // from the code region
+} ffts_wisdom_record_t;
+
+typedef struct {
+	void *data, *code;
+	size_t size, code_size;
+	volatile size_t refs;
+} ffts_wisdom_map_t;
+
+#define ALIGN(x, a) (((x) + (a) - 1) / (a) * (a))
+
+static uint64_t ffts_wisdom_build_id(void) {
+#ifdef DYNAMIC_DISABLED
+	// no code is saved; the tables only depend on the version
+	uint64_t h = 0xcbf29ce484222325ULL;
+	const char *v = PACKAGE_VERSION;
+	while(*v) h = (h ^ (uint8_t)*v++) * 0x100000001b3ULL;
+	return h;
+#else
+	return ffts_codegen_build_id();
+#endif
+}
+
+static void ffts_wisdom_unref(ffts_wisdom_map_t *m) {
+	if(__sync_sub_and_fetch(&m->refs, 1)) return;
+	munmap(m->data, m->size);
+	if(m->code) munmap(m->code, m->code_size);
+	free(m);
+}
+
+void ffts_free_1d_wisdom(ffts_plan_t *p) {
+	ffts_wisdom_map_t *m = (ffts_wisdom_map_t *)p->buf;
+
+#ifndef DYNAMIC_DISABLED
+	uint8_t *c = (uint8_t *)p->transform_base;
+
+	// code generated on import (in the shared code pool) rather than
+	// mapped from the file
+	if(c && !(m->code && c >= (uint8_t *)m->code && c < (uint8_t *)m->code + m->code_size)) {
+		ffts_code_free(c, p->transform_size);
+	}
+#endif
+	ffts_wisdom_unref(m);
+	free(p);
+}
+
+static int ffts_wisdom_exportable(ffts_plan_t *p) {
+	return p->destroy == &ffts_free_1d || p->destroy == &ffts_cache_release ||
+	       p->destroy == &ffts_free_1d_wisdom;
+}
+
+static size_t ffts_wisdom_code_size(ffts_plan_t *p) {
+	const uint8_t *c = (const uint8_t *)p->transform_base;
+	size_t n = c ? p->transform_size : 0;
+
+#ifdef __x86_64__
+	// the unused tail of the buffer is zero; keep enough zeros that an
+	// instruction ending in them stays whole
+	while(n && !c[n-1]) n--;
+	if(n) n = ALIGN(n + 16, 64);
+	if(n > p->transform_size) n = p->transform_size;
+#endif
+	return n;
+}
+
+static int ffts_wisdom_pad(FILE *f, uint64_t *pos, uint64_t to) {
+	static const char zeros[64];
+	while(*pos < to) {
+		size_t n = (to - *pos < 64) ? to - *pos : 64;
+		if(fwrite(zeros, 1, n, f) != n) return -1;
+		*pos += n;
+	}
+	return 0;
+}
+
+static int ffts_wisdom_put(FILE *f, uint64_t *pos, uint64_t at, const void *data, size_t n) {
+	if(!n) return 0;
+	if(ffts_wisdom_pad(f, pos, at) || fwrite(data, 1, n, f) != n) return -1;
+	*pos += n;
+	return 0;
+}
+
+static int ffts_wisdom_write(const char *path, ffts_plan_t **plans, size_t n) {
+	ffts_wisdom_header_t h;
+	ffts_wisdom_record_t *r = calloc(n + 1, sizeof(ffts_wisdom_record_t));
+	uint64_t off, pos = 0;
+	size_t page = sysconf(_SC_PAGESIZE), i;
+	FILE *f;
+	int err = 0;
+
+	if(!r) return -1;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, FFTS_WISDOM_MAGIC, 8);
+	h.version = FFTS_WISDOM_VERSION;
+	h.isa = ffts_cpu_isa();
+	h.ptr_size = sizeof(void *);
+	h.plan_size = sizeof(ffts_plan_t);
+	h.build = ffts_wisdom_build_id();
+	h.count = n;
+
+	off = ALIGN(sizeof(h) + n * sizeof(ffts_wisdom_record_t), 64);
+	for(i=0;i<n;i++) {
+		ffts_plan_t *p = plans[i];
+		r[i].N = p->N;
+		r[i].sign = p->sign;
+		r[i].isa = p->isa;
+		if(p->N < 32) continue;
+
+		r[i].i0 = p->i0;
+		r[i].i1 = p->i1;
+		r[i].i2 = p->i2;
+		r[i].n_luts = p->n_luts;
+		r[i].offsets = off;
+		off = ALIGN(off + p->N/8 * sizeof(ptrdiff_t), 64);
+		r[i].is = off;
+		off = ALIGN(off + p->N * sizeof(ptrdiff_t), 64);
+		r[i].ws_is = off;
+		off = ALIGN(off + p->n_luts * sizeof(size_t), 64);
+		r[i].ws = off;
+		r[i].ws_size = (uint8_t *)p->lastlut - (uint8_t *)p->ws;
+		off = ALIGN(off + r[i].ws_size, 64);
+	}
+
+	h.code = ALIGN(off, page);
+	for(i=0;i<n;i++) {
+		size_t c = ffts_wisdom_code_size(plans[i]);
+		if(!c) continue;
+		r[i].code = h.code_size;
+		r[i].code_size = c;
+		r[i].entry = (uint8_t *)plans[i]->transform - (uint8_t *)plans[i]->transform_base;
+		h.code_size = ALIGN(h.code_size + c, 64);
+	}
+	h.size = h.code_size ? h.code + h.code_size : off;
+
+	f = fopen(path, "wb");
+	if(!f) {
+		free(r);
+		return -1;
+	}
+
+	err |= ffts_wisdom_put(f, &pos, 0, &h, sizeof(h));
+	err |= ffts_wisdom_put(f, &pos, pos, r, n * sizeof(ffts_wisdom_record_t));
+	for(i=0;i<n && !err;i++) {
+		ffts_plan_t *p = plans[i];
+		if(!r[i].offsets) continue;
+		err |= ffts_wisdom_put(f, &pos, r[i].offsets, p->offsets, p->N/8 * sizeof(ptrdiff_t));
+		err |= ffts_wisdom_put(f, &pos, r[i].is, p->is, p->N * sizeof(ptrdiff_t));
+		err |= ffts_wisdom_put(f, &pos, r[i].ws_is, p->ws_is, p->n_luts * sizeof(size_t));
+		err |= ffts_wisdom_put(f, &pos, r[i].ws, p->ws, r[i].ws_size);
+	}
+	for(i=0;i<n && !err;i++) {
+		err |= ffts_wisdom_put(f, &pos, h.code + r[i].code, plans[i]->transform_base, r[i].code_size);
+	}
+	if(!err) err |= ffts_wisdom_pad(f, &pos, h.size);
+
+	if(fclose(f)) err = -1;
+	free(r);
+	if(err) {
+		unlink(path);
+		return -1;
+	}
+	return 0;
+}
+
+static ffts_wisdom_map_t *ffts_wisdom_open(const char *path) {
+	ffts_wisdom_map_t *m;
+	const ffts_wisdom_header_t *h;
+	const ffts_wisdom_record_t *r;
+	struct stat st;
+	size_t page = sysconf(_SC_PAGESIZE), i;
+	int fd = open(path, O_RDONLY);
+
+	if(fd < 0) return NULL;
+	m = calloc(1, sizeof(ffts_wisdom_map_t));
+	if(!m || fstat(fd, &st) || (size_t)st.st_size < sizeof(ffts_wisdom_header_t)) goto fail;
+
+	m->size = st.st_size;
+	m->data = mmap(NULL, m->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(m->data == MAP_FAILED) {
+		m->data = NULL;
+		goto fail;
+	}
+
+	h = (const ffts_wisdom_header_t *)m->data;
+	r = (const ffts_wisdom_record_t *)(h + 1);
+	if(memcmp(h->magic, FFTS_WISDOM_MAGIC, 8) || h->version != FFTS_WISDOM_VERSION ||
+	   h->size != m->size || h->count > m->size / sizeof(ffts_wisdom_record_t) ||
+	   sizeof(*h) + h->count * sizeof(*r) > m->size ||
+	   (h->code_size && (h->code % page || h->code > m->size || h->code_size > m->size - h->code))) {
+		LOG("ffts_import_wisdom: not a wisdom file, or a damaged one\n");
+		goto fail;
+	}
+	if(h->isa != ffts_cpu_isa() || h->ptr_size != sizeof(void *) || h->plan_size != sizeof(ffts_plan_t) ||
+	   h->build != ffts_wisdom_build_id()) {
+		LOG("ffts_import_wisdom: wisdom file was written for another CPU or build\n");
+		goto fail;
+	}
+	for(i=0;i<h->count;i++) {
+		// records without tables are recreated; the rest use their tables
+		// and code in place, which must lie within the file
+		if(!r[i].offsets) continue;
+		if(r[i].N < 32 || (r[i].N & (r[i].N - 1)) || r[i].N > m->size ||
+		   r[i].offsets > m->size || r[i].is > m->size || r[i].ws_is > m->size || r[i].ws > m->size ||
+		   r[i].offsets + r[i].N/8 * sizeof(ptrdiff_t) > m->size ||
+		   r[i].is + r[i].N * sizeof(ptrdiff_t) > m->size ||
+		   r[i].n_luts >= 32 || r[i].ws_is + r[i].n_luts * sizeof(size_t) > m->size ||
+		   r[i].ws_size > m->size || r[i].ws + r[i].ws_size > m->size ||
+		   r[i].code_size > h->code_size || r[i].code > h->code_size - r[i].code_size ||
+		   r[i].entry >= r[i].code_size + !r[i].code_size) {
+			LOG("ffts_import_wisdom: not a wisdom file, or a damaged one\n");
+			goto fail;
+		}
+	}
+
+	if(h->code_size) {
+		m->code_size = h->code_size;
+		m->code = mmap(NULL, m->code_size, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, h->code);
+		if(m->code == MAP_FAILED) {
+			m->code = NULL;
+			goto fail;
+		}
+	}
+
+	close(fd);
+	m->refs = 1;
+	return m;
+
+fail:
+	close(fd);
+	if(m && m->data) munmap(m->data, m->size);
+	free(m);
+	return NULL;
+}
+
+static ffts_plan_t *ffts_wisdom_plan(ffts_wisdom_map_t *m, const ffts_wisdom_record_t *r) {
+	const uint8_t *d = (const uint8_t *)m->data;
+
+	if(!r->offsets) return ffts_init_1d_pow2(r->N, r->sign);
+
+	ffts_plan_t *p = calloc(1, sizeof(ffts_plan_t));
+	if(!p) return NULL;
+
+	p->N = r->N;
+	p->io_bytes = sizeof(float) * 4*p->N;
+	p->sign = r->sign;
+	p->isa = r->isa;
+	p->rank = 1;
+	p->i0 = r->i0;
+	p->i1 = r->i1;
+	p->i2 = r->i2;
+	p->n_luts = r->n_luts;
+	p->offsets = (ptrdiff_t *)(d + r->offsets);
+	p->is = (ptrdiff_t *)(d + r->is);
+	p->ws_is = (size_t *)(d + r->ws_is);
+	p->ws = (void *)(d + r->ws);
+	p->lastlut = (uint8_t *)p->ws + r->ws_size;
+
+	if(p->sign < 0) {
+		p->oe_ws = (void *)(&w_data[4]);
+		p->ee_ws = (void *)(w_data);
+		p->eo_ws = (void *)(&w_data[4]);
+	}else{
+		p->oe_ws = (void *)(w_data + 12);
+		p->ee_ws = (void *)(w_data + 8);
+		p->eo_ws = (void *)(w_data + 12);
+	}
+
+	// buf holds the mapping, not working memory
+	p->buf = m;
+	p->buf_size = p->transpose_buf_size = 0;
+	p->nplans = 0;
+	__sync_add_and_fetch(&m->refs, 1);
+	p->destroy = &ffts_free_1d_wisdom;
+
+#ifdef DYNAMIC_DISABLED
+	p->transform = ffts_static_select(p->N, p->sign);
+#else
+	if(r->code_size && m->code) {
+		// the saved code isn't split into regions
+		static const ffts_code_region_t whole = { 0, "transform" };
+		p->transform_base = (uint8_t *)m->code + r->code;
+		p->transform_size = r->code_size;
+		p->transform = (void *)((uint8_t *)p->transform_base + r->entry);
+		ffts_code_label(p, &whole, 1);
+#ifdef __x86_64__
+		if(p->sign < 0) p->constants = sse_constants;
+		else            p->constants = sse_constants_inv;
+#endif
+	}else{
+		ffts_generate_func_code(p, p->N, 8, p->sign);
+	}
+#endif
+
+	return p;
+}
+
+int ffts_export_plan(ffts_plan_t *p, const char *path) {
+	if(!ffts_wisdom_exportable(p)) {
+		LOG("ffts_export_plan: only 1D power of two plans can be exported\n");
+		return -1;
+	}
+	return ffts_wisdom_write(path, &p, 1);
+}
+
+ffts_plan_t *ffts_import_plan(const char *path) {
+	ffts_wisdom_map_t *m = ffts_wisdom_open(path);
+	ffts_plan_t *p = NULL;
+	const ffts_wisdom_header_t *h;
+
+	if(!m) return NULL;
+	h = (const ffts_wisdom_header_t *)m->data;
+	if(h->count) p = ffts_wisdom_plan(m, (const ffts_wisdom_record_t *)(h + 1));
+	ffts_wisdom_unref(m);
+	return p;
+}
+
+int ffts_export_wisdom(const char *path) {
+	size_t n;
+	ffts_plan_t **plans = ffts_cache_hold(&n);
+	int err;
+
+	if(!plans) return -1;
+	err = ffts_wisdom_write(path, plans, n);
+	ffts_cache_drop(plans, n);
+	return err ? -1 : (int)n;
+}
+
+int ffts_import_wisdom(const char *path) {
+	ffts_wisdom_map_t *m;
+	const ffts_wisdom_header_t *h;
+	const ffts_wisdom_record_t *r;
+	size_t i;
+	int count = 0;
+
+	ffts_plan_cache_enable(1);
+	m = ffts_wisdom_open(path);
+	if(!m) return -1;
+
+	h = (const ffts_wisdom_header_t *)m->data;
+	r = (const ffts_wisdom_record_t *)(h + 1);
+	for(i=0;i<h->count;i++) {
+		ffts_plan_t *p = ffts_wisdom_plan(m, r + i);
+		if(!p) continue;
+		if(ffts_cache_add_1d(p) > 0) count++;
+		else ffts_free(p);
+	}
+	ffts_wisdom_unref(m);
+	return count;
+}
+
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
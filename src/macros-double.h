@@ -0,0 +1,126 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef __MACROS_DOUBLE_H__
+#define __MACROS_DOUBLE_H__
+
+#include "types.h"
+
+/*
+ * 2-wide double precision vectors holding one complex value [re, im], used by
+ * the double precision transforms. Complex twiddles are kept packed as
+ * [re, im] and expanded by VDCMUL/VDCMULJ.
+ */
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+typedef __m128d VD;
+
+#define VDADD _mm_add_pd
+#define VDSUB _mm_sub_pd
+#define VDMUL _mm_mul_pd
+#define VDXOR _mm_xor_pd
+// callers' double arrays are only 8 byte aligned
+#define VDLD _mm_loadu_pd
+#define VDST _mm_storeu_pd
+#define VDLIT2 _mm_set_pd
+
+#define VDSWAP(x) (_mm_shuffle_pd(x,x,1))
+#define VDDUPRE(x) (_mm_unpacklo_pd(x,x))
+#define VDDUPIM(x) (_mm_unpackhi_pd(x,x))
+
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+
+typedef float64x2_t VD;
+
+#define VDADD vaddq_f64
+#define VDSUB vsubq_f64
+#define VDMUL vmulq_f64
+#define VDXOR(x,y) (vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(x), vreinterpretq_u64_f64(y))))
+#define VDLD vld1q_f64
+#define VDST vst1q_f64
+
+__INLINE VD VDLIT2(double f1, double f0) {
+	double __attribute__ ((aligned(16))) d[2] = {f0, f1};
+	return VDLD(d);
+}
+
+#define VDSWAP(x) (vextq_f64(x,x,1))
+#define VDDUPRE(x) (vdupq_laneq_f64(x,0))
+#define VDDUPIM(x) (vdupq_laneq_f64(x,1))
+
+#else
+
+typedef struct {double r, i;} VD;
+
+__INLINE VD VDADD(VD a, VD b) { VD r = {a.r + b.r, a.i + b.i}; return r; }
+__INLINE VD VDSUB(VD a, VD b) { VD r = {a.r - b.r, a.i - b.i}; return r; }
+__INLINE VD VDMUL(VD a, VD b) { VD r = {a.r * b.r, a.i * b.i}; return r; }
+__INLINE VD VDLD(const double *s) { VD r = {s[0], s[1]}; return r; }
+__INLINE void VDST(double *d, VD a) { d[0] = a.r; d[1] = a.i; }
+__INLINE VD VDLIT2(double f1, double f0) { VD r = {f0, f1}; return r; }
+
+__INLINE VD VDSWAP(VD a) { VD r = {a.i, a.r}; return r; }
+__INLINE VD VDDUPRE(VD a) { VD r = {a.r, a.r}; return r; }
+__INLINE VD VDDUPIM(VD a) { VD r = {a.i, a.i}; return r; }
+
+/* only used with sign masks */
+__INLINE VD VDXOR(VD a, VD m) {
+	VD r = {signbit(m.r) ? -a.r : a.r, signbit(m.i) ? -a.i : a.i};
+	return r;
+}
+
+#endif
+
+/* a * w */
+__INLINE VD VDCMUL(VD a, VD w) {
+	VD im = VDXOR(VDDUPIM(w), VDLIT2(0.0, -0.0));
+	return VDADD(VDMUL(a, VDDUPRE(w)), VDMUL(VDSWAP(a), im));
+}
+
+/* a * conj(w) */
+__INLINE VD VDCMULJ(VD a, VD w) {
+	VD im = VDXOR(VDDUPIM(w), VDLIT2(0.0, -0.0));
+	return VDSUB(VDMUL(a, VDDUPRE(w)), VDMUL(VDSWAP(a), im));
+}
+
+/* -i * a if inv, i * a otherwise */
+__INLINE VD VDMULI(int inv, VD a) {
+	if(inv) return VDXOR(VDSWAP(a), VDLIT2(-0.0, 0.0));
+	else    return VDXOR(VDSWAP(a), VDLIT2(0.0, -0.0));
+}
+
+#endif
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -52,6 +52,7 @@ typedef float32x4x2_t VS;
 #define VLD2 vld2q_f32 
 
 #define VSWAPPAIRS(x) (vrev64q_f32(x))
+#define VREVPAIRS(x) (vextq_f32(x,x,2))
 
 #define VUNPACKHI(a,b) (vcombine_f32(vget_high_f32(a), vget_high_f32(b)))
 #define VUNPACKLO(a,b) (vcombine_f32(vget_low_f32(a), vget_low_f32(b)))
@@ -47,8 +47,11 @@ typedef __m128 V;
 #define VXOR _mm_xor_ps
 #define VST _mm_store_ps
 #define VLD _mm_load_ps
+#define VSTU _mm_storeu_ps
+#define VLDU _mm_loadu_ps
 
 #define VSWAPPAIRS(x) (_mm_shuffle_ps(x,x,_MM_SHUFFLE(2,3,0,1)))
+#define VREVPAIRS(x) (_mm_shuffle_ps(x,x,_MM_SHUFFLE(1,0,3,2)))
 
 #define VUNPACKHI(x,y) (_mm_shuffle_ps(x,y,_MM_SHUFFLE(3,2,3,2)))
 #define VUNPACKLO(x,y) (_mm_shuffle_ps(x,y,_MM_SHUFFLE(1,0,1,0)))
@@ -55,6 +55,12 @@
 	#include "macros-sse.h"
 #endif
 
+// loads and stores of the caller's data, which needn't be aligned
+#ifndef VLDU
+#define VLDU VLD
+#define VSTU VST
+#endif
+
 static inline void TX2(V *a, V *b)
 {
     V TX2_t0 = VUNPACKLO(*a, *b);
@@ -83,7 +89,7 @@ static inline void S_4(V r0, V r1, V r2, V r3,
 		       data_t * restrict o0, data_t * restrict o1,
 		       data_t * restrict o2, data_t * restrict o3)
 {
-    VST(o0, r0); VST(o1, r1); VST(o2, r2); VST(o3, r3);
+    VSTU(o0, r0); VSTU(o1, r1); VSTU(o2, r2); VSTU(o3, r3);
 }
 
 
@@ -94,7 +100,7 @@ static inline void L_2_4(int inv,
 {
     V t0, t1, t2, t3, t4, t5, t6, t7;
 
-    t0 = VLD(i0);    t1 = VLD(i1);    t2 = VLD(i2);    t3 = VLD(i3);    
+    t0 = VLDU(i0);    t1 = VLDU(i1);    t2 = VLDU(i2);    t3 = VLDU(i3);    
     t4 = VADD(t0, t1);
     t5 = VSUB(t0, t1);
     t6 = VADD(t2, t3);
@@ -118,7 +124,7 @@ static inline void L_4_4(int inv,
 {
     V t0, t1, t2, t3, t4, t5, t6, t7;
  
-    t0 = VLD(i0);    t1 = VLD(i1);    t2 = VLD(i2);    t3 = VLD(i3);   
+    t0 = VLDU(i0);    t1 = VLDU(i1);    t2 = VLDU(i2);    t3 = VLDU(i3);   
     t4 = VADD(t0, t1);
     t5 = VSUB(t0, t1);
     t6 = VADD(t2, t3);
@@ -141,7 +147,7 @@ static inline void L_4_2(int inv,
 {
     V t0, t1, t2, t3, t4, t5, t6, t7;
 
-    t0 = VLD(i0);    t1 = VLD(i1);    t6 = VLD(i2);    t7 = VLD(i3);
+    t0 = VLDU(i0);    t1 = VLDU(i1);    t6 = VLDU(i2);    t7 = VLDU(i3);
     t2 = VBLEND(t6, t7);
     t3 = VBLEND(t7, t6);
     t4 = VADD(t0, t1);
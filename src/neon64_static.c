@@ -0,0 +1,310 @@
+/*
+ 
+ This file is part of FFTS -- The Fastest Fourier Transform in the South
+  
+ Copyright (c) 2012, Anthony M. Blake <amb@anthonix.com>
+ Copyright (c) 2012, The University of Waikato 
+ 
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "neon.h"
+#include <arm_neon.h>
+
+/*
+ * AArch64 versions of the static kernels in neon_static_f.s and
+ * neon_static_i.s, on the same plan tables and NEON twiddle layout. Data
+ * between passes is kept as in the A32 code, in blocks of four real parts
+ * followed by four imaginary parts, and only the last pass (x8_t) writes
+ * interleaved complex values. With 32 vector registers the leaves take four
+ * transforms at a time, one per lane, and the twiddle multiplies use FMLA.
+ *
+ * Sorted by input position, the N/8 leaves of a plan are the 8-point leaves
+ * of the first 2*i0 (+1 for even log2 N) inputs, then 2*i1+1 pairs of 4-point
+ * leaves, then 8-point leaves whose first input is N/8 before their base.
+ */
+
+typedef float32x4x2_t cv;
+
+static inline cv cv_ld(const float *p) {
+	cv a;
+	a.val[0] = vld1q_f32(p);
+	a.val[1] = vld1q_f32(p + 4);
+	return a;
+}
+
+static inline void cv_st(float *p, cv a) {
+	vst1q_f32(p, a.val[0]);
+	vst1q_f32(p + 4, a.val[1]);
+}
+
+static inline cv cv_add(cv a, cv b) {
+	cv r;
+	r.val[0] = vaddq_f32(a.val[0], b.val[0]);
+	r.val[1] = vaddq_f32(a.val[1], b.val[1]);
+	return r;
+}
+
+static inline cv cv_sub(cv a, cv b) {
+	cv r;
+	r.val[0] = vsubq_f32(a.val[0], b.val[0]);
+	r.val[1] = vsubq_f32(a.val[1], b.val[1]);
+	return r;
+}
+
+/* a * w */
+static inline cv cv_mul(cv a, cv w) {
+	cv r;
+	r.val[0] = vfmsq_f32(vmulq_f32(a.val[0], w.val[0]), a.val[1], w.val[1]);
+	r.val[1] = vfmaq_f32(vmulq_f32(a.val[1], w.val[0]), a.val[0], w.val[1]);
+	return r;
+}
+
+/* a * conj(w) */
+static inline cv cv_mulj(cv a, cv w) {
+	cv r;
+	r.val[0] = vfmaq_f32(vmulq_f32(a.val[0], w.val[0]), a.val[1], w.val[1]);
+	r.val[1] = vfmsq_f32(vmulq_f32(a.val[1], w.val[0]), a.val[0], w.val[1]);
+	return r;
+}
+
+/* a * -i for forwards transforms, a * i for backwards ones */
+static inline cv cv_rot(int inv, cv a) {
+	cv r;
+	if(inv) {
+		r.val[0] = vnegq_f32(a.val[1]);
+		r.val[1] = a.val[0];
+	}else{
+		r.val[0] = a.val[1];
+		r.val[1] = vnegq_f32(a.val[0]);
+	}
+	return r;
+}
+
+static inline cv cv_scale(cv a, float32x4_t s) {
+	cv r;
+	r.val[0] = vmulq_f32(a.val[0], s);
+	r.val[1] = vmulq_f32(a.val[1], s);
+	return r;
+}
+
+/*
+ * Conjugate-pair split radix butterfly: u0 and u1 are the outputs k and k+M/4
+ * of the half size transform, z and zc those of the two quarter size ones,
+ * and they are replaced with the outputs k, k+M/4, k+M/2 and k+3M/4.
+ */
+static inline void sr_bfly(int inv, cv *u0, cv *u1, cv *z, cv *zc, cv w) {
+	cv a = cv_mul(*z, w);
+	cv b = cv_mulj(*zc, w);
+	cv s = cv_add(a, b);
+	cv d = cv_rot(inv, cv_sub(a, b));
+	*z  = cv_sub(*u0, s);
+	*u0 = cv_add(*u0, s);
+	*zc = cv_sub(*u1, d);
+	*u1 = cv_add(*u1, d);
+}
+
+static inline void dft4(int inv, cv x0, cv x1, cv x2, cv x3, cv *y) {
+	cv t0 = cv_add(x0, x2), t1 = cv_sub(x0, x2);
+	cv t2 = cv_add(x1, x3), t3 = cv_rot(inv, cv_sub(x1, x3));
+	y[0] = cv_add(t0, t2);
+	y[1] = cv_add(t1, t3);
+	y[2] = cv_sub(t0, t2);
+	y[3] = cv_sub(t1, t3);
+}
+
+static inline void dft8(int inv, const cv *x, cv *y) {
+	const float32x4_t h = vdupq_n_f32(0.70710678118654757273731092936941f);
+	cv e[4], o[4];
+
+	dft4(inv, x[0], x[2], x[4], x[6], e);
+	dft4(inv, x[1], x[3], x[5], x[7], o);
+	o[1] = cv_scale(cv_add(o[1], cv_rot(inv, o[1])), h);
+	o[2] = cv_rot(inv, o[2]);
+	o[3] = cv_scale(cv_sub(cv_rot(inv, o[3]), o[3]), h);
+	y[0] = cv_add(e[0], o[0]); y[4] = cv_sub(e[0], o[0]);
+	y[1] = cv_add(e[1], o[1]); y[5] = cv_sub(e[1], o[1]);
+	y[2] = cv_add(e[2], o[2]); y[6] = cv_sub(e[2], o[2]);
+	y[3] = cv_add(e[3], o[3]); y[7] = cv_sub(e[3], o[3]);
+}
+
+/* v[k] lane l becomes v[l] lane k */
+static inline void transpose4(float32x4_t *v) {
+	float32x4_t t0 = vtrn1q_f32(v[0], v[1]), t1 = vtrn2q_f32(v[0], v[1]);
+	float32x4_t t2 = vtrn1q_f32(v[2], v[3]), t3 = vtrn2q_f32(v[2], v[3]);
+	v[0] = vreinterpretq_f32_f64(vtrn1q_f64(vreinterpretq_f64_f32(t0), vreinterpretq_f64_f32(t2)));
+	v[1] = vreinterpretq_f32_f64(vtrn1q_f64(vreinterpretq_f64_f32(t1), vreinterpretq_f64_f32(t3)));
+	v[2] = vreinterpretq_f32_f64(vtrn2q_f64(vreinterpretq_f64_f32(t0), vreinterpretq_f64_f32(t2)));
+	v[3] = vreinterpretq_f32_f64(vtrn2q_f64(vreinterpretq_f64_f32(t1), vreinterpretq_f64_f32(t3)));
+}
+
+/*
+ * Input k of n <= 4 leaves starting at j, one per lane: the leaves read eight
+ * streams N/8 apart
+ */
+static inline void leaf_load(const float *in, size_t s, size_t j, size_t n, cv *x) {
+	int k;
+	if(n == 4) {
+		for(k=0;k<8;k++) x[k] = vld2q_f32(in + k*s + 2*j);
+	}else{
+		float t[8] __attribute__((aligned(16)));
+		size_t i;
+		for(k=0;k<8;k++) {
+			for(i=0;i<8;i++) t[i] = (i < 2*n) ? in[k*s + 2*j + i] : 0.0f;
+			x[k] = vld2q_f32(t);
+		}
+	}
+}
+
+/* the eight outputs of each leaf go to out + offsets[l], as two blocks */
+static inline void leaf_store(float *out, const ptrdiff_t *offsets, size_t n, cv *y) {
+	float32x4_t r0[4], i0[4], r1[4], i1[4];
+	size_t l;
+	int k;
+
+	for(k=0;k<4;k++) {
+		r0[k] = y[k].val[0];   i0[k] = y[k].val[1];
+		r1[k] = y[k+4].val[0]; i1[k] = y[k+4].val[1];
+	}
+	transpose4(r0); transpose4(i0);
+	transpose4(r1); transpose4(i1);
+	for(l=0;l<n;l++) {
+		float *o = out + offsets[l];
+		vst1q_f32(o,      r0[l]);
+		vst1q_f32(o + 4,  i0[l]);
+		vst1q_f32(o + 8,  r1[l]);
+		vst1q_f32(o + 12, i1[l]);
+	}
+}
+
+static inline void neon64_leaves(int inv, ffts_plan_t *p, const float *in, float *out, size_t n_ee) {
+	size_t L = p->N / 8, s = p->N / 4;
+	size_t n_oo = 2*p->i1 + 1;
+	size_t j = 0, n;
+	cv x[8], y[8];
+	int k;
+
+	for(;j<n_ee;j+=n) {
+		n = (n_ee - j < 4) ? n_ee - j : 4;
+		leaf_load(in, s, j, n, x);
+		dft8(inv, x, y);
+		leaf_store(out, p->offsets + j, n, y);
+	}
+	for(;j<n_ee+n_oo;j+=n) {
+		n = (n_ee + n_oo - j < 4) ? n_ee + n_oo - j : 4;
+		leaf_load(in, s, j, n, x);
+		dft4(inv, x[0], x[2], x[4], x[6], y);
+		dft4(inv, x[7], x[1], x[3], x[5], y + 4);
+		leaf_store(out, p->offsets + j, n, y);
+	}
+	for(;j<L;j+=n) {
+		cv r[8];
+		n = (L - j < 4) ? L - j : 4;
+		leaf_load(in, s, j, n, x);
+		r[0] = x[7];
+		for(k=1;k<8;k++) r[k] = x[k-1];
+		dft8(inv, r, y);
+		leaf_store(out, p->offsets + j, n, y);
+	}
+}
+
+/*
+ * The last two levels of a transform of size N, on eight sections of N/8:
+ * the inner butterflies form the half size transform in the first four
+ * sections, and the outer ones the full transform
+ */
+static inline void neon64_x8(int inv, int last, float *data, size_t N, const float *LUT) {
+	size_t s = N / 4;
+	size_t i;
+	int k;
+
+	for(i=0;i<N/32;i++) {
+		cv d[8];
+		for(k=0;k<8;k++) d[k] = cv_ld(data + k*s);
+		sr_bfly(inv, &d[0], &d[1], &d[2], &d[3], cv_ld(LUT));
+		sr_bfly(inv, &d[0], &d[2], &d[4], &d[6], cv_ld(LUT + 8));
+		sr_bfly(inv, &d[1], &d[3], &d[5], &d[7], cv_ld(LUT + 16));
+		if(last) {
+			for(k=0;k<8;k++) vst2q_f32(data + k*s, d[k]);
+		}else{
+			for(k=0;k<8;k++) cv_st(data + k*s, d[k]);
+		}
+		data += 8;
+		LUT += 24;
+	}
+}
+
+static inline void neon64_x4(int inv, float *data, const float *LUT) {
+	cv u0 = cv_ld(data), u1 = cv_ld(data + 8);
+	cv z = cv_ld(data + 16), zc = cv_ld(data + 24);
+
+	sr_bfly(inv, &u0, &u1, &z, &zc, cv_ld(LUT));
+	cv_st(data, u0);
+	cv_st(data + 8, u1);
+	cv_st(data + 16, z);
+	cv_st(data + 24, zc);
+}
+
+void neon_static_e_f(ffts_plan_t *p, const void *in, void *out) {
+	neon64_leaves(0, p, in, out, 2*p->i0 + 1);
+}
+
+void neon_static_o_f(ffts_plan_t *p, const void *in, void *out) {
+	neon64_leaves(0, p, in, out, 2*p->i0);
+}
+
+void neon_static_x4_f(float *data, size_t N, float *LUT) {
+	neon64_x4(0, data, LUT);
+}
+
+void neon_static_x8_f(float *data, size_t N, float *LUT) {
+	neon64_x8(0, 0, data, N, LUT);
+}
+
+void neon_static_x8_t_f(float *data, size_t N, float *LUT) {
+	neon64_x8(0, 1, data, N, LUT);
+}
+
+void neon_static_e_i(ffts_plan_t *p, const void *in, void *out) {
+	neon64_leaves(1, p, in, out, 2*p->i0 + 1);
+}
+
+void neon_static_o_i(ffts_plan_t *p, const void *in, void *out) {
+	neon64_leaves(1, p, in, out, 2*p->i0);
+}
+
+void neon_static_x4_i(float *data, size_t N, float *LUT) {
+	neon64_x4(1, data, LUT);
+}
+
+void neon_static_x8_i(float *data, size_t N, float *LUT) {
+	neon64_x8(1, 0, data, N, LUT);
+}
+
+void neon_static_x8_t_i(float *data, size_t N, float *LUT) {
+	neon64_x8(1, 1, data, N, LUT);
+}
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
@@ -72,34 +72,34 @@ _leaf_ee:
 	.globl leaf_ee
 leaf_ee:
 #endif
-		movaps    32(%r9), %xmm0            #83.5
- 		movaps    (%r9), %xmm8            #83.5
+		movups    32(%r9), %xmm0            #83.5
+ 		movups    (%r9), %xmm8            #83.5
 LEAF_EE_1:
 LEAF_EE_const_0:
-				movaps    0xFECA(%rsi,%rax,4), %xmm7                           #83.5
+				movups    0xFECA(%rsi,%rax,4), %xmm7                           #83.5
 LEAF_EE_const_2:
-        movaps    0xFECA(%rsi,%rax,4), %xmm12                         #83.5
+        movups    0xFECA(%rsi,%rax,4), %xmm12                         #83.5
         movaps    %xmm7, %xmm6                                  #83.5
 LEAF_EE_const_3:
-        movaps    0xFECA(%rsi,%rax,4), %xmm10                         #83.5
+        movups    0xFECA(%rsi,%rax,4), %xmm10                         #83.5
         movaps    %xmm12, %xmm11                                #83.5
         subps     %xmm10, %xmm12                                #83.5
         addps     %xmm10, %xmm11                                #83.5
         xorps     %xmm8, %xmm12                                 #83.5
 LEAF_EE_const_1:
-        movaps    0xFECA(%rsi,%rax,4), %xmm9                          #83.5
+        movups    0xFECA(%rsi,%rax,4), %xmm9                          #83.5
 LEAF_EE_const_4:
-        movaps    0xFECA(%rsi,%rax,4), %xmm10                         #83.5
+        movups    0xFECA(%rsi,%rax,4), %xmm10                         #83.5
         addps     %xmm9, %xmm6                                  #83.5
         subps     %xmm9, %xmm7                                  #83.5
 LEAF_EE_const_5:
-        movaps    0xFECA(%rsi,%rax,4), %xmm13                         #83.5
+        movups    0xFECA(%rsi,%rax,4), %xmm13                         #83.5
         movaps    %xmm10, %xmm9                                 #83.5
 LEAF_EE_const_6:
-        movaps    0xFECA(%rsi,%rax,4), %xmm3                          #83.5
+        movups    0xFECA(%rsi,%rax,4), %xmm3                          #83.5
         movaps    %xmm6, %xmm5                                  #83.5
 LEAF_EE_const_7:
-        movaps    0xFECA(%rsi,%rax,4), %xmm14                          #83.5
+        movups    0xFECA(%rsi,%rax,4), %xmm14                          #83.5
         movaps    %xmm3, %xmm15                                 #83.5
         shufps    $177, %xmm12, %xmm12                          #83.5
         movaps    %xmm7, %xmm4                                  #83.5
@@ -112,9 +112,9 @@ LEAF_EE_const_7:
         addps     %xmm12, %xmm7                                 #83.5
         addps     %xmm13, %xmm9                                 #83.5
         addps     %xmm14, %xmm15                                #83.5
-        movaps    16(%r9), %xmm12           #83.5
+        movups    16(%r9), %xmm12           #83.5
         movaps    %xmm9, %xmm1                                  #83.5
-        movaps    16(%r9), %xmm11           #83.5
+        movups    16(%r9), %xmm11           #83.5
         movaps    %xmm5, %xmm2                                  #83.5
         mulps     %xmm10, %xmm12                                #83.5
         subps     %xmm15, %xmm9                                 #83.5
@@ -159,14 +159,14 @@ LEAF_EE_const_7:
         movlhps   %xmm14, %xmm9                                 #83.5
         shufps    $238, %xmm13, %xmm5                           #83.5
         shufps    $238, %xmm14, %xmm6                           #83.5
-        movaps    %xmm3, (%rdx,%r11,4)                          #83.5
-        movaps    %xmm4, 16(%rdx,%r11,4)                        #83.5
-        movaps    %xmm7, 32(%rdx,%r11,4)                        #83.5
-        movaps    %xmm9, 48(%rdx,%r11,4)                        #83.5
-        movaps    %xmm2, (%rdx,%r12,4)                          #83.5
-        movaps    %xmm1, 16(%rdx,%r12,4)                        #83.5
-        movaps    %xmm5, 32(%rdx,%r12,4)                        #83.5
-        movaps    %xmm6, 48(%rdx,%r12,4)                        #83.5
+        movups    %xmm3, (%rdx,%r11,4)                          #83.5
+        movups    %xmm4, 16(%rdx,%r11,4)                        #83.5
+        movups    %xmm7, 32(%rdx,%r11,4)                        #83.5
+        movups    %xmm9, 48(%rdx,%r11,4)                        #83.5
+        movups    %xmm2, (%rdx,%r12,4)                          #83.5
+        movups    %xmm1, 16(%rdx,%r12,4)                        #83.5
+        movups    %xmm5, 32(%rdx,%r12,4)                        #83.5
+        movups    %xmm6, 48(%rdx,%r12,4)                        #83.5
 				cmpq	%rcx, %rax
         jne      LEAF_EE_1 
         
@@ -180,31 +180,31 @@ _leaf_oo:
 	.globl leaf_oo
 leaf_oo:
 #endif
-        movaps    (%r9), %xmm5            #92.7
+        movups    (%r9), %xmm5            #92.7
 LEAF_OO_1:
 LEAF_OO_const_0:
-        movaps    0xFECA(%rsi,%rax,4), %xmm4                           #93.5
+        movups    0xFECA(%rsi,%rax,4), %xmm4                           #93.5
         movaps    %xmm4, %xmm6                                  #93.5
 LEAF_OO_const_1:
-        movaps    0xFECA(%rsi,%rax,4), %xmm7                          #93.5
+        movups    0xFECA(%rsi,%rax,4), %xmm7                          #93.5
 LEAF_OO_const_2:
-        movaps    0xFECA(%rsi,%rax,4), %xmm10                         #93.5
+        movups    0xFECA(%rsi,%rax,4), %xmm10                         #93.5
         addps     %xmm7, %xmm6                                  #93.5
         subps     %xmm7, %xmm4                                  #93.5
 LEAF_OO_const_3:
-        movaps    0xFECA(%rsi,%rax,4), %xmm8                          #93.5
+        movups    0xFECA(%rsi,%rax,4), %xmm8                          #93.5
         movaps    %xmm10, %xmm9                                 #93.5
 LEAF_OO_const_4:
-        movaps    0xFECA(%rsi,%rax,4), %xmm1                          #93.5
+        movups    0xFECA(%rsi,%rax,4), %xmm1                          #93.5
         movaps    %xmm6, %xmm3                                  #93.5
 LEAF_OO_const_5:
-        movaps    0xFECA(%rsi,%rax,4), %xmm11                         #93.5
+        movups    0xFECA(%rsi,%rax,4), %xmm11                         #93.5
         movaps    %xmm1, %xmm2                                  #93.5
 LEAF_OO_const_6:
-        movaps    0xFECA(%rsi,%rax,4), %xmm14                         #93.5
+        movups    0xFECA(%rsi,%rax,4), %xmm14                         #93.5
         movaps    %xmm4, %xmm15                                 #93.5
 LEAF_OO_const_7:
-        movaps    0xFECA(%rsi,%rax,4), %xmm12                          #93.5
+        movups    0xFECA(%rsi,%rax,4), %xmm12                          #93.5
         movaps    %xmm14, %xmm13                                #93.5
         movslq    (%r8, %rax, 4), %r11                                   #83.44
         subps     %xmm8, %xmm10                                 #93.5
@@ -241,14 +241,14 @@ LEAF_OO_const_7:
         shufps    $238, %xmm15, %xmm3                           #93.5
         shufps    $238, %xmm13, %xmm9                           #93.5
         shufps    $238, %xmm1, %xmm2                            #93.5
-        movaps    %xmm14, (%rdx,%r11,4)                         #93.5
-        movaps    %xmm7, 16(%rdx,%r11,4)                        #93.5
-        movaps    %xmm4, 32(%rdx,%r11,4)                        #93.5
-        movaps    %xmm8, 48(%rdx,%r11,4)                        #93.5
-        movaps    %xmm3, (%rdx,%r12,4)                          #93.5
-        movaps    %xmm6, 16(%rdx,%r12,4)                        #93.5
-        movaps    %xmm9, 32(%rdx,%r12,4)                        #93.5
-        movaps    %xmm2, 48(%rdx,%r12,4)                        #93.5
+        movups    %xmm14, (%rdx,%r11,4)                         #93.5
+        movups    %xmm7, 16(%rdx,%r11,4)                        #93.5
+        movups    %xmm4, 32(%rdx,%r11,4)                        #93.5
+        movups    %xmm8, 48(%rdx,%r11,4)                        #93.5
+        movups    %xmm3, (%rdx,%r12,4)                          #93.5
+        movups    %xmm6, 16(%rdx,%r12,4)                        #93.5
+        movups    %xmm9, 32(%rdx,%r12,4)                        #93.5
+        movups    %xmm2, 48(%rdx,%r12,4)                        #93.5
 				cmpq	%rcx, %rax
         jne       LEAF_OO_1       # Prob 95%                      #92.14
 
@@ -260,20 +260,20 @@ _leaf_eo:
 leaf_eo:
 #endif
 LEAF_EO_const_0:
-        movaps    0xFECA(%rsi,%rax,4), %xmm9                          #88.5
+        movups    0xFECA(%rsi,%rax,4), %xmm9                          #88.5
 LEAF_EO_const_2:
-        movaps    0xFECA(%rsi,%rax,4), %xmm7                          #88.5
+        movups    0xFECA(%rsi,%rax,4), %xmm7                          #88.5
         movaps    %xmm9, %xmm11                                 #88.5
 LEAF_EO_const_3:
-        movaps    0xFECA(%rsi,%rax,4), %xmm5                           #88.5
+        movups    0xFECA(%rsi,%rax,4), %xmm5                           #88.5
         movaps    %xmm7, %xmm6                                  #88.5
 LEAF_EO_const_1:
-        movaps    0xFECA(%rsi,%rax,4), %xmm4                          #88.5
+        movups    0xFECA(%rsi,%rax,4), %xmm4                          #88.5
         subps     %xmm5, %xmm7                                  #88.5
         addps     %xmm4, %xmm11                                 #88.5
         subps     %xmm4, %xmm9                                  #88.5
         addps     %xmm5, %xmm6                                  #88.5
-        movaps    (%r9), %xmm3            #88.5
+        movups    (%r9), %xmm3            #88.5
         movaps    %xmm11, %xmm10                                #88.5
         xorps     %xmm3, %xmm7                                  #88.5
         movaps    %xmm9, %xmm8                                  #88.5
@@ -288,19 +288,19 @@ LEAF_EO_const_1:
         movaps    %xmm11, %xmm1                                 #88.5
         shufps    $238, %xmm8, %xmm10                           #88.5
         shufps    $238, %xmm9, %xmm11                           #88.5
-        movaps    %xmm10, (%rdx,%r12,4)                         #88.5
-        movaps    %xmm11, 16(%rdx,%r12,4)                       #88.5
+        movups    %xmm10, (%rdx,%r12,4)                         #88.5
+        movups    %xmm11, 16(%rdx,%r12,4)                       #88.5
 LEAF_EO_const_4:
-        movaps    0xFECA(%rsi,%rax,4), %xmm15                         #88.5
+        movups    0xFECA(%rsi,%rax,4), %xmm15                         #88.5
 LEAF_EO_const_5:
-        movaps    0xFECA(%rsi,%rax,4), %xmm12                         #88.5
+        movups    0xFECA(%rsi,%rax,4), %xmm12                         #88.5
         movaps    %xmm15, %xmm14                                #88.5
 LEAF_EO_const_6:
-        movaps    0xFECA(%rsi,%rax,4), %xmm4                          #88.5
+        movups    0xFECA(%rsi,%rax,4), %xmm4                          #88.5
         addps     %xmm12, %xmm14                                #88.5
         subps     %xmm12, %xmm15                                #88.5
 LEAF_EO_const_7:
-        movaps    0xFECA(%rsi,%rax,4), %xmm13                         #88.5
+        movups    0xFECA(%rsi,%rax,4), %xmm13                         #88.5
         movaps    %xmm4, %xmm5                                  #88.5
         movaps    %xmm14, %xmm7                                 #88.5
         addps     %xmm13, %xmm5                                 #88.5
@@ -317,13 +317,13 @@ LEAF_EO_const_7:
         movlhps   %xmm4, %xmm8                                  #88.5
         movaps    %xmm1, %xmm12                                 #88.5
         shufps    $177, %xmm15, %xmm15                          #88.5
-        movaps    0x30(%r9), %xmm11           #88.5
+        movups    0x30(%r9), %xmm11           #88.5
         addq      $4, %rax                                       #90.5
         subps     %xmm15, %xmm14                                #88.5
         mulps     %xmm7, %xmm11                                 #88.5
         addps     %xmm15, %xmm4                                 #88.5
-        movaps    0x30(%r9), %xmm9            #88.5
-        movaps    0x40(%r9), %xmm15           #88.5
+        movups    0x30(%r9), %xmm9            #88.5
+        movups    0x40(%r9), %xmm15           #88.5
         shufps    $177, %xmm7, %xmm7                            #88.5
         mulps     %xmm8, %xmm9                                  #88.5
         mulps     %xmm15, %xmm7                                 #88.5
@@ -343,12 +343,12 @@ LEAF_EO_const_7:
         addps     %xmm11, %xmm12                                #88.5
         subps     %xmm11, %xmm1                                 #88.5
         shufps    $238, %xmm4, %xmm5                            #88.5
-        movaps    %xmm5, 48(%rdx,%r12,4)                        #88.5
-        movaps    %xmm6, 32(%rdx,%r12,4)                        #88.5
-        movaps    %xmm2, (%rdx,%r11,4)                          #88.5
-        movaps    %xmm1, 16(%rdx,%r11,4)                        #88.5
-        movaps    %xmm3, 32(%rdx,%r11,4)                        #88.5
-        movaps    %xmm12, 48(%rdx,%r11,4)                       #88.5
+        movups    %xmm5, 48(%rdx,%r12,4)                        #88.5
+        movups    %xmm6, 32(%rdx,%r12,4)                        #88.5
+        movups    %xmm2, (%rdx,%r11,4)                          #88.5
+        movups    %xmm1, 16(%rdx,%r11,4)                        #88.5
+        movups    %xmm3, 32(%rdx,%r11,4)                        #88.5
+        movups    %xmm12, 48(%rdx,%r11,4)                       #88.5
 	
 
 #ifdef __APPLE__
@@ -358,20 +358,20 @@ _leaf_oe:
 	.globl leaf_oe
 leaf_oe:
 #endif
-        movaps    (%r9), %xmm0           #59.5
+        movups    (%r9), %xmm0           #59.5
         #movaps    0x20(%r9), %xmm1           #59.5
 LEAF_OE_const_2:
-				movaps    0xFECA(%rsi,%rax,4), %xmm6                          #70.5
+				movups    0xFECA(%rsi,%rax,4), %xmm6                          #70.5
 LEAF_OE_const_3:
-        movaps    0xFECA(%rsi,%rax,4), %xmm8                           #70.5
+        movups    0xFECA(%rsi,%rax,4), %xmm8                           #70.5
         movaps    %xmm6, %xmm10                                 #70.5
         shufps    $228, %xmm8, %xmm10                           #70.5
         movaps    %xmm10, %xmm9                                 #70.5
         shufps    $228, %xmm6, %xmm8                            #70.5
 LEAF_OE_const_0:
-        movaps    0xFECA(%rsi,%rax,4), %xmm12                         #70.5
+        movups    0xFECA(%rsi,%rax,4), %xmm12                         #70.5
 LEAF_OE_const_1:
-        movaps    0xFECA(%rsi,%rax,4), %xmm7                          #70.5
+        movups    0xFECA(%rsi,%rax,4), %xmm7                          #70.5
         movaps    %xmm12, %xmm14                                #70.5
         movslq    (%r8, %rax, 4), %r11                                   #83.44
         addps     %xmm8, %xmm9                                  #70.5
@@ -392,30 +392,30 @@ LEAF_OE_const_1:
         addps     %xmm10, %xmm12                                #70.5
         movslq    8(%r8, %rax, 4), %r12                                  #83.59
         movlhps   %xmm11, %xmm13                                #70.5
-        movaps    %xmm13, (%rdx,%r11,4)                         #70.5
-        movaps    0x30(%r9), %xmm13          #70.5
+        movups    %xmm13, (%rdx,%r11,4)                         #70.5
+        movups    0x30(%r9), %xmm13          #70.5
         movlhps   %xmm12, %xmm14                                #70.5
-        movaps    0x40(%r9), %xmm12          #70.5
+        movups    0x40(%r9), %xmm12          #70.5
         mulps     %xmm5, %xmm13                                 #70.5
         shufps    $177, %xmm5, %xmm5                            #70.5
         mulps     %xmm12, %xmm5                                 #70.5
-        movaps    %xmm14, 16(%rdx,%r11,4)                       #70.5
+        movups    %xmm14, 16(%rdx,%r11,4)                       #70.5
         subps     %xmm5, %xmm13                                 #70.5
-        movaps    0x30(%r9), %xmm5           #70.5
+        movups    0x30(%r9), %xmm5           #70.5
         mulps     %xmm4, %xmm5                                  #70.5
         shufps    $177, %xmm4, %xmm4                            #70.5
         mulps     %xmm12, %xmm4                                 #70.5
 LEAF_OE_const_4:
-        movaps    0xFECA(%rsi,%rax,4), %xmm9                          #70.5
+        movups    0xFECA(%rsi,%rax,4), %xmm9                          #70.5
         addps     %xmm4, %xmm5                                  #70.5
 LEAF_OE_const_6:
-        movaps    0xFECA(%rsi,%rax,4), %xmm7                          #70.5
+        movups    0xFECA(%rsi,%rax,4), %xmm7                          #70.5
         movaps    %xmm9, %xmm3                                  #70.5
 LEAF_OE_const_7:
-        movaps    0xFECA(%rsi,%rax,4), %xmm2                          #70.5
+        movups    0xFECA(%rsi,%rax,4), %xmm2                          #70.5
         movaps    %xmm7, %xmm6                                  #70.5
 LEAF_OE_const_5:
-        movaps    0xFECA(%rsi,%rax,4), %xmm15                         #70.5
+        movups    0xFECA(%rsi,%rax,4), %xmm15                         #70.5
         movaps    %xmm13, %xmm4                                 #70.5
         subps     %xmm2, %xmm7                                  #70.5
         addps     %xmm15, %xmm3                                 #70.5
@@ -446,12 +446,12 @@ LEAF_OE_const_5:
         addps     %xmm13, %xmm4                                 #70.5
         movlhps   %xmm8, %xmm10                                 #70.5
         movlhps   %xmm9, %xmm11                                 #70.5
-        movaps    %xmm10, 32(%rdx,%r11,4)                       #70.5
-        movaps    %xmm11, 48(%rdx,%r11,4)                       #70.5
-        movaps    %xmm2, (%rdx,%r12,4)                          #70.5
-        movaps    %xmm3, 16(%rdx,%r12,4)                        #70.5
-        movaps    %xmm14, 32(%rdx,%r12,4)                       #70.5
-        movaps    %xmm4, 48(%rdx,%r12,4)                        #70.5
+        movups    %xmm10, 32(%rdx,%r11,4)                       #70.5
+        movups    %xmm11, 48(%rdx,%r11,4)                       #70.5
+        movups    %xmm2, (%rdx,%r12,4)                          #70.5
+        movups    %xmm3, 16(%rdx,%r12,4)                        #70.5
+        movups    %xmm14, 32(%rdx,%r12,4)                       #70.5
+        movups    %xmm4, 48(%rdx,%r12,4)                        #70.5
 	
 	
 #ifdef __APPLE__
@@ -470,7 +470,7 @@ _x_init:
 x_init:
 #endif
         #movaps    L_sse_constants(%rip), %xmm3           #34.3
-				movaps   (%r9), %xmm3           #34.3
+				movups   (%r9), %xmm3           #34.3
 				movq        0x20(%rdi),%r8
 #ifdef __APPLE__
 	.globl	_x4
@@ -479,13 +479,13 @@ _x4:
 	.globl	x4
 x4:
 #endif
-        movaps    64(%rdx), %xmm0                               #34.3
-        movaps    96(%rdx), %xmm1                               #34.3
-        movaps    (%rdx), %xmm7                                 #34.3
-        movaps    (%r8), %xmm4      #const
+        movups    64(%rdx), %xmm0                               #34.3
+        movups    96(%rdx), %xmm1                               #34.3
+        movups    (%rdx), %xmm7                                 #34.3
+        movups    (%r8), %xmm4      #const
         movaps    %xmm7, %xmm9                                  #34.3
         movaps    %xmm4, %xmm6                                  #34.3
-        movaps    16(%r8), %xmm2      #const
+        movups    16(%r8), %xmm2      #const
         mulps     %xmm0, %xmm6                                  #34.3
         mulps     %xmm1, %xmm4                                  #34.3
         shufps    $177, %xmm0, %xmm0                            #34.3
@@ -497,23 +497,23 @@ x4:
         movaps    %xmm6, %xmm5                                  #34.3
         subps     %xmm4, %xmm6                                  #34.3
         addps     %xmm4, %xmm5                                  #34.3
-        movaps    32(%rdx), %xmm8                               #34.3
+        movups    32(%rdx), %xmm8                               #34.3
         xorps     %xmm3, %xmm6                                  #34.3
         shufps    $177, %xmm6, %xmm6                            #34.3
         movaps    %xmm8, %xmm10                                 #34.3
-        movaps    112(%rdx), %xmm12                             #34.3
+        movups    112(%rdx), %xmm12                             #34.3
         subps     %xmm5, %xmm9                                  #34.3
         addps     %xmm5, %xmm7                                  #34.3
         addps     %xmm6, %xmm10                                 #34.3
         subps     %xmm6, %xmm8                                  #34.3
-        movaps    %xmm7, (%rdx)                                 #34.3
-        movaps    %xmm8, 32(%rdx)                               #34.3
-        movaps    %xmm9, 64(%rdx)                               #34.3
-        movaps    %xmm10, 96(%rdx)                              #34.3
-        movaps    32(%r8), %xmm14    #const                          #34.3
-        movaps    80(%rdx), %xmm11                              #34.3
+        movups    %xmm7, (%rdx)                                 #34.3
+        movups    %xmm8, 32(%rdx)                               #34.3
+        movups    %xmm9, 64(%rdx)                               #34.3
+        movups    %xmm10, 96(%rdx)                              #34.3
+        movups    32(%r8), %xmm14    #const                          #34.3
+        movups    80(%rdx), %xmm11                              #34.3
         movaps    %xmm14, %xmm0                                 #34.3
-        movaps    48(%r8), %xmm13    #const                          #34.3
+        movups    48(%r8), %xmm13    #const                          #34.3
         mulps     %xmm11, %xmm0                                 #34.3
         mulps     %xmm12, %xmm14                                #34.3
         shufps    $177, %xmm11, %xmm11                          #34.3
@@ -526,8 +526,8 @@ x4:
         subps     %xmm14, %xmm0                                 #34.3
         addps     %xmm14, %xmm15                                #34.3
         xorps     %xmm3, %xmm0                                  #34.3
-        movaps    16(%rdx), %xmm1                               #34.3
-        movaps    48(%rdx), %xmm2                               #34.3
+        movups    16(%rdx), %xmm1                               #34.3
+        movups    48(%rdx), %xmm2                               #34.3
         movaps    %xmm1, %xmm4                                  #34.3
         shufps    $177, %xmm0, %xmm0                            #34.3
         movaps    %xmm2, %xmm5                                  #34.3
@@ -535,10 +535,10 @@ x4:
         subps     %xmm0, %xmm2                                  #34.3
         subps     %xmm15, %xmm4                                 #34.3
         addps     %xmm0, %xmm5                                  #34.3
-        movaps    %xmm1, 16(%rdx)                               #34.3
-        movaps    %xmm2, 48(%rdx)                               #34.3
-        movaps    %xmm4, 80(%rdx)                               #34.3
-        movaps    %xmm5, 112(%rdx)                              #34.3
+        movups    %xmm1, 16(%rdx)                               #34.3
+        movups    %xmm2, 48(%rdx)                               #34.3
+        movups    %xmm4, 80(%rdx)                               #34.3
+        movups    %xmm5, 112(%rdx)                              #34.3
 				ret	
 	
 # _x8_soft + 5 needs to be 16 byte aligned
@@ -560,11 +560,11 @@ x8_soft:
         leaq       (%r13,%rcx,4), %r14
         leaq       (%r14,%rcx,4), %r15
 X8_soft_loop:   
-        movaps    (%rsi), %xmm9       
-        movaps    (%r10,%rax,4), %xmm6 
+        movups    (%rsi), %xmm9       
+        movups    (%r10,%rax,4), %xmm6 
         movaps    %xmm9, %xmm11        
-        movaps    (%r11,%rax,4), %xmm7 
-        movaps    16(%rsi), %xmm8      
+        movups    (%r11,%rax,4), %xmm7 
+        movups    16(%rsi), %xmm8      
         mulps     %xmm6, %xmm11      
         mulps     %xmm7, %xmm9       
         shufps    $177, %xmm6, %xmm6 
@@ -574,21 +574,21 @@ X8_soft_loop:
         mulps     %xmm7, %xmm8     
         movaps    %xmm11, %xmm10    
         addps     %xmm8, %xmm9       
-        movaps    32(%rsi), %xmm15    
+        movups    32(%rsi), %xmm15    
         addps     %xmm9, %xmm10        
         subps     %xmm9, %xmm11        
-        movaps    (%rbx,%rax,4), %xmm5 
+        movups    (%rbx,%rax,4), %xmm5 
         movaps    %xmm15, %xmm6        
-        movaps    (%r12,%rax,4), %xmm12
+        movups    (%r12,%rax,4), %xmm12
         movaps    %xmm5, %xmm2         
-        movaps    (%r14,%rax,4), %xmm13
+        movups    (%r14,%rax,4), %xmm13
         xorps     %xmm3, %xmm11     #const   
-        movaps    48(%rsi), %xmm14     
+        movups    48(%rsi), %xmm14     
         subps     %xmm10, %xmm2        
         mulps     %xmm12, %xmm6        
         addps     %xmm10, %xmm5        
         mulps     %xmm13, %xmm15       
-        movaps    64(%rsi), %xmm10     
+        movups    64(%rsi), %xmm10     
         movaps    %xmm5, %xmm0         
         shufps    $177, %xmm12, %xmm12 
         shufps    $177, %xmm13, %xmm13 
@@ -596,11 +596,11 @@ X8_soft_loop:
         mulps     %xmm13, %xmm14       
         subps     %xmm12, %xmm6        
         addps     %xmm14, %xmm15       
-        movaps    (%r13,%rax,4), %xmm7  
+        movups    (%r13,%rax,4), %xmm7  
         movaps    %xmm10, %xmm13         
-        movaps    (%r15,%rax,4), %xmm8    
+        movups    (%r15,%rax,4), %xmm8    
         movaps    %xmm6, %xmm12      
-        movaps    80(%rsi), %xmm9     
+        movups    80(%rsi), %xmm9     
         addq      $96, %rsi           
         mulps     %xmm7, %xmm13      
         subps     %xmm15, %xmm6      
@@ -616,7 +616,7 @@ X8_soft_loop:
         mulps     %xmm8, %xmm9          
         subps     %xmm7, %xmm13        
         addps     %xmm9, %xmm10       
-        movaps    (%r9,%rax,4), %xmm4        
+        movups    (%r9,%rax,4), %xmm4        
         shufps    $177, %xmm11, %xmm11       
         movaps    %xmm4, %xmm1              
         shufps    $177, %xmm6, %xmm6       
@@ -633,16 +633,16 @@ X8_soft_loop:
         addps     %xmm11, %xmm4                                 
         subps     %xmm11, %xmm14                                
         shufps    $177, %xmm13, %xmm13                          
-        movaps    %xmm5, (%rbx,%rax,4)                                 
-        movaps    %xmm4, (%r9,%rax,4)                                  
-        movaps    %xmm2, (%r10,%rax,4)                                 
+        movups    %xmm5, (%rbx,%rax,4)                                 
+        movups    %xmm4, (%r9,%rax,4)                                  
+        movups    %xmm2, (%r10,%rax,4)                                 
         subps     %xmm13, %xmm1                                 
         addps     %xmm13, %xmm6                                 
-        movaps    %xmm1, (%r11,%rax,4)                                  
-        movaps    %xmm0, (%r12,%rax,4)                                 
-        movaps    %xmm14, (%r13,%rax,4)                                
-        movaps    %xmm12, (%r14,%rax,4)                                
-        movaps    %xmm6, (%r15,%rax,4)                                 
+        movups    %xmm1, (%r11,%rax,4)                                  
+        movups    %xmm0, (%r12,%rax,4)                                 
+        movups    %xmm14, (%r13,%rax,4)                                
+        movups    %xmm12, (%r14,%rax,4)                                
+        movups    %xmm6, (%r15,%rax,4)                                 
         addq      $4, %rax   
 				cmpq	%rcx, %rax
         jne       X8_soft_loop
@@ -655,15 +655,15 @@ _x8_hard:
 	.globl	x8_hard
 x8_hard:
 #endif
-        movaps    (%r9), %xmm5           
+        movups    (%r9), %xmm5           
 X8_loop:  
-        movaps    (%r8), %xmm9                                 
+        movups    (%r8), %xmm9                                 
 X8_const_2:
-        movaps    0xFECA(%rdx,%rax,4), %xmm6  
+        movups    0xFECA(%rdx,%rax,4), %xmm6  
         movaps    %xmm9, %xmm11                                 
 X8_const_3:
-        movaps    0xFECA(%rdx,%rax,4), %xmm7  
-        movaps    16(%r8), %xmm8                               
+        movups    0xFECA(%rdx,%rax,4), %xmm7  
+        movups    16(%r8), %xmm8                               
         mulps     %xmm6, %xmm11                                 
         mulps     %xmm7, %xmm9                                  
         shufps    $177, %xmm6, %xmm6                            
@@ -673,24 +673,24 @@ X8_const_3:
         mulps     %xmm7, %xmm8                                  
         movaps    %xmm11, %xmm10                                
         addps     %xmm8, %xmm9                                  
-        movaps    32(%r8), %xmm15                              
+        movups    32(%r8), %xmm15                              
         addps     %xmm9, %xmm10                                 
         subps     %xmm9, %xmm11                                 
 X8_const_0:
-        movaps    0xFECA(%rdx,%rax,4), %xmm3     
+        movups    0xFECA(%rdx,%rax,4), %xmm3     
         movaps    %xmm15, %xmm6                                 
 X8_const_4:
-        movaps    0xFECA(%rdx,%rax,4), %xmm12
+        movups    0xFECA(%rdx,%rax,4), %xmm12
         movaps    %xmm3, %xmm2                                  
 X8_const_6:
-        movaps    0xFECA(%rdx,%rax,4), %xmm13
+        movups    0xFECA(%rdx,%rax,4), %xmm13
         xorps     %xmm5, %xmm11                                 
-        movaps    48(%r8), %xmm14                              
+        movups    48(%r8), %xmm14                              
         subps     %xmm10, %xmm2                                 
         mulps     %xmm12, %xmm6                                 
         addps     %xmm10, %xmm3                                 
         mulps     %xmm13, %xmm15                                
-        movaps    64(%r8), %xmm10                              
+        movups    64(%r8), %xmm10                              
         movaps    %xmm3, %xmm0                                  
         shufps    $177, %xmm12, %xmm12                          
         shufps    $177, %xmm13, %xmm13                          
@@ -699,12 +699,12 @@ X8_const_6:
         subps     %xmm12, %xmm6                                 
         addps     %xmm14, %xmm15                                
 X8_const_5:
-        movaps    0xFECA(%rdx,%rax,4), %xmm7
+        movups    0xFECA(%rdx,%rax,4), %xmm7
         movaps    %xmm10, %xmm13                                
 X8_const_7:
-        movaps    0xFECA(%rdx,%rax,4), %xmm8
+        movups    0xFECA(%rdx,%rax,4), %xmm8
         movaps    %xmm6, %xmm12                                 
-        movaps    80(%r8), %xmm9                               
+        movups    80(%r8), %xmm9                               
         addq      $96, %r8                                     
         mulps     %xmm7, %xmm13                                 
         subps     %xmm15, %xmm6                                 
@@ -721,7 +721,7 @@ X8_const_7:
         subps     %xmm7, %xmm13                                 
         addps     %xmm9, %xmm10                                 
 X8_const_1:
-        movaps    0xFECA(%rdx,%rax,4), %xmm4   
+        movups    0xFECA(%rdx,%rax,4), %xmm4   
         shufps    $177, %xmm11, %xmm11                          
         movaps    %xmm4, %xmm1                                  
         shufps    $177, %xmm6, %xmm6                            
@@ -739,23 +739,23 @@ X8_const_1:
         subps     %xmm11, %xmm14                                
         shufps    $177, %xmm13, %xmm13                          
 X8_const1_0:
-        movaps    %xmm3, 0xFECA(%rdx,%rax,4)
+        movups    %xmm3, 0xFECA(%rdx,%rax,4)
 X8_const1_1:
-        movaps    %xmm4, 0xFECA(%rdx,%rax,4)
+        movups    %xmm4, 0xFECA(%rdx,%rax,4)
 X8_const1_2:
-        movaps    %xmm2, 0xFECA(%rdx,%rax,4) 
+        movups    %xmm2, 0xFECA(%rdx,%rax,4) 
         subps     %xmm13, %xmm1                                 
         addps     %xmm13, %xmm6                                 
 X8_const1_3:
-        movaps    %xmm1, 0xFECA(%rdx,%rax,4) 
+        movups    %xmm1, 0xFECA(%rdx,%rax,4) 
 X8_const1_4:
-        movaps    %xmm0, 0xFECA(%rdx,%rax,4)
+        movups    %xmm0, 0xFECA(%rdx,%rax,4)
 X8_const1_5:
-        movaps    %xmm14, 0xFECA(%rdx,%rax,4)
+        movups    %xmm14, 0xFECA(%rdx,%rax,4)
 X8_const1_6:
-        movaps    %xmm12, 0xFECA(%rdx,%rax,4) 
+        movups    %xmm12, 0xFECA(%rdx,%rax,4) 
 X8_const1_7:
-        movaps    %xmm6, 0xFECA(%rdx,%rax,4)
+        movups    %xmm6, 0xFECA(%rdx,%rax,4)
         addq      $4, %rax   
 				cmpq	%rcx, %rax
         jne       X8_loop
@@ -876,3 +876,6 @@ sse_constants_inv:
 	.long	0x3f3504f3,0xbf3504f3,0x3f3504f3,0xbf3504f3
 	.long	0x3f800000,0x3f800000,0x3f3504f3,0x3f3504f3
 	.long	0x00000000,0x00000000,0x3f3504f3,0xbf3504f3
+
+# the code needs no executable stack
+	.section .note.GNU-stack,"",@progbits
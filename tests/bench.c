@@ -0,0 +1,252 @@
+/*
+ 
+ This file is part of SFFT.
+  
+ Copyright (c) 2012, Anthony M. Blake
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ 	* Redistributions of source code must retain the above copyright
+ 		notice, this list of conditions and the following disclaimer.
+ 	* Redistributions in binary form must reproduce the above copyright
+ 		notice, this list of conditions and the following disclaimer in the
+ 		documentation and/or other materials provided with the distribution.
+ 	* Neither the name of the organization nor the
+	  names of its contributors may be used to endorse or promote products
+ 		derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/*
+ * Throughput benchmark. For every transform a plan is created (and timed),
+ * run a few times to warm up, and then timed in samples of enough iterations
+ * to last about a millisecond each. Results are printed one line per
+ * transform as CSV (the default) or JSON.
+ *
+ *   ffts_bench [-f csv|json] [-s samples] [-m max_log2] [-k kinds]
+ *
+ * kinds is a comma separated subset of c1d,r1d,c2d,cnd. GFLOPS use the usual
+ * 5 N log2(N) flop count for complex transforms (N the total number of
+ * points), and half that for real transforms.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "../include/ffts.h"
+
+#define KIND_C1D 1
+#define KIND_R1D 2
+#define KIND_C2D 4
+#define KIND_CND 8
+
+static int json = 0;
+static int nsamples = 31;
+static int max_log2 = 20;
+static int first = 1;
+
+static double now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static void report(const char *kind, int sign, const char *shape, size_t n,
+                   int isa, double plan_ns, double median, double p99, double flops) {
+	double gflops = flops / median;
+
+	if(json) {
+		printf("%s  {\"kind\": \"%s\", \"sign\": %d, \"shape\": \"%s\", \"n\": %zu, "
+		       "\"isa\": \"%s\", \"plan_us\": %.2f, \"median_ns\": %.1f, "
+		       "\"p99_ns\": %.1f, \"gflops\": %.3f}",
+		       first ? "[\n" : ",\n", kind, sign, shape, n, ffts_isa_name(isa),
+		       plan_ns / 1e3, median, p99, gflops);
+	}else{
+		if(first) printf("kind,sign,shape,n,isa,plan_us,median_ns,p99_ns,gflops\n");
+		printf("%s,%d,%s,%zu,%s,%.2f,%.1f,%.1f,%.3f\n", kind, sign, shape, n,
+		       ffts_isa_name(isa), plan_ns / 1e3, median, p99, gflops);
+	}
+	first = 0;
+	fflush(stdout);
+}
+
+/*
+ * Times an existing plan. in and out hold at least in_floats and out_floats
+ * floats; the input is refreshed from src before every sample since some
+ * plans (c2r) are allowed to overwrite it.
+ */
+static void bench_plan(const char *kind, int sign, const char *shape, size_t n,
+                       double flops, ffts_plan_t *p, double plan_ns,
+                       float *in, float *out, const float *src, size_t in_floats) {
+	double *samples = malloc(sizeof(double) * nsamples);
+	size_t iters = 1, i;
+	int s;
+
+	// warm up, and find how many iterations make a sample of ~1ms
+	memcpy(in, src, sizeof(float) * in_floats);
+	ffts_execute(p, in, out);
+	for(;;) {
+		double t0 = now_ns();
+		for(i=0;i<iters;i++) ffts_execute(p, in, out);
+		double t = now_ns() - t0;
+		if(t > 1e6 || iters >= ((size_t)1 << 24)) break;
+		iters *= 2;
+	}
+
+	for(s=0;s<nsamples;s++) {
+		memcpy(in, src, sizeof(float) * in_floats);
+		double t0 = now_ns();
+		for(i=0;i<iters;i++) ffts_execute(p, in, out);
+		samples[s] = (now_ns() - t0) / iters;
+	}
+
+	qsort(samples, nsamples, sizeof(double), cmp_double);
+	size_t p99 = (size_t)ceil(0.99 * nsamples) - 1;
+	report(kind, sign, shape, n, ffts_plan_isa(p), plan_ns,
+	       samples[nsamples / 2], samples[p99], flops);
+
+	free(samples);
+}
+
+static float *alloc_floats(size_t n) {
+	float *f = valloc(sizeof(float) * n);
+	size_t i;
+	for(i=0;i<n;i++) f[i] = (float)(rand() % 2001 - 1000) / 1000.0f;
+	return f;
+}
+
+static void bench_nd(const char *kind, int sign, int rank, size_t *Ns, int real) {
+	char shape[128];
+	size_t n = 1, in_floats, out_floats;
+	int i, len = 0;
+	ffts_plan_t *p;
+
+	for(i=0;i<rank;i++) {
+		n *= Ns[i];
+		len += snprintf(shape + len, sizeof(shape) - len, i ? "x%zu" : "%zu", Ns[i]);
+	}
+
+	// real transforms read N reals and write N/2+1 complex values (or the
+	// other way round for c2r)
+	if(real) {
+		in_floats  = (sign < 0) ? n : n + 2;
+		out_floats = (sign < 0) ? n + 2 : n;
+	}else{
+		in_floats = out_floats = 2 * n;
+	}
+
+	float *src = alloc_floats(in_floats);
+	float *in = alloc_floats(in_floats);
+	float *out = alloc_floats(out_floats);
+
+	double t0 = now_ns();
+	if(real) p = ffts_init_1d_real(n, sign);
+	else if(rank == 1) p = ffts_init_1d(n, sign);
+	else p = ffts_init_nd(rank, Ns, sign);
+	double plan_ns = now_ns() - t0;
+
+	if(p) {
+		double flops = 5.0 * n * log2((double)n);
+		if(real) flops *= 0.5;
+		bench_plan(kind, sign, shape, n, flops, p, plan_ns, in, out, src, in_floats);
+		ffts_free(p);
+	}else{
+		fprintf(stderr, "%s %s: plan unsupported\n", kind, shape);
+	}
+
+	free(src);
+	free(in);
+	free(out);
+}
+
+static int parse_kinds(const char *s) {
+	int kinds = 0;
+	char *copy = strdup(s), *tok;
+	for(tok=strtok(copy, ",");tok;tok=strtok(NULL, ",")) {
+		if(!strcmp(tok, "c1d")) kinds |= KIND_C1D;
+		else if(!strcmp(tok, "r1d")) kinds |= KIND_R1D;
+		else if(!strcmp(tok, "c2d")) kinds |= KIND_C2D;
+		else if(!strcmp(tok, "cnd")) kinds |= KIND_CND;
+		else fprintf(stderr, "unknown kind '%s'\n", tok);
+	}
+	free(copy);
+	return kinds;
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "usage: %s [-f csv|json] [-s samples] [-m max_log2] [-k c1d,r1d,c2d,cnd]\n", name);
+	exit(1);
+}
+
+int
+main(int argc, char *argv[]) {
+	int kinds = KIND_C1D | KIND_R1D | KIND_C2D | KIND_CND;
+	int i, l, sign;
+
+	for(i=1;i<argc;i++) {
+		if(i + 1 >= argc) usage(argv[0]);
+		if(!strcmp(argv[i], "-f")) {
+			json = !strcmp(argv[++i], "json");
+		}else if(!strcmp(argv[i], "-s")) {
+			nsamples = atoi(argv[++i]);
+		}else if(!strcmp(argv[i], "-m")) {
+			max_log2 = atoi(argv[++i]);
+		}else if(!strcmp(argv[i], "-k")) {
+			kinds = parse_kinds(argv[++i]);
+		}else{
+			usage(argv[0]);
+		}
+	}
+	if(nsamples < 1) nsamples = 1;
+
+	for(sign=-1;sign<=1;sign+=2) {
+		if(kinds & KIND_C1D) {
+			for(l=2;l<=max_log2;l++) {
+				size_t Ns[1] = { (size_t)1 << l };
+				bench_nd("c1d", sign, 1, Ns, 0);
+			}
+		}
+		if(kinds & KIND_R1D) {
+			for(l=3;l<=max_log2;l++) {
+				size_t Ns[1] = { (size_t)1 << l };
+				bench_nd("r1d", sign, 1, Ns, 1);
+			}
+		}
+		if(kinds & KIND_C2D) {
+			for(l=2;2*l<=max_log2;l++) {
+				size_t Ns[2] = { (size_t)1 << l, (size_t)1 << l };
+				bench_nd("c2d", sign, 2, Ns, 0);
+			}
+		}
+		if(kinds & KIND_CND) {
+			for(l=2;3*l<=max_log2;l++) {
+				size_t Ns[3] = { (size_t)1 << l, (size_t)1 << l, (size_t)1 << l };
+				bench_nd("cnd", sign, 3, Ns, 0);
+			}
+		}
+	}
+
+	if(json && !first) printf("\n]\n");
+	return 0;
+}
+// vim: set autoindent noexpandtab tabstop=3 shiftwidth=3:
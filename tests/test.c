@@ -30,7 +30,11 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #ifdef __ARM_NEON__
 #endif
@@ -119,6 +123,933 @@ test_transform(int n, int sign) {
 	return 1;
 }
 
+// largest difference between x and y, relative to the largest element of y
+float max_error(size_t n, const float *x, const float *y) {
+	float d = 0.0f, m = 0.0f;
+	size_t i;
+	for(i=0;i<n;i++) {
+		if(fabsf(x[i] - y[i]) > d) d = fabsf(x[i] - y[i]);
+		if(fabsf(y[i]) > m) m = fabsf(y[i]);
+	}
+	return m > 0.0f ? d / m : d;
+}
+
+// an istride, idist pair for layout 0 (rows), 1 (columns) or 2 (neither)
+void batch_layout(int layout, size_t n, size_t howmany, size_t *stride, size_t *dist) {
+	if(layout == 0) { *stride = 1;       *dist = n; }
+	if(layout == 1) { *stride = howmany; *dist = 1; }
+	if(layout == 2) { *stride = 3;       *dist = 3*n + 1; }
+}
+
+/*
+ * A batched plan against the single plan run on each transform, for every
+ * pair of input and output layouts. Returns the number of failures.
+ */
+int
+test_batch(int n, int sign, int howmany) {
+	const char *names[3] = { "rows", "cols", "strided" };
+	ffts_plan_t *s = ffts_init_1d(n, sign);
+	int li, lo, k, j, fails = 0;
+
+	float *x = valloc(2 * n * sizeof(float));
+	float *y = valloc(2 * n * sizeof(float));
+
+	for(li=0;li<3;li++) {
+		for(lo=0;lo<3;lo++) {
+			size_t is, id, os, od;
+			batch_layout(li, n, howmany, &is, &id);
+			batch_layout(lo, n, howmany, &os, &od);
+
+			size_t isize = 2 * (id*(howmany - 1) + is*(n - 1) + 1);
+			size_t osize = 2 * (od*(howmany - 1) + os*(n - 1) + 1);
+			float *input = valloc(isize * sizeof(float));
+			float *output = valloc(osize * sizeof(float));
+			float *expect = valloc(2 * n * howmany * sizeof(float));
+			for(j=0;j<isize;j++) input[j] = (float)((j * 7919) % 1024) / 512.0f - 1.0f;
+
+			for(k=0;k<howmany;k++) {
+				for(j=0;j<n;j++) {
+					x[2*j]   = input[2*(k*id + j*is)];
+					x[2*j+1] = input[2*(k*id + j*is) + 1];
+				}
+				ffts_execute(s, x, expect + 2*n*k);
+			}
+
+			ffts_plan_t *p = ffts_init_1d_batch(n, sign, howmany, is, id, os, od);
+			float err = 1.0f;
+			if(p) {
+				ffts_execute(p, input, output);
+				err = 0.0f;
+				for(k=0;k<howmany;k++) {
+					for(j=0;j<n;j++) {
+						y[2*j]   = output[2*(k*od + j*os)];
+						y[2*j+1] = output[2*(k*od + j*os) + 1];
+					}
+					float e = max_error(2*n, y, expect + 2*n*k);
+					if(e > err) err = e;
+				}
+				ffts_free(p);
+			}
+			if(err > 1e-5f) {
+				printf(" %3d  | %9d | batch of %d, %s to %s: %E\n", sign, n, howmany,
+				       names[li], names[lo], err);
+				fails++;
+			}
+			free(input);
+			free(output);
+			free(expect);
+		}
+	}
+
+	free(x);
+	free(y);
+	ffts_free(s);
+	return fails;
+}
+
+/*
+ * A streaming filter, fed in uneven pieces, against the direct convolution
+ * delayed by the block size. Returns the number of failures.
+ */
+int
+test_conv(int ntaps, int block) {
+	int len = 4 * (ntaps + block) + 7, off, n, t, k;
+	float *h = malloc(ntaps * sizeof(float));
+	float *x = malloc(len * sizeof(float));
+	float *y = malloc(len * sizeof(float));
+	float *expect = calloc(len, sizeof(float));
+	float err = 1.0f;
+
+	for(k=0;k<ntaps;k++) h[k] = (float)((k * 4001) % 1024) / 512.0f - 1.0f;
+	for(t=0;t<len;t++) x[t] = (float)((t * 7919) % 1024) / 512.0f - 1.0f;
+	for(t=block;t<len;t++) {
+		double s = 0.0;
+		for(k=0;k<ntaps && k<=t-block;k++) s += h[k] * x[t-block-k];
+		expect[t] = s;
+	}
+
+	ffts_plan_t *p = ffts_init_conv(h, ntaps, block);
+	if(p) {
+		memcpy(y, x, len * sizeof(float));
+		for(off=0,n=1;off<len;off+=n,n=(n*5+3)%(3*block)+1) {
+			if(n > len - off) n = len - off;
+			ffts_execute_conv(p, y + off, y + off, n);
+		}
+		err = max_error(len, y, expect);
+		ffts_free(p);
+	}
+	if(err > 1e-5f) printf("      | %9d | filter of %d taps: %E\n", block, ntaps, err);
+
+	free(h);
+	free(x);
+	free(y);
+	free(expect);
+	return err > 1e-5f;
+}
+
+/*
+ * STFT analysis followed by synthesis gives back the input after the first
+ * N samples. Returns the number of failures.
+ */
+int
+test_stft(int n, int hop) {
+	int len = 8 * n + 5, nframes = 0, off, t;
+	float *x = malloc(len * sizeof(float));
+	float *y = malloc((len + n) * sizeof(float));
+	float *w = malloc(n * sizeof(float));
+	float *frames = valloc((n + 4) * (len / hop + 1) * sizeof(float));
+	float err = 1.0f;
+
+	for(t=0;t<n;t++) w[t] = 0.5f - 0.5f * cos(2 * PI * (t + 0.5) / n);
+	for(t=0;t<len;t++) x[t] = (float)((t * 7919) % 1024) / 512.0f - 1.0f;
+
+	ffts_plan_t *a = ffts_init_stft(n, hop, w, -1);
+	ffts_plan_t *s = ffts_init_stft(n, hop, w, 1);
+	if(a && s) {
+		for(off=0;off<len;off+=hop+3) {
+			int m = (len - off < hop + 3) ? len - off : hop + 3;
+			nframes += ffts_execute_stft(a, x + off, m, frames + nframes * (n + 4));
+		}
+		int ny = ffts_execute_istft(s, frames, nframes, y);
+		err = (ny == nframes * hop) ? max_error(ny - n, y + n, x + n) : 1.0f;
+	}
+	if(err > 1e-4f) printf("      | %9d | STFT hop %d round trip: %E\n", n, hop, err);
+
+	if(a) ffts_free(a);
+	if(s) ffts_free(s);
+	free(x);
+	free(y);
+	free(w);
+	free(frames);
+	return err > 1e-4f;
+}
+
+/*
+ * A plan saved with ffts_export_plan and loaded again must give the same
+ * output, bit for bit. Returns the number of failures.
+ */
+int
+test_wisdom(int n, int sign) {
+	char path[64];
+	float *input = valloc(2 * n * sizeof(float));
+	float *a = valloc(2 * n * sizeof(float));
+	float *b = valloc(2 * n * sizeof(float));
+	int i, fails = 0;
+
+	snprintf(path, sizeof(path), "/tmp/ffts_test_%d.wisdom", (int)getpid());
+	for(i=0;i<2*n;i++) input[i] = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+
+	ffts_plan_t *p = ffts_init_1d(n, sign);
+	ffts_plan_t *q = NULL;
+	if(p && !ffts_export_plan(p, path)) q = ffts_import_plan(path);
+	if(!p || !q) {
+		printf(" %3d  | %9d | wisdom export/import failed\n", sign, n);
+		fails++;
+	}else{
+		ffts_execute(p, input, a);
+		ffts_execute(q, input, b);
+		if(memcmp(a, b, 2 * n * sizeof(float))) {
+			printf(" %3d  | %9d | imported plan differs: %E\n", sign, n, max_error(2*n, b, a));
+			fails++;
+		}
+	}
+	if(p) ffts_free(p);
+	if(q) ffts_free(q);
+	remove(path);
+
+	free(input);
+	free(a);
+	free(b);
+	return fails;
+}
+
+/*
+ * ffts_execute_scratch must match ffts_execute, and leave the plan usable.
+ * The plans given all need working memory, so a scratch size of 0 would
+ * mean the scratch path isn't being tested. Returns the number of failures.
+ */
+int
+test_scratch(ffts_plan_t *p, size_t n, const char *name) {
+	float *input, *a, *b;
+	void *scratch;
+	size_t i;
+	int fails = 0;
+
+	if(!p || !ffts_scratch_size(p)) {
+		printf("      | %9zu | %s: %s\n", n, name, p ? "no scratch needed" : "plan failed");
+		if(p) ffts_free(p);
+		return 1;
+	}
+	input = valloc(2 * n * sizeof(float));
+	a = valloc(2 * n * sizeof(float));
+	b = valloc(2 * n * sizeof(float));
+	scratch = valloc(ffts_scratch_size(p) + 1);
+	for(i=0;i<2*n;i++) input[i] = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+	ffts_execute(p, input, a);
+	ffts_execute_scratch(p, input, b, scratch);
+	if(memcmp(a, b, 2 * n * sizeof(float))) {
+		printf("      | %9zu | %s: scratch execute differs: %E\n", n, name, max_error(2*n, b, a));
+		fails++;
+	}
+
+	free(scratch);
+	free(input);
+	free(a);
+	free(b);
+	ffts_free(p);
+	return fails;
+}
+
+/*
+ * A plan laid out in an arena must give the same output as one that isn't.
+ * Returns the number of failures.
+ */
+int
+test_arena(int n, int sign) {
+	float *input = valloc(2 * n * sizeof(float));
+	float *a = valloc(2 * n * sizeof(float));
+	float *b = valloc(2 * n * sizeof(float));
+	int i, fails = 0;
+
+	for(i=0;i<2*n;i++) input[i] = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+
+	ffts_plan_t *p = ffts_init_1d(n, sign);
+	ffts_plan_arena_enable(FFTS_ARENA_ON);
+	ffts_plan_t *q = ffts_init_1d(n, sign);
+	ffts_plan_arena_enable(0);
+	if(!p || !q) {
+		printf(" %3d  | %9d | arena plan failed\n", sign, n);
+		fails++;
+	}else{
+		ffts_execute(p, input, a);
+		ffts_execute(q, input, b);
+		if(memcmp(a, b, 2 * n * sizeof(float))) {
+			printf(" %3d  | %9d | arena plan differs: %E\n", sign, n, max_error(2*n, b, a));
+			fails++;
+		}
+	}
+	if(p) ffts_free(p);
+	if(q) ffts_free(q);
+
+	free(input);
+	free(a);
+	free(b);
+	return fails;
+}
+
+// the DCT-II/III or DST-II/III of n reals x[i*xs] into y[i*ys], by definition
+void dct_reference(int dst, int sign, size_t n, const double *x, size_t xs, double *y, size_t ys) {
+	size_t j, k;
+	for(k=0;k<n;k++) {
+		double s = 0.0;
+		for(j=0;j<n;j++) {
+			if(sign < 0 && !dst) s += 2 * x[j*xs] * cos(PI * (2*j + 1) * k / (2.0 * n));
+			if(sign < 0 && dst)  s += 2 * x[j*xs] * sin(PI * (2*j + 1) * (k + 1) / (2.0 * n));
+			if(sign > 0 && !dst) s += j ? 2 * x[j*xs] * cos(PI * (2*k + 1) * j / (2.0 * n)) : x[0];
+			if(sign > 0 && dst)  s += (j < n - 1) ? 2 * x[j*xs] * sin(PI * (2*k + 1) * (j + 1) / (2.0 * n))
+			                                      : ((k & 1) ? -x[j*xs] : x[j*xs]);
+		}
+		y[k*ys] = s;
+	}
+}
+
+/*
+ * DCT and DST plans against the definitions: kind 0 and 1 are the 1D DCT
+ * and DST of N2 reals, kind 2 the 2D DCT of N1 x N2 and kind 3 nblocks
+ * B x B blocks with B = N1 = N2. Returns the number of failures.
+ */
+int
+test_dct(int kind, int sign, size_t N1, size_t N2, size_t nblocks) {
+	const char *names[4] = { "DCT", "DST", "2D DCT", "block DCT" };
+	size_t n = N1 * N2 * nblocks, i, j, b;
+	float *input = valloc(n * sizeof(float));
+	float *output = valloc(n * sizeof(float));
+	float *expect = malloc(n * sizeof(float));
+	double *x = malloc(n * sizeof(double));
+	double *t = malloc(n * sizeof(double));
+	double *y = malloc(n * sizeof(double));
+	float err = 1.0f;
+
+	for(i=0;i<n;i++) x[i] = input[i] = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+	for(b=0;b<nblocks;b++) {
+		size_t o = b * N1 * N2;
+		for(i=0;i<N1;i++) dct_reference(kind == 1, sign, N2, x + o + i*N2, 1, t + o + i*N2, 1);
+		if(N1 == 1) memcpy(y + o, t + o, N2 * sizeof(double));
+		else for(j=0;j<N2;j++) dct_reference(0, sign, N1, t + o + j, N2, y + o + j, N2);
+	}
+	for(i=0;i<n;i++) expect[i] = y[i];
+
+	ffts_plan_t *p = (kind == 0) ? ffts_init_1d_dct(N2, sign) :
+	                 (kind == 1) ? ffts_init_1d_dst(N2, sign) :
+	                 (kind == 2) ? ffts_init_2d_dct(N1, N2, sign) :
+	                               ffts_init_2d_dct_blocks(N1, sign, nblocks);
+	if(p) {
+		ffts_execute(p, input, output);
+		err = max_error(n, output, expect);
+		ffts_free(p);
+	}
+	if(err > 1e-5f) {
+		printf(" %3d  | %4zux%-4zu | %s: %E\n", sign, N1, N2, names[kind], err);
+	}
+
+	free(input);
+	free(output);
+	free(expect);
+	free(x);
+	free(t);
+	free(y);
+	return err > 1e-5f;
+}
+
+/*
+ * Plans built on both sides of a fork. Generated code lives in pages that
+ * stay shared with the child, so each side must allocate its own. The
+ * child builds a plan of size n, the parent then builds one of size 4n,
+ * and the child runs its plan. Returns the number of failures.
+ */
+int
+test_fork(int n, int sign) {
+	float *input = valloc(8 * n * sizeof(float));
+	float *a = valloc(2 * n * sizeof(float));
+	float *b = valloc(8 * n * sizeof(float));
+	float *c = valloc(8 * n * sizeof(float));
+	int i, status = -1, fails = 0, ready[2], done[2];
+	char x;
+
+	for(i=0;i<8*n;i++) input[i] = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+
+	// the outputs to expect, from plans built before forking
+	ffts_plan_t *p = ffts_init_1d(n, sign);
+	ffts_plan_t *q = ffts_init_1d(4*n, sign);
+	ffts_execute(p, input, a);
+	ffts_execute(q, input, b);
+	ffts_free(p);
+	ffts_free(q);
+
+	if(pipe(ready) || pipe(done)) return 1;
+	pid_t pid = fork();
+	if(!pid) {
+		p = ffts_init_1d(n, sign);
+		if(write(ready[1], &x, 1) != 1 || read(done[0], &x, 1) != 1) _exit(2);
+		ffts_execute(p, input, c);
+		_exit(memcmp(a, c, 2 * n * sizeof(float)) != 0);
+	}
+	if(pid > 0 && read(ready[0], &x, 1) == 1) {
+		q = ffts_init_1d(4*n, sign);
+		if(write(done[1], &x, 1) == 1) waitpid(pid, &status, 0);
+		ffts_execute(q, input, c);
+		if(memcmp(b, c, 8 * n * sizeof(float))) status = -1;
+		ffts_free(q);
+	}
+	if(!WIFEXITED(status) || WEXITSTATUS(status)) {
+		printf(" %3d  | %9d | plans built either side of a fork differ\n", sign, n);
+		fails++;
+	}
+	close(ready[0]);
+	close(ready[1]);
+	close(done[0]);
+	close(done[1]);
+
+	free(input);
+	free(a);
+	free(b);
+	free(c);
+	return fails;
+}
+
+// the DFT of n complex values x[i*xs], by definition, into y
+void dft_reference(size_t n, int sign, const float *x, size_t xs, double *y) {
+	double *w = malloc(2 * n * sizeof(double));
+	size_t j, k;
+	for(k=0;k<n;k++) {
+		w[2*k]   = cos(2.0 * PI * (double)k / (double)n);
+		w[2*k+1] = sign * sin(2.0 * PI * (double)k / (double)n);
+	}
+	for(k=0;k<n;k++) {
+		double re = 0.0, im = 0.0;
+		for(j=0;j<n;j++) {
+			const double *a = w + 2 * ((j * k) % n);
+			re += x[2*j*xs] * a[0] - x[2*j*xs+1] * a[1];
+			im += x[2*j*xs] * a[1] + x[2*j*xs+1] * a[0];
+		}
+		y[2*k]   = re;
+		y[2*k+1] = im;
+	}
+	free(w);
+}
+
+// largest difference between x and y, relative to the largest element of y
+float max_error_d(size_t n, const float *x, const double *y) {
+	double d = 0.0, m = 0.0;
+	size_t i;
+	for(i=0;i<n;i++) {
+		if(fabs(x[i] - y[i]) > d) d = fabs(x[i] - y[i]);
+		if(fabs(y[i]) > m) m = fabs(y[i]);
+	}
+	return m > 0.0 ? d / m : d;
+}
+
+/*
+ * Split format plans against the DFT. ffts_execute must refuse them and
+ * leave the output alone. Returns the number of failures.
+ */
+int
+test_split(int n, int sign) {
+	float *x = valloc(2 * n * sizeof(float));
+	float *re = malloc(n * sizeof(float)), *im = malloc(n * sizeof(float));
+	float *ore = malloc(n * sizeof(float)), *oim = malloc(n * sizeof(float));
+	double *y = malloc(2 * n * sizeof(double));
+	float err = 1.0f;
+	int i;
+
+	for(i=0;i<2*n;i++) x[i] = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+	for(i=0;i<n;i++) {
+		re[i] = x[2*i];
+		im[i] = x[2*i+1];
+	}
+	dft_reference(n, sign, x, 1, y);
+
+	ffts_plan_t *p = ffts_init_1d_split(n, sign);
+	if(p) {
+		ffts_execute_split(p, re, im, ore, oim);
+		for(i=0;i<n;i++) {
+			x[2*i]   = ore[i];
+			x[2*i+1] = oim[i];
+		}
+		err = max_error_d(2*n, x, y);
+
+		// the output is untouched by ffts_execute (checked once; it logs)
+		if(n == 4 && sign < 0) {
+			memcpy(ore, re, n * sizeof(float));
+			ffts_execute(p, re, ore);
+			if(memcmp(ore, re, n * sizeof(float))) err = 1.0f;
+		}
+		ffts_free(p);
+	}
+	if(err > 1e-5f) {
+		printf(" %3d  | %9d | split: %E\n", sign, n, err);
+	}
+
+	free(x);
+	free(re);
+	free(im);
+	free(ore);
+	free(oim);
+	free(y);
+	return err > 1e-5f;
+}
+
+/*
+ * Pruned plans against the DFT of the zero-padded input, through both
+ * ffts_execute and ffts_execute_scratch on dirty scratch, which the plan
+ * must clear itself. real selects ffts_init_1d_real_pruned, with nout
+ * N/2+1. Returns the number of failures.
+ */
+int
+test_pruned(int n, int sign, int nin, int nout, int real) {
+	float *input = valloc(2 * n * sizeof(float));
+	float *x = valloc(2 * n * sizeof(float));
+	float *output = valloc(2 * n * sizeof(float));
+	double *y = malloc(2 * n * sizeof(double));
+	float err = 1.0f;
+	int i;
+
+	memset(x, 0, 2 * n * sizeof(float));
+	for(i=0;i<2*n;i++) input[i] = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+	for(i=0;i<(nin ? nin : n);i++) {
+		x[2*i]   = real ? input[i] : input[2*i];
+		x[2*i+1] = real ? 0.0f : input[2*i+1];
+	}
+	dft_reference(n, sign, x, 1, y);
+
+	ffts_plan_t *p = real ? ffts_init_1d_real_pruned(n, nin) : ffts_init_1d_pruned(n, sign, nin, nout);
+	if(real || !nout) nout = real ? n/2 + 1 : n;
+	if(p) {
+		size_t ssize = ffts_scratch_size(p);
+		void *scratch = valloc(ssize + 1);
+		memset(scratch, 0x55, ssize + 1);
+		ffts_execute(p, input, output);
+		err = max_error_d(2*nout, output, y);
+		ffts_execute_scratch(p, input, output, scratch);
+		float e = max_error_d(2*nout, output, y);
+		if(e > err) err = e;
+		free(scratch);
+		ffts_free(p);
+	}
+	if(err > 1e-5f) {
+		printf(" %3d  | %9d | %spruned %d in, %d out: %E\n", sign, n, real ? "real " : "",
+		       nin, nout, err);
+	}
+
+	free(input);
+	free(x);
+	free(output);
+	free(y);
+	return err > 1e-5f;
+}
+
+/*
+ * ffts_init_1d at sizes that aren't powers of two, mixed radix for
+ * 2^a 3^b 5^c 7^d and Bluestein otherwise, against the DFT. Returns the
+ * number of failures.
+ */
+int
+test_dft(int n, int sign) {
+	float *input = valloc(2 * n * sizeof(float));
+	float *output = valloc(2 * n * sizeof(float));
+	double *y = malloc(2 * n * sizeof(double));
+	float err = 1.0f;
+	int i;
+
+	for(i=0;i<2*n;i++) input[i] = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+	dft_reference(n, sign, input, 1, y);
+
+	ffts_plan_t *p = ffts_init_1d(n, sign);
+	if(p) {
+		ffts_execute(p, input, output);
+		err = max_error_d(2*n, output, y);
+		ffts_free(p);
+	}
+	if(err > 1e-5f) printf(" %3d  | %9d | %E\n", sign, n, err);
+
+	free(input);
+	free(output);
+	free(y);
+	return err > 1e-5f;
+}
+
+// the DFT of a row-major Ns[0] x ... x Ns[rank-1] array of complex doubles,
+// one dimension at a time, by definition, in place
+void dft_nd_reference(int rank, const size_t *Ns, int sign, double *x) {
+	size_t vol = 1, stride = 1;
+	int d;
+	for(d=0;d<rank;d++) vol *= Ns[d];
+	for(d=rank-1;d>=0;d--) {
+		size_t n = Ns[d], i, j, k;
+		double *w = malloc(2 * n * sizeof(double));
+		double *t = malloc(2 * n * sizeof(double));
+		for(k=0;k<n;k++) {
+			w[2*k]   = cos(2.0 * PI * (double)k / (double)n);
+			w[2*k+1] = sign * sin(2.0 * PI * (double)k / (double)n);
+		}
+		for(i=0;i<vol;i++) {
+			if((i / stride) % n) continue;
+			double *line = x + 2 * i;
+			for(k=0;k<n;k++) {
+				double re = 0.0, im = 0.0;
+				for(j=0;j<n;j++) {
+					const double *a = w + 2 * ((j * k) % n);
+					re += line[2*j*stride] * a[0] - line[2*j*stride+1] * a[1];
+					im += line[2*j*stride] * a[1] + line[2*j*stride+1] * a[0];
+				}
+				t[2*k]   = re;
+				t[2*k+1] = im;
+			}
+			for(k=0;k<n;k++) {
+				line[2*k*stride]   = t[2*k];
+				line[2*k*stride+1] = t[2*k+1];
+			}
+		}
+		stride *= n;
+		free(w);
+		free(t);
+	}
+}
+
+/*
+ * Threaded N-D plans against the DFT, with ffts_init_2d_threaded for rank
+ * 2. Returns the number of failures.
+ */
+int
+test_threaded(int rank, size_t *Ns, int sign, int nthreads) {
+	size_t vol = 1, i;
+	int d;
+	for(d=0;d<rank;d++) vol *= Ns[d];
+
+	float *input = valloc(2 * vol * sizeof(float));
+	float *output = valloc(2 * vol * sizeof(float));
+	double *y = malloc(2 * vol * sizeof(double));
+	float err = 1.0f;
+
+	for(i=0;i<2*vol;i++) {
+		input[i] = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+		y[i] = input[i];
+	}
+	dft_nd_reference(rank, Ns, sign, y);
+
+	ffts_plan_t *p = rank == 2 ? ffts_init_2d_threaded(Ns[0], Ns[1], sign, nthreads)
+	                           : ffts_init_nd_threaded(rank, Ns, sign, nthreads);
+	if(p) {
+		ffts_execute(p, input, output);
+		err = max_error_d(2*vol, output, y);
+		ffts_free(p);
+	}
+	if(err > 1e-5f) {
+		printf(" %3d  | %9zu | %d-d threaded, %d threads: %E\n", sign, vol, rank, nthreads, err);
+	}
+
+	free(input);
+	free(output);
+	free(y);
+	return err > 1e-5f;
+}
+
+// largest difference between x and y, relative to the largest element of y
+double max_error_dd(size_t n, const double *x, const double *y) {
+	double d = 0.0, m = 0.0;
+	size_t i;
+	for(i=0;i<n;i++) {
+		if(fabs(x[i] - y[i]) > d) d = fabs(x[i] - y[i]);
+		if(fabs(y[i]) > m) m = fabs(y[i]);
+	}
+	return m > 0.0 ? d / m : d;
+}
+
+/*
+ * Double precision 1D plans against the DFT. With real set, the forwards
+ * real plan is checked against the first n/2+1 outputs of the DFT of real
+ * input, and the backwards one must turn those back into n times the
+ * input. Returns the number of failures.
+ */
+int
+test_double(int n, int sign, int real) {
+	double *input = valloc(2 * n * sizeof(double));
+	double *output = valloc(2 * n * sizeof(double));
+	double *y = malloc(2 * n * sizeof(double));
+	double err = 1.0;
+	size_t N = n;
+	int i;
+
+	for(i=0;i<2*n;i++) input[i] = (double)((i * 7919) % 1024) / 512.0 - 1.0;
+	if(real) {
+		for(i=0;i<n;i++) {
+			y[2*i]   = input[i];
+			y[2*i+1] = 0.0;
+		}
+		dft_nd_reference(1, &N, -1, y);
+	}else{
+		memcpy(y, input, 2 * n * sizeof(double));
+		dft_nd_reference(1, &N, sign, y);
+	}
+
+	ffts_plan_t *p = real ? ffts_init_1d_real_d(n, sign) : ffts_init_1d_d(n, sign);
+	if(p) {
+		if(!real) {
+			ffts_execute(p, input, output);
+			err = max_error_dd(2*n, output, y);
+		}else if(sign < 0) {
+			ffts_execute(p, input, output);
+			err = max_error_dd(n + 2, output, y);
+		}else{
+			ffts_execute(p, y, output);
+			for(i=0;i<n;i++) y[i] = n * input[i];
+			err = max_error_dd(n, output, y);
+		}
+		ffts_free(p);
+	}
+	if(err > 1e-12) {
+		printf(" %3d  | %9d | double%s: %E\n", sign, n, real ? " real" : "", err);
+	}
+
+	free(input);
+	free(output);
+	free(y);
+	return err > 1e-12;
+}
+
+/*
+ * Real 1D plans against the DFT: forwards must give the first n/2+1
+ * outputs of the DFT of real input, and backwards must turn those back
+ * into n times the input. Returns the number of failures.
+ */
+int
+test_real(int n, int sign) {
+	float *input = valloc((n + 2) * sizeof(float));
+	float *output = valloc((n + 2) * sizeof(float));
+	float *x = valloc(2 * n * sizeof(float));
+	double *y = malloc(2 * n * sizeof(double));
+	float err = 1.0f;
+	int i;
+
+	for(i=0;i<n;i++) {
+		x[2*i]   = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+		x[2*i+1] = 0.0f;
+	}
+	dft_reference(n, -1, x, 1, y);
+	if(sign < 0) {
+		for(i=0;i<n;i++) input[i] = x[2*i];
+	}else{
+		for(i=0;i<n+2;i++) input[i] = y[i];
+		for(i=0;i<n;i++) y[i] = n * x[2*i];
+	}
+
+	ffts_plan_t *p = ffts_init_1d_real(n, sign);
+	if(p) {
+		ffts_execute(p, input, output);
+		err = max_error_d(sign < 0 ? n + 2 : n, output, y);
+		ffts_free(p);
+	}
+	if(err > 1e-5f) printf(" %3d  | %9d | real: %E\n", sign, n, err);
+
+	free(input);
+	free(output);
+	free(x);
+	free(y);
+	return err > 1e-5f;
+}
+
+/*
+ * In-place plans against the DFT, with the output overwriting the input
+ * and, through the copy, into a separate buffer. Returns the number of
+ * failures.
+ */
+int
+test_inplace(int rank, size_t *Ns, int sign) {
+	size_t vol = 1, i;
+	int d;
+	for(d=0;d<rank;d++) vol *= Ns[d];
+
+	float *input = valloc(2 * vol * sizeof(float));
+	float *data = valloc(2 * vol * sizeof(float));
+	double *y = malloc(2 * vol * sizeof(double));
+	float err = 1.0f;
+
+	for(i=0;i<2*vol;i++) {
+		input[i] = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+		y[i] = input[i];
+	}
+	dft_nd_reference(rank, Ns, sign, y);
+
+	ffts_plan_t *p = rank == 1 ? ffts_init_1d_inplace(Ns[0], sign)
+	               : rank == 2 ? ffts_init_2d_inplace(Ns[0], Ns[1], sign)
+	                           : ffts_init_nd_inplace(rank, Ns, sign);
+	if(p) {
+		memcpy(data, input, 2 * vol * sizeof(float));
+		ffts_execute(p, data, data);
+		err = max_error_d(2*vol, data, y);
+		ffts_execute(p, input, data);
+		float e = max_error_d(2*vol, data, y);
+		if(e > err) err = e;
+		ffts_free(p);
+	}
+	if(err > 1e-5f) printf(" %3d  | %9zu | %d-d in-place: %E\n", sign, vol, rank, err);
+
+	free(input);
+	free(data);
+	free(y);
+	return err > 1e-5f;
+}
+
+/*
+ * Buffers at every offset of up to three elements from alignment, for
+ * complex 1D (kind 0), real 1D (1, forwards only), n x 8 2D (2) and
+ * double 1D (3) plans, against the DFT. Returns the number of failures.
+ */
+int
+test_unaligned(int n, int sign, int kind) {
+	size_t vol = kind == 2 ? 8 * n : n;
+	size_t Ns[2] = { n, 8 };
+	float *x = valloc(2 * vol * sizeof(float));
+	float *in = valloc((2 * vol + 4) * sizeof(double));
+	float *out = valloc((2 * vol + 4) * sizeof(double));
+	double *y = malloc(2 * vol * sizeof(double));
+	size_t i;
+	int oi, oo, fails = 0;
+
+	for(i=0;i<2*vol;i++) {
+		x[i] = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+		if(kind == 1 && (i & 1)) x[i] = 0.0f;
+		y[i] = x[i];
+	}
+	if(kind == 2) dft_nd_reference(2, Ns, sign, y);
+	else          dft_nd_reference(1, Ns, sign, y);
+
+	ffts_plan_t *p = kind == 0 ? ffts_init_1d(n, sign)
+	               : kind == 1 ? ffts_init_1d_real(n, sign)
+	               : kind == 2 ? ffts_init_2d(n, 8, sign)
+	                           : ffts_init_1d_d(n, sign);
+	for(oi=0;oi<4;oi++) {
+		for(oo=0;oo<4;oo++) {
+			float err = 1.0f;
+			if(p && kind == 3) {
+				double *din = (double *)in + oi, *dout = (double *)out + oo;
+				for(i=0;i<2*vol;i++) din[i] = x[i];
+				ffts_execute(p, din, dout);
+				err = max_error_dd(2*vol, dout, y);
+			}else if(p) {
+				for(i=0;i<vol;i++) {
+					if(kind == 1) in[oi+i] = x[2*i];
+					else {
+						in[oi+2*i]   = x[2*i];
+						in[oi+2*i+1] = x[2*i+1];
+					}
+				}
+				ffts_execute(p, in + oi, out + oo);
+				err = max_error_d(kind == 1 ? vol + 2 : 2*vol, out + oo, y);
+			}
+			if(err > 1e-5f) {
+				printf(" %3d  | %9zu | kind %d, in +%d, out +%d: %E\n", sign, vol, kind, oi, oo, err);
+				fails++;
+			}
+		}
+	}
+	if(p) ffts_free(p);
+
+	free(x);
+	free(in);
+	free(out);
+	free(y);
+	return fails;
+}
+
+/*
+ * Real N-D plans against the DFT: forwards must give the first
+ * Ns[rank-1]/2+1 outputs of each row of the DFT of real input, and
+ * backwards must turn those back into the input times its size, with
+ * ffts_init_2d_real for rank 2. Returns the number of failures.
+ */
+int
+test_real_nd(int rank, size_t *Ns, int sign) {
+	size_t vol = 1, n = Ns[rank-1], m = n/2 + 1, i, j;
+	int d;
+	for(d=0;d<rank;d++) vol *= Ns[d];
+
+	float *input = valloc(2 * vol * sizeof(float));
+	float *output = valloc(2 * vol * sizeof(float));
+	float *x = malloc(vol * sizeof(float));
+	double *y = malloc(2 * vol * sizeof(double));
+	double *half = malloc(2 * (vol / n) * m * sizeof(double));
+	float err = 1.0f;
+
+	for(i=0;i<vol;i++) {
+		x[i] = (float)((i * 7919) % 1024) / 512.0f - 1.0f;
+		y[2*i]   = x[i];
+		y[2*i+1] = 0.0;
+	}
+	dft_nd_reference(rank, Ns, -1, y);
+	for(i=0;i<vol/n;i++) {
+		for(j=0;j<2*m;j++) half[2*m*i + j] = y[2*n*i + j];
+	}
+	if(sign < 0) {
+		for(i=0;i<vol;i++) input[i] = x[i];
+	}else{
+		for(i=0;i<2*(vol/n)*m;i++) input[i] = half[i];
+		for(i=0;i<vol;i++) half[i] = (double)vol * x[i];
+	}
+
+	ffts_plan_t *p = rank == 2 ? ffts_init_2d_real(Ns[0], Ns[1], sign)
+	                           : ffts_init_nd_real(rank, Ns, sign);
+	if(p) {
+		ffts_execute(p, input, output);
+		err = max_error_d(sign < 0 ? 2*(vol/n)*m : vol, output, half);
+		ffts_free(p);
+	}
+	if(err > 1e-5f) printf(" %3d  | %9zu | %d-d real: %E\n", sign, vol, rank, err);
+
+	free(input);
+	free(output);
+	free(x);
+	free(y);
+	free(half);
+	return err > 1e-5f;
+}
+
+/*
+ * Double precision N-D plans against the DFT, with ffts_init_2d_d for rank
+ * 2. Returns the number of failures.
+ */
+int
+test_double_nd(int rank, size_t *Ns, int sign) {
+	size_t vol = 1, i;
+	int d;
+	for(d=0;d<rank;d++) vol *= Ns[d];
+
+	double *input = valloc(2 * vol * sizeof(double));
+	double *output = valloc(2 * vol * sizeof(double));
+	double *y = malloc(2 * vol * sizeof(double));
+	double err = 1.0;
+
+	for(i=0;i<2*vol;i++) {
+		input[i] = (double)((i * 7919) % 1024) / 512.0 - 1.0;
+		y[i] = input[i];
+	}
+	dft_nd_reference(rank, Ns, sign, y);
+
+	ffts_plan_t *p = rank == 2 ? ffts_init_2d_d(Ns[0], Ns[1], sign)
+	                           : ffts_init_nd_d(rank, Ns, sign);
+	if(p) {
+		ffts_execute(p, input, output);
+		err = max_error_dd(2*vol, output, y);
+		ffts_free(p);
+	}
+	if(err > 1e-12) printf(" %3d  | %9zu | %d-d double: %E\n", sign, vol, rank, err);
+
+	free(input);
+	free(output);
+	free(y);
+	return err > 1e-12;
+}
+
 int
 main(int argc, char *argv[]) {
 	
@@ -171,6 +1102,151 @@ main(int argc, char *argv[]) {
 		for(n=1;n<=18;n++) {
 			test_transform(pow(2,n), 1);
 		}
+
+		// batches, including the vector lane kernels for n <= 32
+		int fails = 0, sign;
+		for(sign=-1;sign<=1;sign+=2) {
+			for(n=0;n<=6;n++) {
+				fails += test_batch(1 << n, sign, 3);
+				fails += test_batch(1 << n, sign, 8);
+				fails += test_batch(1 << n, sign, 13);
+			}
+		}
+
+		// streaming filters
+		fails += test_conv(1, 8);
+		fails += test_conv(100, 16);
+		fails += test_conv(1000, 64);
+
+		// STFT
+		for(n=3;n<=10;n++) fails += test_stft(1 << n, 1 << (n - 2));
+
+		// saved plans
+		for(sign=-1;sign<=1;sign+=2) {
+			for(n=3;n<=16;n+=3) fails += test_wisdom(1 << n, sign);
+		}
+
+		// reentrant execution
+		fails += test_scratch(ffts_init_2d(64, 48, -1), 64*48, "2d");
+		fails += test_scratch(ffts_init_1d_sixstep(1 << 16, -1), 1 << 16, "six-step");
+		fails += test_scratch(ffts_init_1d_batch(16, 1, 20, 20, 1, 1, 16), 16*20, "batch");
+
+		// arenas
+		for(sign=-1;sign<=1;sign+=2) {
+			for(n=3;n<=16;n+=3) fails += test_arena(1 << n, sign);
+		}
+
+		// DCTs and DSTs
+		for(sign=-1;sign<=1;sign+=2) {
+			size_t dct_sizes[] = { 4, 6, 8, 12, 16, 100, 256, 1024 };
+			size_t dct_2d[][2] = { {8, 8}, {4, 6}, {16, 32}, {24, 64}, {64, 16} };
+			for(n=0;n<8;n++) {
+				fails += test_dct(0, sign, 1, dct_sizes[n], 1);
+				fails += test_dct(1, sign, 1, dct_sizes[n], 1);
+			}
+			for(n=0;n<5;n++) fails += test_dct(2, sign, dct_2d[n][0], dct_2d[n][1], 1);
+			fails += test_dct(3, sign, 8, 8, 5);
+			fails += test_dct(3, sign, 16, 16, 3);
+		}
+
+		// generated code after a fork
+		fails += test_fork(1024, -1);
+		fails += test_fork(64, 1);
+
+		// split format
+		for(sign=-1;sign<=1;sign+=2) {
+			for(n=1;n<=10;n++) {
+				fails += test_split(1 << n, sign);
+				fails += test_split(3 * n + 2, sign);
+			}
+		}
+
+		// pruned transforms, each way round and both
+		for(sign=-1;sign<=1;sign+=2) {
+			for(n=3;n<=12;n+=3) {
+				int N = 1 << n;
+				fails += test_pruned(N, sign, N/8 + 1, 0, 0);
+				fails += test_pruned(N, sign, 0, N/8 + 1, 0);
+				fails += test_pruned(N, sign, N/4, N/16 + 3, 0);
+				fails += test_pruned(N, sign, 0, 0, 0);
+				if(N >= 16) fails += test_pruned(N, -1, N/8 + 3, 0, 1);
+			}
+		}
+		if(ffts_init_1d_pruned(4, -1, 1, 0) || ffts_init_1d_real_pruned(8, 1)) {
+			printf("      |           | pruned plans below the minimum sizes\n");
+			fails++;
+		}
+
+		// sizes that aren't powers of two
+		for(sign=-1;sign<=1;sign+=2) {
+			int dft_sizes[] = { 3, 5, 6, 7, 9, 12, 15, 20, 21, 35, 45, 63, 96, 100, 105, 210, 1000, 2744,
+			                    11, 13, 17, 22, 97, 127, 331, 1009, 2310 };
+			for(n=0;n<27;n++) fails += test_dft(dft_sizes[n], sign);
+		}
+
+		// threaded N-D transforms
+		for(sign=-1;sign<=1;sign+=2) {
+			size_t nd_sizes[][3] = { {16, 32, 0}, {64, 8, 0}, {12, 20, 0}, {8, 4, 16}, {4, 6, 10} };
+			for(n=0;n<5;n++) {
+				int rank = nd_sizes[n][2] ? 3 : 2;
+				fails += test_threaded(rank, nd_sizes[n], sign, 1);
+				fails += test_threaded(rank, nd_sizes[n], sign, 3);
+				fails += test_threaded(rank, nd_sizes[n], sign, 0);
+			}
+		}
+
+		// double precision
+		for(sign=-1;sign<=1;sign+=2) {
+			for(n=1;n<=12;n++) {
+				fails += test_double(1 << n, sign, 0);
+				if(n >= 2) fails += test_double(1 << n, sign, 1);
+			}
+		}
+
+		// real transforms, with the recombination tails at the odd sizes
+		for(sign=-1;sign<=1;sign+=2) {
+			int real_sizes[] = { 6, 10, 14, 18, 24, 30, 40, 42, 90, 200, 2002 };
+			for(n=2;n<=12;n++) fails += test_real(1 << n, sign);
+			for(n=0;n<11;n++) fails += test_real(real_sizes[n], sign);
+		}
+
+		// in-place transforms
+		for(sign=-1;sign<=1;sign+=2) {
+			size_t inplace_2d[][3] = { {32, 32, 0}, {16, 64, 0}, {24, 10, 0}, {4, 8, 16}, {6, 5, 8} };
+			for(n=1;n<=12;n++) {
+				size_t N = 1 << n;
+				fails += test_inplace(1, &N, sign);
+			}
+			for(n=0;n<5;n++) fails += test_inplace(inplace_2d[n][2] ? 3 : 2, inplace_2d[n], sign);
+		}
+
+		// unaligned buffers
+		for(sign=-1;sign<=1;sign+=2) {
+			int unaligned_sizes[] = { 2, 4, 8, 16, 32, 64, 256, 4096, 12, 100, 17 };
+			for(n=0;n<11;n++) {
+				fails += test_unaligned(unaligned_sizes[n], sign, 0);
+				if(unaligned_sizes[n] < 4096) fails += test_unaligned(unaligned_sizes[n], sign, 2);
+			}
+			for(n=2;n<=12;n+=2) {
+				if(sign < 0) fails += test_unaligned(1 << n, sign, 1);
+				fails += test_unaligned(1 << n, sign, 3);
+			}
+		}
+
+		// real N-D transforms
+		for(sign=-1;sign<=1;sign+=2) {
+			size_t real_nd[][3] = { {16, 32, 0}, {64, 8, 0}, {12, 20, 0}, {5, 6, 0}, {4, 8, 16}, {6, 10, 8} };
+			for(n=0;n<6;n++) fails += test_real_nd(real_nd[n][2] ? 3 : 2, real_nd[n], sign);
+		}
+
+		// double precision N-D transforms
+		for(sign=-1;sign<=1;sign+=2) {
+			size_t double_nd[][3] = { {16, 32, 0}, {64, 2, 0}, {2, 128, 0}, {8, 4, 16}, {32, 1, 8} };
+			for(n=0;n<5;n++) fails += test_double_nd(double_nd[n][2] ? 3 : 2, double_nd[n], sign);
+		}
+
+		printf("%s: %d failures\n", fails ? "FAIL" : "PASS", fails);
+		return fails != 0;
 	}
   return 0;
 }